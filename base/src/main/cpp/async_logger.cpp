@@ -0,0 +1,381 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/async_logger.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <initializer_list>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/format_logging.h"
+#include "base/macros.h"
+
+namespace ndksamples::base {
+
+namespace {
+
+// The queue is a ring of fixed size slots, each with a sequence number that
+// says who owns it (see Dmitry Vyukov's bounded MPMC queue). A message takes up
+// as many consecutive slots as it needs. A slot at position p in the ring is
+// free for a producer when its sequence is p, holds a message for the consumer
+// when it is p + 1, and is free for the next lap once the consumer sets it to
+// p + the number of slots.
+constexpr size_t kSlotSize = 128;
+
+struct alignas(kSlotSize) Slot {
+  std::atomic<uint64_t> sequence;
+  char data[kSlotSize - sizeof(std::atomic<uint64_t>)];
+};
+
+constexpr size_t kSlotDataSize = sizeof(Slot::data);
+
+enum class RecordType : uint8_t {
+  kMessage,
+  // A LOGF message, which is formatted by the background thread.
+  kFormatted,
+  // Stops the background thread once everything before it has been written.
+  kStop,
+};
+
+// The start of each record, which continues into the next slots as needed.
+// For kMessage, the tag, file and message follow as null terminated strings.
+// For kFormatted, a log_detail::FormatRecord and the encoded arguments follow.
+struct RecordHeader {
+  uint32_t slots;
+  uint32_t size;
+  RecordType type;
+  LogId id;
+  LogSeverity severity;
+  unsigned int line;
+  uint32_t tag_size;
+  uint32_t file_size;
+};
+
+// Part of the data of a record.
+struct Chunk {
+  const void* data;
+  size_t size;
+};
+
+}  // namespace
+
+class AsyncLogger::Queue {
+ public:
+  Queue(LogFunction&& sink, const AsyncLoggerOptions& options)
+      : sink_(std::move(sink)),
+        overflow_policy_(options.overflow_policy),
+        capacity_(std::bit_ceil(
+            std::max<size_t>(options.queue_size / kSlotSize, 2))),
+        slots_(new Slot[capacity_]) {
+    for (uint64_t i = 0; i < capacity_; i++) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    thread_ = std::thread(&Queue::Run, this);
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(Queue);
+
+  ~Queue() {
+    RecordHeader header = {};
+    header.type = RecordType::kStop;
+    header.size = sizeof(header);
+    Push(header, {}, /*must_deliver=*/true);
+    thread_.join();
+  }
+
+  void Log(LogId id, LogSeverity severity, const char* tag, const char* file,
+           unsigned int line, const char* message) {
+    // The background thread can't wait for itself.
+    if (std::this_thread::get_id() == thread_.get_id()) {
+      sink_(id, severity, tag, file, line, message);
+      return;
+    }
+
+    if (tag == nullptr) tag = "";
+    if (file == nullptr) file = "";
+    if (message == nullptr) message = "";
+
+    RecordHeader header = {};
+    header.type = RecordType::kMessage;
+    header.id = id;
+    header.severity = severity;
+    header.line = line;
+
+    // Truncate anything that wouldn't fit in the queue, even when empty.
+    const size_t max_size = MaxRecordSize() - sizeof(header);
+    const size_t tag_size = std::min(strlen(tag) + 1, max_size / 4);
+    const size_t file_size = std::min(strlen(file) + 1, max_size / 4);
+    const size_t message_size =
+        std::min(strlen(message) + 1, max_size - tag_size - file_size);
+    header.tag_size = tag_size;
+    header.file_size = file_size;
+    header.size = sizeof(header) + tag_size + file_size + message_size;
+
+    const bool fatal = severity >= FATAL_WITHOUT_ABORT;
+    const bool must_deliver =
+        fatal || overflow_policy_ == OverflowPolicy::kBlock;
+    // The last byte of each string is replaced with a terminator, in case it
+    // was truncated.
+    const bool pushed = Push(header,
+                             {
+                                 {tag, tag_size - 1},
+                                 {"", 1},
+                                 {file, file_size - 1},
+                                 {"", 1},
+                                 {message, message_size - 1},
+                                 {"", 1},
+                             },
+                             must_deliver);
+    if (pushed && fatal) {
+      Flush();
+    }
+  }
+
+  bool LogFormatted(LogSeverity severity,
+                    const log_detail::FormatRecord& record,
+                    const std::byte* args, size_t size) {
+    if (std::this_thread::get_id() == thread_.get_id()) return false;
+
+    RecordHeader header = {};
+    header.type = RecordType::kFormatted;
+    header.severity = severity;
+    header.size = sizeof(header) + sizeof(record) + size;
+    if (header.size > MaxRecordSize()) return false;
+
+    Push(header, {{&record, sizeof(record)}, {args, size}},
+         overflow_policy_ == OverflowPolicy::kBlock);
+    return true;
+  }
+
+  void Flush() {
+    if (std::this_thread::get_id() == thread_.get_id()) return;
+
+    const uint64_t target = enqueue_position_.load(std::memory_order_relaxed);
+    uint64_t written;
+    while ((written = written_position_.load(std::memory_order_seq_cst)) <
+           target) {
+      WaitForWrite(written);
+    }
+  }
+
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  size_t MaxRecordSize() const { return capacity_ * kSlotDataSize; }
+
+  Slot& SlotAt(uint64_t position) {
+    return slots_[position & (capacity_ - 1)];
+  }
+
+  // Copies size bytes to the records' data, starting offset bytes into the
+  // record at position.
+  void CopyIn(uint64_t position, size_t offset, const void* data,
+              size_t size) {
+    const char* in = static_cast<const char*>(data);
+    while (size > 0) {
+      Slot& slot = SlotAt(position + offset / kSlotDataSize);
+      const size_t slot_offset = offset % kSlotDataSize;
+      const size_t n = std::min(size, kSlotDataSize - slot_offset);
+      memcpy(slot.data + slot_offset, in, n);
+      in += n;
+      offset += n;
+      size -= n;
+    }
+  }
+
+  void CopyOut(uint64_t position, size_t offset, void* data, size_t size) {
+    char* out = static_cast<char*>(data);
+    while (size > 0) {
+      Slot& slot = SlotAt(position + offset / kSlotDataSize);
+      const size_t slot_offset = offset % kSlotDataSize;
+      const size_t n = std::min(size, kSlotDataSize - slot_offset);
+      memcpy(out, slot.data + slot_offset, n);
+      out += n;
+      offset += n;
+      size -= n;
+    }
+  }
+
+  // Claims count consecutive slots for a producer, returning false if they
+  // aren't all free.
+  bool TryClaim(uint32_t count, uint64_t* position) {
+    uint64_t start = enqueue_position_.load(std::memory_order_relaxed);
+    while (true) {
+      // The consumer frees slots in order, so if the last slot is free then so
+      // are all the others.
+      const uint64_t last = start + count - 1;
+      const uint64_t sequence =
+          SlotAt(last).sequence.load(std::memory_order_acquire);
+      if (sequence == last) {
+        if (enqueue_position_.compare_exchange_weak(
+                start, start + count, std::memory_order_relaxed)) {
+          *position = start;
+          return true;
+        }
+      } else if (sequence < last) {
+        return false;
+      } else {
+        start = enqueue_position_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Waits until written_position_ is no longer written.
+  void WaitForWrite(uint64_t written) {
+    waiters_.fetch_add(1, std::memory_order_seq_cst);
+    written_position_.wait(written, std::memory_order_seq_cst);
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  // Adds a record of header.size bytes to the queue: the header followed by
+  // the chunks. Waits for room if must_deliver is true, and otherwise returns
+  // false if the record was dropped.
+  bool Push(RecordHeader header, std::initializer_list<Chunk> chunks,
+            bool must_deliver) {
+    header.slots = (header.size + kSlotDataSize - 1) / kSlotDataSize;
+
+    uint64_t position;
+    if (!TryClaim(header.slots, &position)) {
+      if (!must_deliver) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      uint64_t written = written_position_.load(std::memory_order_seq_cst);
+      while (!TryClaim(header.slots, &position)) {
+        WaitForWrite(written);
+        written = written_position_.load(std::memory_order_seq_cst);
+      }
+    }
+
+    CopyIn(position, 0, &header, sizeof(header));
+    size_t offset = sizeof(header);
+    for (const Chunk& chunk : chunks) {
+      CopyIn(position, offset, chunk.data, chunk.size);
+      offset += chunk.size;
+    }
+
+    // Publish the first slot last, since that's the one the consumer waits on.
+    for (uint64_t i = header.slots - 1; i > 0; i--) {
+      SlotAt(position + i).sequence.store(position + i + 1,
+                                          std::memory_order_release);
+    }
+    Slot& first = SlotAt(position);
+    first.sequence.store(position + 1, std::memory_order_seq_cst);
+    if (consumer_waiting_.load(std::memory_order_seq_cst)) {
+      first.sequence.notify_one();
+    }
+    return true;
+  }
+
+  // The background thread.
+  void Run() {
+    std::vector<char> record;
+    std::string formatted;
+    uint64_t position = 0;
+    while (true) {
+      Slot& first = SlotAt(position);
+      uint64_t sequence = first.sequence.load(std::memory_order_acquire);
+      if (sequence != position + 1) {
+        consumer_waiting_.store(true, std::memory_order_seq_cst);
+        while ((sequence = first.sequence.load(std::memory_order_seq_cst)) !=
+               position + 1) {
+          first.sequence.wait(sequence, std::memory_order_seq_cst);
+        }
+        consumer_waiting_.store(false, std::memory_order_relaxed);
+      }
+
+      RecordHeader header;
+      CopyOut(position, 0, &header, sizeof(header));
+      record.resize(header.size);
+      CopyOut(position, 0, record.data(), header.size);
+
+      // Free the slots before writing, so producers can reuse them while the
+      // sink is busy.
+      for (uint64_t i = 0; i < header.slots; i++) {
+        SlotAt(position + i).sequence.store(position + i + capacity_,
+                                            std::memory_order_release);
+      }
+
+      if (header.type == RecordType::kMessage) {
+        const char* tag = record.data() + sizeof(header);
+        const char* file = tag + header.tag_size;
+        const char* message = file + header.file_size;
+        sink_(header.id, header.severity, tag, file, header.line, message);
+      } else if (header.type == RecordType::kFormatted) {
+        log_detail::FormatRecord format;
+        memcpy(&format, record.data() + sizeof(header), sizeof(format));
+        formatted.clear();
+        format.format_args(format.format,
+                           reinterpret_cast<const std::byte*>(record.data()) +
+                               sizeof(header) + sizeof(format),
+                           &formatted);
+        // LogLine finds the default tag if there isn't one, and then passes
+        // the message back to this thread's Log, which writes it to the sink.
+        LogMessage::LogLine(format.file, format.line, header.severity,
+                            format.tag, formatted.c_str());
+      }
+
+      position += header.slots;
+      written_position_.store(position, std::memory_order_seq_cst);
+      if (waiters_.load(std::memory_order_seq_cst) > 0) {
+        written_position_.notify_all();
+      }
+
+      if (header.type == RecordType::kStop) return;
+    }
+  }
+
+  const LogFunction sink_;
+  const OverflowPolicy overflow_policy_;
+  const uint64_t capacity_;
+  const std::unique_ptr<Slot[]> slots_;
+  std::thread thread_;
+
+  // Producers and the consumer each get their own cache line.
+  alignas(kSlotSize) std::atomic<uint64_t> enqueue_position_ = 0;
+  std::atomic<uint64_t> dropped_ = 0;
+
+  alignas(kSlotSize) std::atomic<uint64_t> written_position_ = 0;
+  std::atomic<bool> consumer_waiting_ = false;
+  std::atomic<uint32_t> waiters_ = 0;
+};
+
+AsyncLogger::AsyncLogger(LogFunction&& sink, const AsyncLoggerOptions& options)
+    : queue_(std::make_shared<Queue>(std::move(sink), options)) {}
+
+void AsyncLogger::operator()(LogId id, LogSeverity severity, const char* tag,
+                             const char* file, unsigned int line,
+                             const char* message) {
+  queue_->Log(id, severity, tag, file, line, message);
+}
+
+bool AsyncLogger::LogFormatted(LogSeverity severity,
+                               const log_detail::FormatRecord& record,
+                               const std::byte* args, size_t size) {
+  return queue_->LogFormatted(severity, record, args, size);
+}
+
+void AsyncLogger::Flush() { queue_->Flush(); }
+
+uint64_t AsyncLogger::dropped() const { return queue_->dropped(); }
+
+}  // namespace ndksamples::base
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/async_logger.h"
+
+#include <gtest/gtest.h>
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ndksamples::base {
+namespace {
+
+struct Record {
+  LogId id;
+  LogSeverity severity;
+  std::string tag;
+  std::string file;
+  unsigned int line;
+  std::string message;
+};
+
+// A sink that keeps every message it's passed. It's shared with the test,
+// since the AsyncLogger takes ownership of the LogFunction.
+class RecordingSink {
+ public:
+  LogFunction AsLogFunction() {
+    return [this](LogId id, LogSeverity severity, const char* tag,
+                  const char* file, unsigned int line, const char* message) {
+      Write(id, severity, tag, file, line, message);
+    };
+  }
+
+  std::vector<Record> records() {
+    std::lock_guard lock(mutex_);
+    return records_;
+  }
+
+ protected:
+  virtual void Write(LogId id, LogSeverity severity, const char* tag,
+                     const char* file, unsigned int line,
+                     const char* message) {
+    std::lock_guard lock(mutex_);
+    records_.push_back({id, severity, tag, file, line, message});
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<Record> records_;
+};
+
+// A RecordingSink that doesn't return from the first message it's passed until
+// Release is called, which keeps the queue from draining.
+class BlockingSink : public RecordingSink {
+ public:
+  BlockingSink() : released_(release_.get_future().share()) {}
+
+  // Waits until the background thread is blocked in the sink.
+  void WaitUntilBlocked() { blocked_.get_future().wait(); }
+
+  void Release() { release_.set_value(); }
+
+ protected:
+  void Write(LogId id, LogSeverity severity, const char* tag, const char* file,
+             unsigned int line, const char* message) override {
+    RecordingSink::Write(id, severity, tag, file, line, message);
+    if (first_) {
+      first_ = false;
+      blocked_.set_value();
+      released_.wait();
+    }
+  }
+
+ private:
+  // Only used by the background thread.
+  bool first_ = true;
+  std::promise<void> blocked_;
+  std::promise<void> release_;
+  std::shared_future<void> released_;
+};
+
+TEST(AsyncLoggerTest, DeliversInOrder) {
+  RecordingSink sink;
+  AsyncLogger logger(sink.AsLogFunction());
+  for (unsigned int i = 0; i < 1000; i++) {
+    logger(MAIN, i % 2 ? INFO : WARNING, "tag", "file.cpp", i,
+           std::to_string(i).c_str());
+  }
+  logger.Flush();
+
+  const std::vector<Record> records = sink.records();
+  ASSERT_EQ(records.size(), 1000U);
+  for (unsigned int i = 0; i < records.size(); i++) {
+    EXPECT_EQ(records[i].id, MAIN);
+    EXPECT_EQ(records[i].severity, i % 2 ? INFO : WARNING);
+    EXPECT_EQ(records[i].tag, "tag");
+    EXPECT_EQ(records[i].file, "file.cpp");
+    EXPECT_EQ(records[i].line, i);
+    EXPECT_EQ(records[i].message, std::to_string(i));
+  }
+  EXPECT_EQ(logger.dropped(), 0U);
+}
+
+// Every message from every thread arrives, and each thread's messages arrive in
+// the order that thread logged them. The queue is small, so the producers
+// often wait for room.
+TEST(AsyncLoggerTest, DeliversFromMultipleProducers) {
+  constexpr unsigned int kThreads = 4;
+  constexpr unsigned int kMessagesPerThread = 2000;
+  RecordingSink sink;
+  AsyncLogger logger(sink.AsLogFunction(),
+                     {.queue_size = 1024,
+                      .overflow_policy = OverflowPolicy::kBlock});
+  std::vector<std::thread> threads;
+  for (unsigned int thread = 0; thread < kThreads; thread++) {
+    threads.emplace_back([&logger, thread] {
+      const std::string tag = std::to_string(thread);
+      for (unsigned int i = 0; i < kMessagesPerThread; i++) {
+        logger(MAIN, INFO, tag.c_str(), "file.cpp", i, "message");
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  logger.Flush();
+
+  std::vector<unsigned int> next_line(kThreads);
+  for (const Record& record : sink.records()) {
+    const unsigned int thread = std::stoul(record.tag);
+    ASSERT_LT(thread, kThreads);
+    ASSERT_EQ(record.line, next_line[thread]) << "thread " << thread;
+    next_line[thread]++;
+  }
+  for (unsigned int thread = 0; thread < kThreads; thread++) {
+    EXPECT_EQ(next_line[thread], kMessagesPerThread) << "thread " << thread;
+  }
+  EXPECT_EQ(logger.dropped(), 0U);
+}
+
+// With OverflowPolicy::kDrop, messages that don't fit are counted and the rest
+// are delivered.
+TEST(AsyncLoggerTest, CountsDroppedMessages) {
+  BlockingSink sink;
+  // Two slots, each of which holds one short message.
+  AsyncLogger logger(sink.AsLogFunction(), {.queue_size = 256});
+  logger(MAIN, INFO, "tag", "file.cpp", 0, "blocks the sink");
+  sink.WaitUntilBlocked();
+
+  // The queue is empty while the sink is blocked, so exactly two of these fit.
+  for (unsigned int i = 1; i <= 10; i++) {
+    logger(MAIN, INFO, "tag", "file.cpp", i, "queued or dropped");
+  }
+  EXPECT_EQ(logger.dropped(), 8U);
+
+  sink.Release();
+  logger.Flush();
+  const std::vector<Record> records = sink.records();
+  ASSERT_EQ(records.size(), 3U);
+  EXPECT_EQ(records[0].line, 0U);
+  EXPECT_EQ(records[1].line, 1U);
+  EXPECT_EQ(records[2].line, 2U);
+}
+
+// FATAL messages are delivered even if the queue is full, and have been passed
+// to the sink by the time the call returns.
+TEST(AsyncLoggerTest, DeliversFatalWhenFull) {
+  for (LogSeverity severity : {FATAL_WITHOUT_ABORT, FATAL}) {
+    SCOPED_TRACE(severity);
+    BlockingSink sink;
+    AsyncLogger logger(sink.AsLogFunction(), {.queue_size = 256});
+    logger(MAIN, INFO, "tag", "file.cpp", 0, "blocks the sink");
+    sink.WaitUntilBlocked();
+    logger(MAIN, INFO, "tag", "file.cpp", 1, "fills the queue");
+    logger(MAIN, INFO, "tag", "file.cpp", 2, "fills the queue");
+
+    std::thread fatal([&] {
+      logger(MAIN, severity, "tag", "file.cpp", 3, "fatal");
+      // Checked before anything else can flush the queue.
+      const std::vector<Record> records = sink.records();
+      ASSERT_EQ(records.size(), 4U);
+      EXPECT_EQ(records[3].severity, severity);
+      EXPECT_EQ(records[3].message, "fatal");
+    });
+    sink.Release();
+    fatal.join();
+    EXPECT_EQ(logger.dropped(), 0U);
+  }
+}
+
+// Destroying the last copy of a logger writes everything still queued.
+TEST(AsyncLoggerTest, WritesQueuedMessagesOnDestruction) {
+  BlockingSink sink;
+  {
+    AsyncLogger logger(sink.AsLogFunction());
+    AsyncLogger copy = logger;
+    logger(MAIN, INFO, "tag", "file.cpp", 0, "blocks the sink");
+    sink.WaitUntilBlocked();
+    for (unsigned int i = 1; i < 100; i++) {
+      copy(MAIN, INFO, "tag", "file.cpp", i, "queued");
+    }
+    sink.Release();
+  }
+
+  const std::vector<Record> records = sink.records();
+  ASSERT_EQ(records.size(), 100U);
+  for (unsigned int i = 0; i < records.size(); i++) {
+    EXPECT_EQ(records[i].line, i);
+  }
+}
+
+// A message bigger than the whole queue is truncated rather than dropped.
+TEST(AsyncLoggerTest, TruncatesLongMessages) {
+  RecordingSink sink;
+  AsyncLogger logger(sink.AsLogFunction(), {.queue_size = 256});
+  const std::string message(1000, 'x');
+  logger(MAIN, INFO, "tag", "file.cpp", 0, message.c_str());
+  logger.Flush();
+
+  const std::vector<Record> records = sink.records();
+  ASSERT_EQ(records.size(), 1U);
+  EXPECT_EQ(records[0].tag, "tag");
+  EXPECT_EQ(records[0].file, "file.cpp");
+  EXPECT_FALSE(records[0].message.empty());
+  EXPECT_LT(records[0].message.size(), message.size());
+  EXPECT_TRUE(message.starts_with(records[0].message));
+}
+
+}  // namespace
+}  // namespace ndksamples::base
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/file_logger.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+
+#include "base/macros.h"
+
+namespace ndksamples::base {
+
+class FileLogger::File {
+ public:
+  File(int fd, off_t size, size_t chunk_size)
+      : fd_(fd), chunk_size_(chunk_size), size_(size) {}
+
+  ~File() {
+    if (window_ != nullptr) munmap(window_, chunk_size_);
+    // Drop the padding after the last message.
+    if (ftruncate(fd_, size_) == -1) {
+      PLOG(ERROR) << "Failed to trim the padding from the log file";
+    }
+    close(fd_);
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(File);
+
+  void Log(LogSeverity severity, const char* tag, const char* file,
+           unsigned int line, const char* message) {
+    // Everything but the copy into the file is done before taking the lock.
+    char short_header[256];
+    std::string long_header;
+    const char* format = "%s %c %s %5d %5d %s:%u] ";
+    const char severity_char = "VDIWEFF"[severity];
+    const char* timestamp = Timestamp();
+    const pid_t pid = getpid();
+    const pid_t tid = gettid();
+    tag = tag ? tag : "nullptr";
+    int size = snprintf(short_header, sizeof(short_header), format, tag,
+                        severity_char, timestamp, pid, tid, file, line);
+    if (size < 0) return;
+    const char* header = short_header;
+    if (static_cast<size_t>(size) >= sizeof(short_header)) {
+      // Only a very long tag or file name gets here.
+      long_header.resize(size);
+      snprintf(long_header.data(), size + 1, format, tag, severity_char,
+               timestamp, pid, tid, file, line);
+      header = long_header.data();
+    }
+    const size_t message_size = strlen(message);
+
+    std::lock_guard<std::mutex> lock(lock_);
+    Append(header, size);
+    Append(message, message_size);
+    Append("\n", 1);
+  }
+
+  bool Sync() {
+    // The mapped pages are in the page cache like any others, so this writes
+    // those of earlier windows too.
+    if (fdatasync(fd_) == -1) {
+      PLOG(ERROR) << "Failed to sync the log file";
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  // Copies data to the end of the file. The caller holds lock_. If the file
+  // can't grow, for example because the disk is full, the rest of the message
+  // is dropped.
+  void Append(const char* data, size_t size) {
+    while (size > 0) {
+      if (window_ == nullptr ||
+          size_ == window_offset_ + static_cast<off_t>(chunk_size_)) {
+        if (!MapWindow()) return;
+      }
+      const size_t available = window_offset_ + chunk_size_ - size_;
+      const size_t n = std::min(size, available);
+      memcpy(window_ + (size_ - window_offset_), data, n);
+      size_ += n;
+      data += n;
+      size -= n;
+    }
+  }
+
+  // Maps the chunk of the file that size_ is in, growing the file to include
+  // all of it. The caller holds lock_.
+  bool MapWindow() {
+    if (window_ != nullptr) {
+      munmap(window_, chunk_size_);
+      window_ = nullptr;
+    }
+    const off_t offset = size_ - size_ % chunk_size_;
+    // Unlike ftruncate, this allocates the disk space, so that a full disk
+    // fails here rather than with SIGBUS when writing to the mapping.
+    if (posix_fallocate(fd_, offset, chunk_size_) != 0) return false;
+    void* window = mmap(nullptr, chunk_size_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, fd_, offset);
+    if (window == MAP_FAILED) return false;
+    window_ = static_cast<char*>(window);
+    window_offset_ = offset;
+    return true;
+  }
+
+  // Returns the current time, formatted for a message. localtime_r is slow,
+  // so each thread only formats it once a second.
+  static const char* Timestamp() {
+    thread_local time_t timestamp_time = -1;
+    thread_local char timestamp[32];
+    const time_t now = time(nullptr);
+    if (now != timestamp_time) {
+      struct tm local;
+      localtime_r(&now, &local);
+      strftime(timestamp, sizeof(timestamp), "%m-%d %H:%M:%S", &local);
+      timestamp_time = now;
+    }
+    return timestamp;
+  }
+
+  const int fd_;
+  const size_t chunk_size_;
+
+  std::mutex lock_;
+  // These are guarded by lock_.
+  //
+  // The mapping of the chunk_size_ bytes of the file from window_offset_.
+  char* window_ = nullptr;
+  off_t window_offset_ = 0;
+  // The end of the last message.
+  off_t size_;
+};
+
+// Returns the size of the file without the NUL padding a crashed FileLogger
+// may have left at the end, or -1 on error.
+static off_t SizeWithoutPadding(int fd) {
+  struct stat st;
+  if (fstat(fd, &st) == -1) return -1;
+  off_t size = st.st_size;
+  char buffer[4096];
+  while (size > 0) {
+    const off_t offset = std::max<off_t>(0, size - sizeof(buffer));
+    const ssize_t n = pread(fd, buffer, size - offset, offset);
+    if (n != size - offset) return -1;
+    while (size > offset && buffer[size - offset - 1] == '\0') size--;
+    if (size > offset) break;
+  }
+  return size;
+}
+
+std::optional<FileLogger> FileLogger::Open(const char* path,
+                                           const FileLoggerOptions& options) {
+  const int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+  if (fd == -1) {
+    PLOG(ERROR) << "Failed to open " << path;
+    return std::nullopt;
+  }
+  const off_t size = SizeWithoutPadding(fd);
+  if (size == -1) {
+    PLOG(ERROR) << "Failed to read " << path;
+    close(fd);
+    return std::nullopt;
+  }
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+  const size_t chunk_size =
+      std::max<size_t>(1, (options.chunk_size + page_size - 1) / page_size) *
+      page_size;
+  return FileLogger(std::make_shared<File>(fd, size, chunk_size));
+}
+
+FileLogger::FileLogger(std::shared_ptr<File> file) : file_(std::move(file)) {}
+
+void FileLogger::operator()(LogId, LogSeverity severity, const char* tag,
+                            const char* file, unsigned int line,
+                            const char* message) {
+  file_->Log(severity, tag, file, line, message);
+}
+
+bool FileLogger::Sync() { return file_->Sync(); }
+
+}  // namespace ndksamples::base
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/file_logger.h"
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ndksamples::base {
+namespace {
+
+class FileLoggerTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    char path[] = "/tmp/file_logger_test.XXXXXX";
+    const int fd = mkstemp(path);
+    ASSERT_NE(fd, -1);
+    close(fd);
+    path_ = path;
+  }
+
+  void TearDown() override { unlink(path_.c_str()); }
+
+  std::vector<std::string> ReadLines() {
+    std::ifstream in(path_);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(in, line);) lines.push_back(line);
+    return lines;
+  }
+
+  std::string path_;
+};
+
+// Messages span several chunks, and the padding after the last one is trimmed
+// when the logger is destroyed.
+TEST_F(FileLoggerTest, WritesEveryMessage) {
+  {
+    std::optional<FileLogger> logger =
+        FileLogger::Open(path_.c_str(), {.chunk_size = 4096});
+    ASSERT_TRUE(logger.has_value());
+    for (unsigned int i = 0; i < 1000; i++) {
+      (*logger)(MAIN, INFO, "tag", "file.cpp", i,
+                ("message " + std::to_string(i)).c_str());
+    }
+  }
+
+  const std::vector<std::string> lines = ReadLines();
+  ASSERT_EQ(lines.size(), 1000U);
+  for (unsigned int i = 0; i < lines.size(); i++) {
+    EXPECT_TRUE(lines[i].starts_with("tag I ")) << lines[i];
+    std::ostringstream suffix;
+    suffix << " file.cpp:" << i << "] message " << i;
+    EXPECT_TRUE(lines[i].ends_with(suffix.str())) << lines[i];
+  }
+}
+
+// Reopening a file appends to it.
+TEST_F(FileLoggerTest, Appends) {
+  for (int i = 0; i < 2; i++) {
+    std::optional<FileLogger> logger = FileLogger::Open(path_.c_str());
+    ASSERT_TRUE(logger.has_value());
+    (*logger)(MAIN, INFO, "tag", "file.cpp", i, "message");
+  }
+
+  const std::vector<std::string> lines = ReadLines();
+  ASSERT_EQ(lines.size(), 2U);
+  EXPECT_TRUE(lines[0].ends_with("file.cpp:0] message"));
+  EXPECT_TRUE(lines[1].ends_with("file.cpp:1] message"));
+}
+
+TEST_F(FileLoggerTest, Syncs) {
+  std::optional<FileLogger> logger = FileLogger::Open(path_.c_str());
+  ASSERT_TRUE(logger.has_value());
+  (*logger)(MAIN, INFO, "tag", "file.cpp", 0, "message");
+  EXPECT_TRUE(logger->Sync());
+}
+
+}  // namespace
+}  // namespace ndksamples::base
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <base/logging.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cstddef>
+#include <memory>
+
+namespace ndksamples::base {
+
+namespace log_detail {
+struct FormatRecord;
+}
+
+// What an AsyncLogger does with a message when its queue is full.
+enum class OverflowPolicy {
+  // Discard the message. Logging never waits, which is what real-time threads
+  // such as audio callbacks need. See AsyncLogger::dropped.
+  kDrop,
+  // Wait for the background thread to make room. No message is lost, but a
+  // thread that logs faster than the sink can write will be slowed to match.
+  kBlock,
+};
+
+struct AsyncLoggerOptions {
+  // The size of the queue in bytes. Each message takes up a whole number of
+  // 128 byte slots, and anything that doesn't fit in the queue is truncated.
+  size_t queue_size = 256 * 1024;
+
+  OverflowPolicy overflow_policy = OverflowPolicy::kDrop;
+};
+
+// A LogFunction that moves the cost of writing logs off the calling thread.
+//
+// Each message is copied into a lock-free queue, and a background thread
+// passes it to another LogFunction, the sink. Logging from any number of
+// threads only contends on a single atomic, and never takes a lock or
+// allocates, so the cost to the caller is about that of a memcpy of the
+// message. Messages from each thread reach the sink in the order they were
+// logged.
+//
+// FATAL and FATAL_WITHOUT_ABORT messages are never dropped, and are passed to
+// the sink before the call returns, so the message of a LOG(FATAL) or failed
+// CHECK is written before the process aborts. Messages logged by the sink
+// itself are passed straight back to the sink, since the background thread
+// can't wait for itself.
+//
+// To send all logs through the queue:
+//
+//   SetLogger(AsyncLogger());
+//
+// Copies of an AsyncLogger share the same queue and thread, which are stopped
+// once the last copy is destroyed, after writing everything still queued.
+// SetLogger keeps its logger until the process exits, so anything still in the
+// queue at exit is lost. Call Flush first if that matters.
+class AsyncLogger {
+ public:
+#if defined(__ANDROID__)
+  explicit AsyncLogger(LogFunction&& sink = LogdLogger(),
+                       const AsyncLoggerOptions& options = {});
+#else
+  explicit AsyncLogger(LogFunction&& sink = StderrLogger,
+                       const AsyncLoggerOptions& options = {});
+#endif
+
+  void operator()(LogId, LogSeverity, const char* tag, const char* file,
+                  unsigned int line, const char* message);
+
+  // Queues a LOGF message, to be formatted by the background thread. Returns
+  // false if the caller should format and log the message itself, because it
+  // doesn't fit in the queue or was logged by the sink.
+  bool LogFormatted(LogSeverity severity,
+                    const log_detail::FormatRecord& record,
+                    const std::byte* args, size_t size);
+
+  // Waits until every message that was queued before the call has been passed
+  // to the sink.
+  void Flush();
+
+  // The number of messages discarded by OverflowPolicy::kDrop.
+  uint64_t dropped() const;
+
+ private:
+  class Queue;
+  std::shared_ptr<Queue> queue_;
+};
+
+}  // namespace ndksamples::base
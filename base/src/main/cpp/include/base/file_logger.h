@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <base/logging.h>
+#include <stddef.h>
+
+#include <memory>
+#include <optional>
+
+namespace ndksamples::base {
+
+struct FileLoggerOptions {
+  // How much the file grows by at a time, and the size of the window of it
+  // that is mapped into memory. Rounded up to a multiple of the page size.
+  size_t chunk_size = 1024 * 1024;
+};
+
+// A LogFunction that appends messages to a file, in the same format as
+// StderrLogger.
+//
+// Messages are copied straight into a shared memory mapping of the file, so
+// writing one is a memcpy with no system call, except when the file has to
+// grow. Since the kernel owns the mapped pages, everything that was logged
+// reaches the file even if the process crashes or aborts right after, which
+// is what a LOG(FATAL) needs. Call Sync to also survive the device losing
+// power.
+//
+// The file grows chunk_size bytes at a time, and is truncated to the end of
+// the last message when the last copy of the logger is destroyed. A file left
+// by a process that crashed may end in NUL padding, which is trimmed when the
+// file is next opened.
+//
+// Each message is formatted before taking a lock, which is then held for the
+// memcpy, and, once every chunk_size bytes, while the file grows and the next
+// chunk is mapped. To keep all of that off the logging threads, use it as the
+// sink of an AsyncLogger:
+//
+//   if (auto file = FileLogger::Open(path)) {
+//     SetLogger(AsyncLogger(*std::move(file)));
+//   }
+//
+// Copies of a FileLogger share the same file.
+class FileLogger {
+ public:
+  // Opens path, creating it if needed, and logs after what is already in it.
+  // Returns nullopt and logs the error if it can't be opened.
+  //
+  // The file isn't opened with O_APPEND: messages are copied into a mapping of
+  // the file from the logger's own idea of where the file ends. Anything else
+  // that writes to the same file, including a second FileLogger opened on the
+  // same path, will overwrite messages or be overwritten by them.
+  static std::optional<FileLogger> Open(const char* path,
+                                        const FileLoggerOptions& options = {});
+
+  void operator()(LogId, LogSeverity, const char* tag, const char* file,
+                  unsigned int line, const char* message);
+
+  // Waits until everything logged so far has been written to storage. Returns
+  // false and logs the error if it couldn't be.
+  bool Sync();
+
+ private:
+  class File;
+
+  explicit FileLogger(std::shared_ptr<File> file);
+
+  std::shared_ptr<File> file_;
+};
+
+}  // namespace ndksamples::base
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+//
+// std::format-style logging with deferred formatting.
+//
+// To log:
+//
+//   LOGF(INFO, "Decoded frame {} in {:.2f} ms", frame, elapsed_ms);
+//
+// The format string is checked against the arguments at compile time, as for
+// std::format. Rather than formatting the message, LOGF copies the arguments
+// into a compact binary record along with a pointer to the format string. If
+// the logger is an AsyncLogger, the record is queued as is and the message is
+// only formatted on the logger's background thread, so the cost to the caller
+// is about that of copying the arguments. With any other logger the message is
+// formatted straight away and logged like LOG.
+//
+// Arguments may be strings (const char*, std::string or std::string_view),
+// whose characters are copied, or any trivially copyable type that
+// std::format can format, such as numbers, bool and void*. The format string
+// and LOG_TAG must be string literals, since the record only points to them.
+//
+// LOGF(FATAL, ...) is always formatted and written before aborting, like
+// LOG(FATAL). Like LOG, the arguments are not evaluated if the severity
+// wouldn't be logged.
+//
+// This header requires C++20.
+
+#include <base/errno_restorer.h>
+#include <base/logging.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <format>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#define LOGF(severity, format, ...)                                        \
+  do {                                                                     \
+    if (WOULD_LOG(severity)) {                                             \
+      ::ndksamples::base::ErrnoRestorer _errno_restorer;                   \
+      ::ndksamples::base::log_detail::LogFormat(                           \
+          SEVERITY_LAMBDA(severity), __FILE_NAME__, __LINE__,              \
+          _LOG_TAG_INTERNAL, format __VA_OPT__(, ) __VA_ARGS__);           \
+    }                                                                      \
+  } while (false)
+
+namespace ndksamples::base {
+
+namespace log_detail {
+
+// Everything about a LOGF message except its arguments. The strings are all
+// literals, so the record can outlive the call.
+struct FormatRecord {
+  const char* file;
+  unsigned int line;
+  const char* tag;
+  std::string_view format;
+  // Decodes arguments encoded by EncodeFormatArg and appends the formatted
+  // message to out.
+  void (*format_args)(std::string_view format, const std::byte* args,
+                      std::string* out);
+};
+
+// Logs a LOGF message whose arguments have been encoded into args.
+void LogFormatted(LogSeverity severity, const FormatRecord& record,
+                  const std::byte* args, size_t size);
+
+template <typename T>
+inline constexpr bool kIsFormatString =
+    std::is_same_v<T, const char*> || std::is_same_v<T, char*> ||
+    std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>;
+
+// The type an argument is decoded as.
+template <typename T>
+using DecodedFormatArg =
+    std::conditional_t<kIsFormatString<T>, std::string_view, T>;
+
+inline std::string_view AsStringView(const char* s) {
+  return s != nullptr ? std::string_view(s) : std::string_view();
+}
+inline std::string_view AsStringView(std::string_view s) { return s; }
+
+template <typename T>
+size_t EncodedFormatArgSize(const T& value) {
+  if constexpr (kIsFormatString<T>) {
+    return sizeof(size_t) + AsStringView(value).size();
+  } else {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "LOGF arguments must be strings or trivially copyable");
+    return sizeof(T);
+  }
+}
+
+template <typename T>
+std::byte* EncodeFormatArg(std::byte* out, const T& value) {
+  if constexpr (kIsFormatString<T>) {
+    const std::string_view s = AsStringView(value);
+    const size_t size = s.size();
+    memcpy(out, &size, sizeof(size));
+    memcpy(out + sizeof(size), s.data(), size);
+    return out + sizeof(size) + size;
+  } else {
+    memcpy(out, std::addressof(value), sizeof(T));
+    return out + sizeof(T);
+  }
+}
+
+template <typename T>
+DecodedFormatArg<T> DecodeFormatArg(const std::byte*& in) {
+  if constexpr (kIsFormatString<T>) {
+    size_t size;
+    memcpy(&size, in, sizeof(size));
+    std::string_view s(reinterpret_cast<const char*>(in + sizeof(size)), size);
+    in += sizeof(size) + size;
+    return s;
+  } else {
+    std::remove_const_t<T> value;
+    memcpy(std::addressof(value), in, sizeof(T));
+    in += sizeof(T);
+    return value;
+  }
+}
+
+template <typename... Args>
+void FormatArgs(std::string_view format,
+                [[maybe_unused]] const std::byte* args, std::string* out) {
+  // Braced initializers are evaluated in order, so the arguments are decoded in
+  // the order they were encoded.
+  std::tuple<DecodedFormatArg<Args>...> values{DecodeFormatArg<Args>(args)...};
+  std::apply(
+      [&](auto&... value) {
+        std::vformat_to(std::back_inserter(*out), format,
+                        std::make_format_args(value...));
+      },
+      values);
+}
+
+// Messages with arguments larger than this are encoded on the heap.
+inline constexpr size_t kMaxInlineFormatArgsSize = 512;
+
+template <typename... Args>
+void LogFormat(LogSeverity severity, const char* file, unsigned int line,
+               const char* tag, std::format_string<Args...> format,
+               Args&&... args) {
+  const FormatRecord record = {file, line, tag, format.get(),
+                               &FormatArgs<std::decay_t<Args>...>};
+  const size_t size =
+      (size_t{0} + ... + EncodedFormatArgSize<std::decay_t<Args>>(args));
+
+  std::byte inline_buffer[kMaxInlineFormatArgsSize];
+  std::unique_ptr<std::byte[]> heap_buffer;
+  std::byte* buffer = inline_buffer;
+  if (size > sizeof(inline_buffer)) {
+    heap_buffer.reset(new std::byte[size]);
+    buffer = heap_buffer.get();
+  }
+
+  [[maybe_unused]] std::byte* out = buffer;
+  ((out = EncodeFormatArg<std::decay_t<Args>>(out, args)), ...);
+  LogFormatted(severity, record, buffer, size);
+}
+
+}  // namespace log_detail
+
+}  // namespace ndksamples::base
@@ -24,8 +24,10 @@
  * https://cs.android.com/android/platform/superproject/main/+/main:system/libbase/include/android-base/logging.h
  *
  * The original file contained a lot of dependencies for things we don't need
- * (kernel logging, support for non-Android platforms, non-logd loggers, etc).
- * That's all been removed so we don't need to pull in those dependencies.
+ * (kernel logging, support for platforms other than Android and Linux, etc).
+ * That's all been removed so we don't need to pull in those dependencies. Host
+ * (Linux) builds are supported only so that code like the vectorization
+ * benchmarks can be run on a build machine, and log to stderr.
  *
  * If you copy from this sample, you may want to replace this with something
  * like absl, which provides a very similar (if not identical) interface for all
@@ -65,6 +67,12 @@
 // Code can choose a specific log tag by defining LOG_TAG
 // before including this header.
 
+// To keep a statement in a hot loop from flooding the log:
+//
+//   LOG_EVERY_N(WARNING, 100) << "Dropped frame " << frame;
+//   LOG_FIRST_N(INFO, 5) << "Codec output format changed";
+//   LOG_EVERY_T(ERROR, 1.0) << "Buffer underrun";
+//
 // This header also provides assertions:
 //
 //   CHECK(must_be_true);
@@ -73,6 +81,10 @@
 #include <base/errno_restorer.h>
 #include <base/macros.h>
 
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <optional>
@@ -117,8 +129,17 @@ using AbortFunction = std::function<void(const char* /*abort_message*/)>;
 
 void DefaultAborter(const char* abort_message);
 
-void SetDefaultTag(const std::string& tag);
+// Sets the tag used for messages logged without a LOG_TAG. An empty tag
+// restores the default, which is the program name. Only the first 127 bytes of
+// the tag are used. Like SetMinimumLogSeverity(tag, severity), this waits for
+// other threads to finish reading the tag settings.
+void SetDefaultTag(std::string_view tag);
 
+// Log to stderr in the full logcat format (with pid/tid/time/tag details).
+void StderrLogger(LogId log_buffer_id, LogSeverity severity, const char* tag,
+                  const char* file, unsigned int line, const char* message);
+
+#if defined(__ANDROID__)
 // The LogdLogger sends chunks of up to ~4000 bytes at a time to logd.  It does
 // not prevent other threads from writing to logd between sending each chunk, so
 // other threads may interleave their messages.  If preventing interleaving is
@@ -134,6 +155,7 @@ class LogdLogger {
  private:
   LogId default_log_id_;
 };
+#endif
 
 // Configure logging based on ANDROID_LOG_TAGS environment variable.
 // We need to parse a string that looks like
@@ -142,8 +164,13 @@ class LogdLogger {
 //
 // The tag (or '*' for the global level) comes first, followed by a colon and a
 // letter indicating the minimum priority level we're expected to log.  This can
-// be used to reveal or conceal logs with specific tags.
+// be used to reveal or conceal logs with specific tags. If log_level is given,
+// it replaces the global level.
+#if defined(__ANDROID__)
 #define INIT_LOGGING_DEFAULT_LOGGER LogdLogger()
+#else
+#define INIT_LOGGING_DEFAULT_LOGGER StderrLogger
+#endif
 void InitLogging(const std::optional<std::string_view> default_tag = {},
                  std::optional<LogSeverity> log_level = {},
                  LogFunction&& logger = INIT_LOGGING_DEFAULT_LOGGER,
@@ -219,6 +246,43 @@ AbortFunction SetAborter(AbortFunction&& aborter);
                                      _LOG_TAG_INTERNAL, errno)  \
           .stream()
 
+// Variants of LOG that limit how often a single statement logs, for use in
+// loops that would otherwise flood the log:
+//
+//   LOG_EVERY_N logs the 1st, (n+1)th, (2n+1)th, ... time it is reached.
+//   LOG_FIRST_N logs the first n times it is reached.
+//   LOG_EVERY_T logs at most once every `seconds` seconds.
+//
+// Each statement keeps its own count, shared by all threads. As with LOG,
+// nothing is counted if the severity wouldn't be logged, and the streamed
+// values are only evaluated when the message is logged. LOG_EVERY_N and
+// LOG_EVERY_T prefix each message with the number of messages the statement
+// suppressed since it last logged, if there were any.
+#define LOG_EVERY_N(severity, n) \
+  LOG_RATE_LIMITED(severity, EveryN((n), &_log_suppressed))
+#define LOG_FIRST_N(severity, n) LOG_RATE_LIMITED(severity, FirstN(n))
+#define LOG_EVERY_T(severity, seconds) \
+  LOG_RATE_LIMITED(severity, EveryT((seconds), &_log_suppressed))
+
+// The switch keeps an else following a rate limited LOG statement from binding
+// to the if inside it. The lambda gives each statement its own LogRateLimiter.
+// Note: DO NOT USE DIRECTLY. This is an implementation detail.
+#define LOG_RATE_LIMITED(severity, should_log)                              \
+  switch (0)                                                                \
+  case 0:                                                                   \
+  default:                                                                  \
+    if (uint32_t _log_suppressed = 0;                                       \
+        !(WOULD_LOG(severity) &&                                            \
+          []() -> ::ndksamples::base::log_detail::LogRateLimiter& {         \
+            static ::ndksamples::base::log_detail::LogRateLimiter limiter;  \
+            return limiter;                                                 \
+          }()                                                               \
+                      .should_log)) {                                       \
+    } else                                                                  \
+      ::ndksamples::base::ErrnoRestorer() &&                                \
+          LOG_STREAM(severity)                                              \
+              << ::ndksamples::base::log_detail::Suppressed{_log_suppressed}
+
 // Marker that code is yet to be implemented.
 #define UNIMPLEMENTED(level) \
   LOG(level) << __PRETTY_FUNCTION__ << " unimplemented "
@@ -377,6 +441,64 @@ struct EagerEvaluator {
   const Storage<typename StorageTypes<LHS, RHS>::RHSType> rhs;
 };
 
+// The state of a single LOG_EVERY_N, LOG_FIRST_N or LOG_EVERY_T statement.
+// Each is a function local static, so it must be constant initialized to avoid
+// the cost of a guard variable.
+class LogRateLimiter {
+ public:
+  constexpr LogRateLimiter() = default;
+
+  // These return whether the message should be logged. EveryN and EveryT also
+  // set *suppressed to the number of messages suppressed since the last one
+  // that was logged.
+  bool EveryN(uint32_t n, uint32_t* suppressed) {
+    const uint32_t count = count_.fetch_add(1, std::memory_order_relaxed);
+    if (n <= 1) return true;
+    if (count % n != 0) return false;
+    *suppressed = count == 0 ? 0 : n - 1;
+    return true;
+  }
+
+  bool FirstN(uint32_t n) {
+    // Stop counting once n is reached, so that the count can never wrap.
+    return count_.load(std::memory_order_relaxed) < n &&
+           count_.fetch_add(1, std::memory_order_relaxed) < n;
+  }
+
+  bool EveryT(double seconds, uint32_t* suppressed) {
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now().time_since_epoch())
+                            .count();
+    int64_t next = next_log_ns_.load(std::memory_order_relaxed);
+    // Only one thread can win the exchange for each period.
+    if (now < next || !next_log_ns_.compare_exchange_strong(
+                          next, now + static_cast<int64_t>(seconds * 1e9),
+                          std::memory_order_relaxed)) {
+      suppressed_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    *suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+    return true;
+  }
+
+ private:
+  std::atomic<uint32_t> count_ = 0;
+  std::atomic<int64_t> next_log_ns_ = 0;
+  std::atomic<uint32_t> suppressed_ = 0;
+};
+
+// Streamed at the start of a rate limited message.
+struct Suppressed {
+  uint32_t count;
+};
+
+inline std::ostream& operator<<(std::ostream& stream, Suppressed suppressed) {
+  if (suppressed.count != 0) {
+    stream << "(" << suppressed.count << " messages suppressed) ";
+  }
+  return stream;
+}
+
 }  // namespace log_detail
 
 // Converts std::nullptr_t and null char pointers to the string "null"
@@ -406,7 +528,7 @@ constexpr auto MakeEagerEvaluator(LHS&& lhs, RHS&& rhs) {
 }
 
 // Data for the log message, not stored in LogMessage to avoid increasing the
-// stack size.
+// stack size. Each thread reuses its own, so logging doesn't allocate.
 class LogMessageData;
 
 // A LogMessage is a temporarily scoped object used by LOG and the unlikely part
@@ -432,7 +554,7 @@ class LogMessage {
                       const char* tag, const char* msg);
 
  private:
-  const std::unique_ptr<LogMessageData> data_;
+  LogMessageData* const data_;
 };
 
 // Get the minimum severity level for logging.
@@ -441,6 +563,18 @@ LogSeverity GetMinimumLogSeverity();
 // Set the minimum severity level for logging, returning the old severity.
 LogSeverity SetMinimumLogSeverity(LogSeverity new_severity);
 
+// Get the minimum severity level for logging with the given tag, if it has one
+// rather than using the global level.
+std::optional<LogSeverity> GetMinimumLogSeverity(std::string_view tag);
+
+// Set the minimum severity level for logging with the given tag, or return it
+// to the global level if new_severity is empty. Returns the old severity of the
+// tag. Checking whether to log never waits for this. This waits for checks
+// already in progress on other threads, but not for messages being written, so
+// it may be called from a LogFunction.
+std::optional<LogSeverity> SetMinimumLogSeverity(
+    std::string_view tag, std::optional<LogSeverity> new_severity);
+
 // Return whether or not a log message with the associated tag should be logged.
 bool ShouldLog(LogSeverity severity, const char* tag);
 
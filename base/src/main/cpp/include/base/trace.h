@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+//
+// Scoped tracing of code sections.
+//
+// To time a section of code, from the macro to the end of the enclosing scope:
+//
+//   void DrawFrame() {
+//     TRACE_SCOPE("DrawFrame");
+//     ...
+//   }
+//
+// To record a value over time:
+//
+//   TRACE_COUNTER("queued buffers", queue.size());
+//
+// Names must be string literals, or otherwise outlive the trace, since only
+// the pointer is recorded.
+//
+// Nothing is traced until tracing is turned on, and until then each macro costs
+// one relaxed atomic load, and TRACE_COUNTER doesn't evaluate its value. There
+// are two independent ways to turn it on:
+//
+// * EnableATrace forwards events to ATrace, so that they show up in system
+//   traces captured with Perfetto or systrace, along with the rest of the
+//   system. ATrace is only available on API 23 and newer (API 29 for counters),
+//   and only records while a system trace is being captured.
+//
+// * StartTracing records events in memory, in a buffer for each thread, until
+//   StopTracing. Each thread's buffer holds kTraceEventsPerThread events,
+//   after which new sections and counters are dropped. Room is kept for the
+//   end of every section that has already begun, so the trace never has a
+//   section that doesn't end. WriteChromeTrace writes the recorded events as
+//   JSON, which can be opened with https://ui.perfetto.dev or
+//   chrome://tracing. This works on the host too.
+//
+//   Recording an event doesn't take a lock or allocate, except for the first
+//   event of a thread. That takes a lock to give the thread a buffer, and
+//   allocates one (kTraceEventsPerThread * 32 bytes, 512 KiB) unless a thread
+//   that has exited left one to reuse. WriteChromeTrace holds the same lock
+//   while it writes the file, so that first event can also wait for it.
+
+#include <base/macros.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#define TRACE_SCOPE(name) \
+  ::ndksamples::base::TraceScope TRACE_CONCAT(_trace_scope_, __LINE__)(name)
+
+#define TRACE_COUNTER(name, value)                                    \
+  do {                                                                \
+    if (UNLIKELY(::ndksamples::base::trace_detail::gTraceFlags.load(  \
+                     std::memory_order_relaxed) != 0)) {              \
+      ::ndksamples::base::trace_detail::Counter(                      \
+          name, static_cast<int64_t>(value));                         \
+    }                                                                 \
+  } while (false)
+
+// Note: DO NOT USE DIRECTLY. This is an implementation detail.
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_CONCAT_INNER(a, b) a##b
+
+namespace ndksamples::base {
+
+// The number of events each thread can record between calls to StartTracing.
+inline constexpr size_t kTraceEventsPerThread = 16 * 1024;
+
+// Forwards events to ATrace, if the device supports it. Returns whether it
+// does.
+bool EnableATrace();
+
+// Discards any events recorded so far, and starts recording events.
+void StartTracing();
+
+// Stops recording events. The events already recorded are kept until the next
+// StartTracing.
+void StopTracing();
+
+// Writes the events recorded since the last StartTracing to path, in the Chrome
+// trace event JSON format. This may be called while recording, in which case
+// the trace only includes events recorded before the call. Returns false and
+// logs the error if the file can't be written.
+bool WriteChromeTrace(const char* path);
+
+namespace trace_detail {
+
+enum TraceFlags : uint32_t {
+  kRecording = 1 << 0,
+  kATrace = 1 << 1,
+};
+
+// A combination of TraceFlags, which is 0 unless tracing is on.
+extern std::atomic<uint32_t> gTraceFlags;
+
+// These return the TraceFlags of the destinations that recorded the event.
+uint32_t BeginSection(const char* name, uint32_t flags);
+void EndSection(uint32_t flags);
+void Counter(const char* name, int64_t value);
+
+}  // namespace trace_detail
+
+// Traces the lifetime of the object as a section with the given name. See
+// TRACE_SCOPE.
+class TraceScope {
+ public:
+  explicit TraceScope(const char* name)
+      : flags_(trace_detail::gTraceFlags.load(std::memory_order_relaxed)) {
+    if (UNLIKELY(flags_ != 0)) {
+      flags_ = trace_detail::BeginSection(name, flags_);
+    }
+  }
+
+  ~TraceScope() {
+    // Only end the section in the destinations it began in, even if tracing
+    // has been turned on or off since.
+    if (UNLIKELY(flags_ != 0)) {
+      trace_detail::EndSection(flags_);
+    }
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(TraceScope);
+
+ private:
+  uint32_t flags_;
+};
+
+}  // namespace ndksamples::base
@@ -16,27 +16,36 @@
 
 #include "base/logging.h"
 
-#include <android/log.h>
-#include <android/set_abort_message.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
 #include <libgen.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <atomic>
+#include <cstddef>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <mutex>
+#include <new>
 #include <optional>
-#include <sstream>
+#include <streambuf>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#include "base/async_logger.h"
+#include "base/format_logging.h"
 #include "base/macros.h"
-#include "logging_splitters.h"
+#include "logging_platform.h"
 
 namespace ndksamples::base {
 
@@ -50,43 +59,8 @@ static const char* GetFileBasename(const char* file) {
   return file;
 }
 
-static int32_t LogIdTolog_id_t(LogId log_id) {
-  switch (log_id) {
-    case MAIN:
-      return LOG_ID_MAIN;
-    case SYSTEM:
-      return LOG_ID_SYSTEM;
-    case RADIO:
-      return LOG_ID_RADIO;
-    case CRASH:
-      return LOG_ID_CRASH;
-    case DEFAULT:
-    default:
-      return LOG_ID_DEFAULT;
-  }
-}
-
-static int32_t LogSeverityToPriority(LogSeverity severity) {
-  switch (severity) {
-    case VERBOSE:
-      return ANDROID_LOG_VERBOSE;
-    case DEBUG:
-      return ANDROID_LOG_DEBUG;
-    case INFO:
-      return ANDROID_LOG_INFO;
-    case WARNING:
-      return ANDROID_LOG_WARN;
-    case ERROR:
-      return ANDROID_LOG_ERROR;
-    case FATAL_WITHOUT_ABORT:
-    case FATAL:
-    default:
-      return ANDROID_LOG_FATAL;
-  }
-}
-
 static LogFunction& Logger() {
-  static auto& logger = *new LogFunction(LogdLogger());
+  static auto& logger = *new LogFunction(DefaultLogger());
   return logger;
 }
 
@@ -95,54 +69,243 @@ static AbortFunction& Aborter() {
   return aborter;
 }
 
-// Only used for Q fallback.
-static std::recursive_mutex& TagLock() {
-  static auto& tag_lock = *new std::recursive_mutex();
-  return tag_lock;
+// The default tag and the minimum severities of individual tags. These are
+// read for every message, and rarely change, so rather than being guarded by a
+// lock, each change publishes a new immutable TagSettings through
+// gTagSettings. Readers may still be using the old TagSettings after it has
+// been replaced, so it is only freed once they're done with it (see
+// TagSettingsReader).
+struct TagSettings {
+  // The tag used for messages logged without one. Empty to use the program
+  // name.
+  std::string default_tag;
+
+  // The minimum severity of each tag that has one.
+  std::vector<std::pair<std::string, LogSeverity>> minimum_severities;
+
+  // The entry in minimum_severities for the default tag, if there is one.
+  std::optional<LogSeverity> default_tag_minimum_severity;
+
+  const char* GetDefaultTag() const {
+    return default_tag.empty() ? GetProgramName() : default_tag.c_str();
+  }
+
+  std::optional<LogSeverity> GetMinimumSeverity(std::string_view tag) const {
+    for (const auto& [name, severity] : minimum_severities) {
+      if (name == tag) return severity;
+    }
+    return {};
+  }
+};
+
+// The size of the buffer that LogMessage copies the default tag into, so a
+// longer tag is truncated.
+static constexpr size_t kMaxDefaultTagSize = 128;
+
+// Null until the first change, which is the same as an empty TagSettings.
+static std::atomic<const TagSettings*> gTagSettings = nullptr;
+
+// Whether gTagSettings has any minimum_severities. Until a tag is given its own
+// severity, checks only read this rather than the TagSettings.
+static std::atomic<bool> gHasTagSeverities = false;
+
+// Incremented by each change to gTagSettings. It starts at 1, since 0 means
+// that a TagSettingsReaderSlot isn't reading.
+static std::atomic<uint64_t> gTagSettingsEpoch = 1;
+
+// Each thread that reads gTagSettings has a slot, in which it publishes the
+// epoch when its current read started. A writer waits until no slot shows an
+// epoch from before its change, after which no reader can still hold the
+// TagSettings it replaced (see WaitForTagSettingsReaders). This is the grace
+// period of read-copy-update. Each slot has its own cache line, so readers on
+// different threads never write to the same one.
+struct alignas(64) TagSettingsReaderSlot {
+  // The epoch when the thread's current read started, or 0 if it isn't
+  // reading.
+  std::atomic<uint64_t> epoch = 0;
+
+  // Guarded by TagSettingsLock.
+  bool in_use = false;
+};
+
+// Serializes changes to gTagSettings, and assigns slots to threads.
+static std::mutex& TagSettingsLock() {
+  static auto& tag_settings_lock = *new std::mutex();
+  return tag_settings_lock;
 }
 
-static std::string* gDefaultTag;
+// Every slot, including those of threads that have exited, which are reused by
+// new threads. Guarded by TagSettingsLock.
+static std::vector<TagSettingsReaderSlot*>& TagSettingsReaderSlots() {
+  static auto& slots = *new std::vector<TagSettingsReaderSlot*>();
+  return slots;
+}
 
-void SetDefaultTag(const std::string_view tag) {
-  std::lock_guard<std::recursive_mutex> lock(TagLock());
-  if (gDefaultTag != nullptr) {
-    delete gDefaultTag;
-    gDefaultTag = nullptr;
+// These are trivially destructible, so they can still be used by thread_local
+// destructors that log while the thread exits.
+static thread_local TagSettingsReaderSlot* tls_reader_slot = nullptr;
+static thread_local bool tls_reader_exited = false;
+
+// Returns the thread's slot to the pool when the thread exits.
+struct TagSettingsReaderSlotReleaser {
+  ~TagSettingsReaderSlotReleaser() {
+    std::lock_guard<std::mutex> lock(TagSettingsLock());
+    tls_reader_slot->in_use = false;
+    tls_reader_slot = nullptr;
+    tls_reader_exited = true;
+  }
+};
+static thread_local TagSettingsReaderSlotReleaser tls_reader_slot_releaser;
+
+// Returns the calling thread's slot, or null if the thread is exiting.
+static TagSettingsReaderSlot* GetTagSettingsReaderSlot() {
+  if (LIKELY(tls_reader_slot != nullptr)) return tls_reader_slot;
+  if (tls_reader_exited) return nullptr;
+
+  std::lock_guard<std::mutex> lock(TagSettingsLock());
+  TagSettingsReaderSlot* slot = nullptr;
+  for (TagSettingsReaderSlot* unused : TagSettingsReaderSlots()) {
+    if (!unused->in_use) {
+      slot = unused;
+      break;
+    }
   }
-  if (!tag.empty()) {
-    gDefaultTag = new std::string(tag);
+  if (slot == nullptr) {
+    slot = new TagSettingsReaderSlot();
+    TagSettingsReaderSlots().push_back(slot);
   }
+  slot->in_use = true;
+  tls_reader_slot = slot;
+  // Constructs tls_reader_slot_releaser, which registers its destructor.
+  (void)&tls_reader_slot_releaser;
+  return slot;
+}
+
+// Gives the current TagSettings, which stays valid until this is destroyed.
+//
+// Reading only writes to the thread's own slot, and never waits, except that
+// a thread's first read takes TagSettingsLock to claim its slot, and so does
+// each read while the thread exits. A thread has one slot, so readers can't
+// nest, and must not call anything that might log.
+class TagSettingsReader {
+ public:
+  TagSettingsReader() : slot_(GetTagSettingsReaderSlot()) {
+    if (LIKELY(slot_ != nullptr)) {
+      // Both this store and the load of gTagSettings are seq_cst, like the
+      // writer's store of gTagSettings and load of the slot, so either the
+      // writer sees this read, or this read sees the writer's change.
+      slot_->epoch.store(gTagSettingsEpoch.load(std::memory_order_acquire));
+    } else {
+      exiting_lock_ = std::unique_lock<std::mutex>(TagSettingsLock());
+    }
+    settings_ = gTagSettings.load();
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(TagSettingsReader);
+
+  ~TagSettingsReader() {
+    if (LIKELY(slot_ != nullptr)) {
+      slot_->epoch.store(0, std::memory_order_release);
+    }
+  }
+
+  // Null until the first change, which is the same as an empty TagSettings.
+  const TagSettings* get() const { return settings_; }
+
+ private:
+  TagSettingsReaderSlot* slot_;
+  // Held instead of a slot by a thread that has already given up its slot.
+  std::unique_lock<std::mutex> exiting_lock_;
+  const TagSettings* settings_;
+};
+
+// Waits until every TagSettingsReader that might hold a TagSettings replaced
+// before the call has finished. Called with TagSettingsLock held.
+//
+// A reader that publishes its epoch after the writer checked its slot still
+// loads gTagSettings after that, so it can only see the new TagSettings. A
+// reader that starts after the increment has a newer epoch, which isn't waited
+// for, so a busy thread can hold up the writer for one read at most.
+static void WaitForTagSettingsReaders() {
+  const uint64_t epoch = gTagSettingsEpoch.fetch_add(1) + 1;
+  for (const TagSettingsReaderSlot* slot : TagSettingsReaderSlots()) {
+    for (uint64_t reading = slot->epoch.load(); reading != 0 && reading < epoch;
+         reading = slot->epoch.load()) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+// Publishes a copy of the current TagSettings, after applying change to it,
+// and frees the old one once no reader can be using it.
+template <typename F>
+static void UpdateTagSettings(const F& change) {
+  std::lock_guard<std::mutex> lock(TagSettingsLock());
+  std::unique_ptr<const TagSettings> old_settings(
+      gTagSettings.load(std::memory_order_relaxed));
+  auto settings = std::make_unique<TagSettings>();
+  if (old_settings != nullptr) {
+    settings->default_tag = old_settings->default_tag;
+    settings->minimum_severities = old_settings->minimum_severities;
+  }
+  change(*settings);
+  settings->default_tag_minimum_severity =
+      settings->GetMinimumSeverity(settings->GetDefaultTag());
+  const bool has_tag_severities = !settings->minimum_severities.empty();
+  gTagSettings.store(settings.release());
+  gHasTagSeverities.store(has_tag_severities, std::memory_order_relaxed);
+  WaitForTagSettingsReaders();
+}
+
+void SetDefaultTag(std::string_view tag) {
+  UpdateTagSettings([&](TagSettings& settings) { settings.default_tag = tag; });
 }
 
 static bool gInitialized = false;
 
-// Only used for Q fallback.
-static LogSeverity gMinimumLogSeverity = INFO;
+static std::atomic<LogSeverity> gMinimumLogSeverity = INFO;
 
 void DefaultAborter(const char* abort_message) {
-  android_set_abort_message(abort_message);
+  SetAbortMessage(abort_message);
   abort();
 }
 
-static void LogdLogChunk(LogId id, LogSeverity severity, const char* tag,
-                         const char* message) {
-  int32_t lg_id = LogIdTolog_id_t(id);
-  int32_t priority = LogSeverityToPriority(severity);
-
-  __android_log_buf_print(lg_id, priority, tag, "%s", message);
+void StderrLogger(LogId, LogSeverity severity, const char* tag,
+                  const char* file, unsigned int line, const char* message) {
+  struct tm now;
+  time_t t = time(nullptr);
+  localtime_r(&t, &now);
+  char timestamp[32];
+  strftime(timestamp, sizeof(timestamp), "%m-%d %H:%M:%S", &now);
+
+  static const char log_characters[] = "VDIWEFF";
+  static_assert(arraysize(log_characters) - 1 == FATAL + 1,
+                "Mismatch in size of log_characters and values in LogSeverity");
+  char severity_char = log_characters[severity];
+  fprintf(stderr, "%s %c %s %5d %5d %s:%u] %s\n", tag ? tag : "nullptr",
+          severity_char, timestamp, getpid(), gettid(), file, line, message);
 }
 
-LogdLogger::LogdLogger(LogId default_log_id)
-    : default_log_id_(default_log_id) {}
-
-void LogdLogger::operator()(LogId id, LogSeverity severity, const char* tag,
-                            const char* file, unsigned int line,
-                            const char* message) {
-  if (id == DEFAULT) {
-    id = default_log_id_;
+// Converts a priority letter from ANDROID_LOG_TAGS to a LogSeverity.
+static std::optional<LogSeverity> ParseLogSeverity(char priority) {
+  switch (priority) {
+    case 'v':
+      return VERBOSE;
+    case 'd':
+      return DEBUG;
+    case 'i':
+      return INFO;
+    case 'w':
+      return WARNING;
+    case 'e':
+      return ERROR;
+    case 'f':
+    case 's':
+      // Silent still logs FATAL messages, which abort.
+      return FATAL_WITHOUT_ABORT;
+    default:
+      return {};
   }
-
-  SplitByLogdChunks(id, severity, tag, file, line, message, LogdLogChunk);
 }
 
 void InitLogging(const std::optional<std::string_view> default_tag,
@@ -162,8 +325,33 @@ void InitLogging(const std::optional<std::string_view> default_tag,
   }
 
   const char* tags = getenv("ANDROID_LOG_TAGS");
-  if (tags == nullptr) {
-    return;
+  if (tags != nullptr) {
+    std::string_view specs = tags;
+    while (!specs.empty()) {
+      const size_t end = std::min(specs.find(' '), specs.size());
+      const std::string_view spec = specs.substr(0, end);
+      specs.remove_prefix(std::min(end + 1, specs.size()));
+      if (spec.empty()) {
+        continue;
+      }
+
+      std::optional<LogSeverity> severity;
+      if (spec.size() >= 3 && spec[spec.size() - 2] == ':') {
+        severity = ParseLogSeverity(spec.back());
+      }
+      if (!severity.has_value()) {
+        LOG(ERROR) << "Ignoring unsupported '" << spec
+                   << "' in ANDROID_LOG_TAGS (" << tags << ")";
+        continue;
+      }
+
+      const std::string_view tag = spec.substr(0, spec.size() - 2);
+      if (tag == "*") {
+        SetMinimumLogSeverity(*severity);
+      } else {
+        SetMinimumLogSeverity(tag, severity);
+      }
+    }
   }
 
   if (log_level.has_value()) {
@@ -183,20 +371,89 @@ AbortFunction SetAborter(AbortFunction&& aborter) {
   return old_aborter;
 }
 
+// A streambuf that writes into a fixed buffer, and only moves the message to
+// the heap if it doesn't fit.
+class LogStreamBuf : public std::streambuf {
+ public:
+  LogStreamBuf() { Reset(); }
+
+  DISALLOW_COPY_AND_ASSIGN(LogStreamBuf);
+
+  // Discards the message, and frees any memory it used.
+  void Reset() {
+    std::string().swap(overflow_);
+    // Leave room for the null terminator.
+    setp(buffer_, buffer_ + sizeof(buffer_) - 1);
+  }
+
+  // Returns the message, which is valid until the next call to Reset.
+  const char* c_str() {
+    if (overflow_.empty()) {
+      *pptr() = '\0';
+      return buffer_;
+    }
+    SpillBuffer();
+    return overflow_.c_str();
+  }
+
+ protected:
+  int_type overflow(int_type c) override {
+    SpillBuffer();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      overflow_.push_back(traits_type::to_char_type(c));
+    }
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    if (n <= epptr() - pptr()) {
+      memcpy(pptr(), s, n);
+      pbump(static_cast<int>(n));
+    } else {
+      SpillBuffer();
+      overflow_.append(s, n);
+    }
+    return n;
+  }
+
+ private:
+  // Moves what's in buffer_ to the end of overflow_, and empties buffer_.
+  void SpillBuffer() {
+    overflow_.append(pbase(), pptr());
+    setp(buffer_, buffer_ + sizeof(buffer_) - 1);
+  }
+
+  char buffer_[1024];
+  std::string overflow_;
+};
+
 // This indirection greatly reduces the stack impact of having lots of
 // checks/logging in a function.
 class LogMessageData {
  public:
-  LogMessageData(const char* file, unsigned int line, LogSeverity severity,
-                 const char* tag, int error)
-      : file_(GetFileBasename(file)),
-        line_number_(line),
-        severity_(severity),
-        tag_(tag),
-        error_(error) {}
+  LogMessageData() : stream_(&buffer_) {}
 
   DISALLOW_COPY_AND_ASSIGN(LogMessageData);
 
+  // Prepares to format a new message. The stream's formatting flags are reset,
+  // so that the message is formatted as it would be by a new stream.
+  void Start(const char* file, unsigned int line, LogSeverity severity,
+             const char* tag, int error) {
+    file_ = GetFileBasename(file);
+    line_number_ = line;
+    severity_ = severity;
+    tag_ = tag;
+    error_ = error;
+    stream_.clear();
+    stream_.flags(std::ios_base::skipws | std::ios_base::dec);
+    stream_.precision(6);
+    stream_.width(0);
+    stream_.fill(' ');
+  }
+
+  // Discards the message, and frees any memory it used.
+  void Finish() { buffer_.Reset(); }
+
   const char* GetFile() const { return file_; }
 
   unsigned int GetLineNumber() const { return line_number_; }
@@ -207,31 +464,68 @@ class LogMessageData {
 
   int GetError() const { return error_; }
 
-  std::ostream& GetBuffer() { return buffer_; }
+  std::ostream& GetBuffer() { return stream_; }
 
-  std::string ToString() const { return buffer_.str(); }
+  const char* c_str() { return buffer_.c_str(); }
+
+  // Whether this is the calling thread's LogMessageData, and a message is
+  // being formatted in it.
+  bool in_use = false;
 
  private:
-  std::ostringstream buffer_;
-  const char* const file_;
-  const unsigned int line_number_;
-  const LogSeverity severity_;
-  const char* const tag_;
-  const int error_;
+  LogStreamBuf buffer_;
+  std::ostream stream_;
+  const char* file_ = nullptr;
+  unsigned int line_number_ = 0;
+  LogSeverity severity_ = INFO;
+  const char* tag_ = nullptr;
+  int error_ = -1;
 };
 
+// Each thread formats its messages in its own LogMessageData, so that LOG
+// doesn't allocate. The storage is trivially destructible, so it is still
+// usable by thread_local destructors that log while the thread exits. A message
+// that is logged while another is being formatted on the same thread, for
+// example from an operator<<, gets a LogMessageData from the heap.
+static LogMessageData* AcquireLogMessageData() {
+  alignas(LogMessageData) static thread_local std::byte
+      storage[sizeof(LogMessageData)];
+  static thread_local LogMessageData* thread_data = nullptr;
+
+  if (thread_data == nullptr) {
+    thread_data = new (storage) LogMessageData();
+  }
+  if (thread_data->in_use) {
+    return new LogMessageData();
+  }
+  thread_data->in_use = true;
+  return thread_data;
+}
+
+static void ReleaseLogMessageData(LogMessageData* data) {
+  if (data->in_use) {
+    data->Finish();
+    data->in_use = false;
+  } else {
+    delete data;
+  }
+}
+
 LogMessage::LogMessage(const char* file, unsigned int line, LogId,
                        LogSeverity severity, const char* tag, int error)
     : LogMessage(file, line, severity, tag, error) {}
 
 LogMessage::LogMessage(const char* file, unsigned int line,
                        LogSeverity severity, const char* tag, int error)
-    : data_(new LogMessageData(file, line, severity, tag, error)) {}
+    : data_(AcquireLogMessageData()) {
+  data_->Start(file, line, severity, tag, error);
+}
 
 LogMessage::~LogMessage() {
   // Check severity again. This is duplicate work wrt/ LOG macros, but not
   // LOG_STREAM.
   if (!WOULD_LOG(data_->GetSeverity())) {
+    ReleaseLogMessageData(data_);
     return;
   }
 
@@ -239,21 +533,22 @@ LogMessage::~LogMessage() {
   if (data_->GetError() != -1) {
     data_->GetBuffer() << ": " << strerror(data_->GetError());
   }
-  std::string msg(data_->ToString());
+  const char* msg = data_->c_str();
 
   if (data_->GetSeverity() == FATAL) {
     // Set the bionic abort message early to avoid liblog doing it
     // with the individual lines, so that we get the whole message.
-    android_set_abort_message(msg.c_str());
+    SetAbortMessage(msg);
   }
 
   LogLine(data_->GetFile(), data_->GetLineNumber(), data_->GetSeverity(),
-          data_->GetTag(), msg.c_str());
+          data_->GetTag(), msg);
 
   // Abort if necessary.
   if (data_->GetSeverity() == FATAL) {
-    Aborter()(msg.c_str());
+    Aborter()(msg);
   }
+  ReleaseLogMessageData(data_);
 }
 
 std::ostream& LogMessage::stream() { return data_->GetBuffer(); }
@@ -261,27 +556,95 @@ std::ostream& LogMessage::stream() { return data_->GetBuffer(); }
 void LogMessage::LogLine(const char* file, unsigned int line,
                          LogSeverity severity, const char* tag,
                          const char* message) {
+  // The default tag belongs to the TagSettings, so copy it rather than holding
+  // a TagSettingsReader while the logger runs, which would hold up changes to
+  // the settings for as long as the logger takes.
+  char default_tag[kMaxDefaultTagSize];
   if (tag == nullptr) {
-    std::lock_guard<std::recursive_mutex> lock(TagLock());
-    if (gDefaultTag == nullptr) {
-      gDefaultTag = new std::string(getprogname());
+    tag = GetProgramName();
+    if (gTagSettings.load(std::memory_order_relaxed) != nullptr) {
+      TagSettingsReader reader;
+      const std::string& settings_tag = reader.get()->default_tag;
+      if (!settings_tag.empty()) {
+        const size_t size =
+            settings_tag.copy(default_tag, sizeof(default_tag) - 1);
+        default_tag[size] = '\0';
+        tag = default_tag;
+      }
     }
+  }
+  Logger()(DEFAULT, severity, tag, file, line, message);
+}
 
-    Logger()(DEFAULT, severity, gDefaultTag->c_str(), file, line, message);
-  } else {
-    Logger()(DEFAULT, severity, tag, file, line, message);
+void log_detail::LogFormatted(LogSeverity severity, const FormatRecord& record,
+                              const std::byte* args, size_t size) {
+  // FATAL messages are formatted here, so LogMessage can abort after writing
+  // them.
+  if (severity < FATAL_WITHOUT_ABORT) {
+    AsyncLogger* async_logger = Logger().target<AsyncLogger>();
+    if (async_logger != nullptr &&
+        async_logger->LogFormatted(severity, record, args, size)) {
+      return;
+    }
   }
+
+  std::string message;
+  record.format_args(record.format, args, &message);
+  LogMessage(record.file, record.line, severity, record.tag, -1).stream()
+      << message;
 }
 
-LogSeverity GetMinimumLogSeverity() { return gMinimumLogSeverity; }
+LogSeverity GetMinimumLogSeverity() {
+  return gMinimumLogSeverity.load(std::memory_order_relaxed);
+}
 
-bool ShouldLog(LogSeverity severity, const char*) {
-  return severity >= gMinimumLogSeverity;
+std::optional<LogSeverity> GetMinimumLogSeverity(std::string_view tag) {
+  if (!gHasTagSeverities.load(std::memory_order_relaxed)) return {};
+  TagSettingsReader reader;
+  const TagSettings* settings = reader.get();
+  if (settings == nullptr) return {};
+  return settings->GetMinimumSeverity(tag);
+}
+
+bool ShouldLog(LogSeverity severity, const char* tag) {
+  if (gHasTagSeverities.load(std::memory_order_relaxed)) {
+    TagSettingsReader reader;
+    const TagSettings* settings = reader.get();
+    if (settings != nullptr) {
+      std::optional<LogSeverity> tag_severity =
+          tag == nullptr ? settings->default_tag_minimum_severity
+                         : settings->GetMinimumSeverity(tag);
+      if (tag_severity.has_value()) {
+        return severity >= *tag_severity;
+      }
+    }
+  }
+  return severity >= gMinimumLogSeverity.load(std::memory_order_relaxed);
 }
 
 LogSeverity SetMinimumLogSeverity(LogSeverity new_severity) {
-  LogSeverity old_severity = gMinimumLogSeverity;
-  gMinimumLogSeverity = new_severity;
+  return gMinimumLogSeverity.exchange(new_severity, std::memory_order_relaxed);
+}
+
+std::optional<LogSeverity> SetMinimumLogSeverity(
+    std::string_view tag, std::optional<LogSeverity> new_severity) {
+  std::optional<LogSeverity> old_severity;
+  UpdateTagSettings([&](TagSettings& settings) {
+    auto& severities = settings.minimum_severities;
+    auto it =
+        std::find_if(severities.begin(), severities.end(),
+                     [&](const auto& entry) { return entry.first == tag; });
+    if (it != severities.end()) {
+      old_severity = it->second;
+      if (new_severity.has_value()) {
+        it->second = *new_severity;
+      } else {
+        severities.erase(it);
+      }
+    } else if (new_severity.has_value()) {
+      severities.emplace_back(tag, *new_severity);
+    }
+  });
   return old_severity;
 }
 
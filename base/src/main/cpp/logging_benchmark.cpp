@@ -0,0 +1,358 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks of the logging library. This is only built for the host (see
+// CMakeLists.txt).
+//
+// Usage: logging_benchmark [--messages=N] [--threads=N]
+//
+// Each benchmark logs --messages messages (100000 by default) from each of 1
+// and --threads threads (4 by default) with LOG(INFO), and writes one line to
+// stdout with the number of messages written per second, percentiles of the
+// time each LOG statement took in the calling thread, and the average number
+// of heap allocations made for each message, counted by replacing operator
+// new.
+//
+// The sink formats each message and writes it to /dev/null, which costs
+// about as much as writing to logd or stderr. It is called directly on the
+// logging thread ("sync"), or through an AsyncLogger that drops messages
+// when its queue is full ("async-drop") or waits for room ("async-block").
+// "logf-block" is the same as async-block, but logs with LOGF, which leaves
+// formatting the message to the AsyncLogger's thread. "file" logs straight to
+// a FileLogger writing to a temporary file instead. Throughput only counts
+// messages that reached the sink.
+//
+// The "filter" benchmark measures how many LOG statements per second are
+// skipped because their severity is too low, from 1 and max(8, --threads)
+// threads, while another thread keeps changing the minimum severity of a tag.
+// Each thread runs 100 times --messages statements.
+//
+// The "split" benchmarks measure SplitByLogdChunks, which LogdLogger uses to
+// break messages into lines and logd sized chunks, on multi-line messages of
+// about 100 B, 4 KB and 64 KB, each split --messages times on one thread.
+
+#include <base/async_logger.h>
+#include <base/file_logger.h>
+#include <base/format_logging.h>
+#include <base/logging.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "logging_splitters.h"
+
+using namespace ndksamples::base;
+
+namespace {
+
+std::atomic<uint64_t> gAllocations = 0;
+
+}  // namespace
+
+void* operator new(size_t size) {
+  gAllocations.fetch_add(1, std::memory_order_relaxed);
+  void* p = malloc(size == 0 ? 1 : size);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+namespace {
+
+struct Options {
+  uint32_t messages = 100000;
+  uint32_t threads = 4;
+};
+
+[[noreturn]] void Usage(std::string_view error) {
+  std::cerr << error << "\n"
+            << "usage: logging_benchmark [--messages=N] [--threads=N]\n";
+  exit(EXIT_FAILURE);
+}
+
+uint32_t ParseCount(std::string_view flag, std::string_view value) {
+  char* end = nullptr;
+  std::string str(value);
+  unsigned long result = strtoul(str.c_str(), &end, 10);
+  if (str.empty() || *end != '\0' || result == 0) {
+    Usage(std::format("invalid value for {}: {}", flag, value));
+  }
+  return static_cast<uint32_t>(result);
+}
+
+Options ParseOptions(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg = argv[i];
+    auto separator = arg.find('=');
+    if (!arg.starts_with("--") || separator == std::string_view::npos) {
+      Usage(std::format("unexpected argument: {}", arg));
+    }
+    std::string_view flag = arg.substr(0, separator);
+    std::string_view value = arg.substr(separator + 1);
+    if (flag == "--messages") {
+      options.messages = ParseCount(flag, value);
+    } else if (flag == "--threads") {
+      options.threads = ParseCount(flag, value);
+    } else {
+      Usage(std::format("unknown flag: {}", flag));
+    }
+  }
+  return options;
+}
+
+// A sink that formats messages like StderrLogger, but writes them to
+// /dev/null.
+class DevNullSink {
+ public:
+  DevNullSink(int fd, std::atomic<uint64_t>& written)
+      : fd_(fd), written_(written) {}
+
+  void operator()(LogId, LogSeverity severity, const char* tag,
+                  const char* file, unsigned int line, const char* message) {
+    char buffer[1024];
+    int size = snprintf(buffer, sizeof(buffer), "%s %c %5d %5d %s:%u] %s\n",
+                        tag, "VDIWEFF"[severity], getpid(), gettid(), file,
+                        line, message);
+    if (write(fd_, buffer, std::min<size_t>(size, sizeof(buffer))) >= 0) {
+      written_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+ private:
+  int fd_;
+  std::atomic<uint64_t>& written_;
+};
+
+enum class Mode { kSync, kAsyncDrop, kAsyncBlock, kLogfBlock, kFile };
+
+const char* ModeName(Mode mode) {
+  switch (mode) {
+    case Mode::kSync:
+      return "sync";
+    case Mode::kAsyncDrop:
+      return "async-drop";
+    case Mode::kAsyncBlock:
+      return "async-block";
+    case Mode::kLogfBlock:
+      return "logf-block";
+    case Mode::kFile:
+      return "file";
+  }
+  return "?";
+}
+
+void RunBenchmark(Mode mode, uint32_t threads, uint32_t messages,
+                  int dev_null) {
+  std::atomic<uint64_t> written = 0;
+  std::optional<AsyncLogger> async;
+  std::string file_path;
+  if (mode == Mode::kSync) {
+    SetLogger(DevNullSink(dev_null, written));
+  } else if (mode == Mode::kFile) {
+    const char* tmpdir = getenv("TMPDIR");
+    file_path = std::format("{}/logging_benchmark.XXXXXX",
+                            tmpdir != nullptr ? tmpdir : "/tmp");
+    const int fd = mkstemp(file_path.data());
+    if (fd == -1) PLOG(FATAL) << "mkstemp " << file_path;
+    close(fd);
+    std::optional<FileLogger> file = FileLogger::Open(file_path.c_str());
+    if (!file) LOG(FATAL) << "Failed to open " << file_path;
+    SetLogger([&written, file = *std::move(file)](
+                  LogId id, LogSeverity severity, const char* tag,
+                  const char* source, unsigned int line,
+                  const char* message) mutable {
+      file(id, severity, tag, source, line, message);
+      written.fetch_add(1, std::memory_order_relaxed);
+    });
+  } else {
+    AsyncLoggerOptions options;
+    options.overflow_policy = mode == Mode::kAsyncDrop
+                                  ? OverflowPolicy::kDrop
+                                  : OverflowPolicy::kBlock;
+    async.emplace(DevNullSink(dev_null, written), options);
+    SetLogger(AsyncLogger(*async));
+  }
+
+  // The time each LOG statement took, in nanoseconds.
+  std::vector<std::vector<uint64_t>> latencies(threads);
+  const uint64_t allocations_before = gAllocations.load();
+  auto begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (uint32_t t = 0; t < threads; t++) {
+    workers.emplace_back([&, t] {
+      std::vector<uint64_t>& thread_latencies = latencies[t];
+      thread_latencies.reserve(messages);
+      for (uint32_t i = 0; i < messages; i++) {
+        auto start = std::chrono::steady_clock::now();
+        if (mode == Mode::kLogfBlock) {
+          LOGF(INFO, "Rendered frame {} on thread {} in {} ms", i, t, 16.6);
+        } else {
+          LOG(INFO) << "Rendered frame " << i << " on thread " << t << " in "
+                    << 16.6 << " ms";
+        }
+        auto end = std::chrono::steady_clock::now();
+        thread_latencies.push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+                .count());
+      }
+    });
+  }
+  for (std::thread& worker : workers) worker.join();
+  uint64_t dropped = 0;
+  if (async) {
+    async->Flush();
+    dropped = async->dropped();
+  }
+  auto end = std::chrono::steady_clock::now();
+  const uint64_t allocations = gAllocations.load() - allocations_before;
+
+  // Stop the background thread before the next benchmark.
+  SetLogger(StderrLogger);
+  async.reset();
+  if (!file_path.empty()) unlink(file_path.c_str());
+
+  std::vector<uint64_t> all;
+  for (const std::vector<uint64_t>& thread_latencies : latencies) {
+    all.insert(all.end(), thread_latencies.begin(), thread_latencies.end());
+  }
+  std::sort(all.begin(), all.end());
+  auto percentile = [&](double fraction) {
+    return all[std::min(all.size() - 1,
+                        static_cast<size_t>(fraction * all.size()))];
+  };
+
+  std::chrono::duration<double> elapsed = end - begin;
+  std::cout << std::format(
+      "{:<11} {} threads: {:.0f} messages/s, caller ns (p50,p99,p99.9,max) = "
+      "({},{},{},{}), allocations/message {:.2f}, dropped {}\n",
+      ModeName(mode), threads, written.load() / elapsed.count(),
+      percentile(0.5), percentile(0.99), percentile(0.999), all.back(),
+      static_cast<double>(allocations) / (threads * messages), dropped);
+}
+
+void RunFilterBenchmark(uint32_t threads, uint32_t messages) {
+  static constexpr const char* kTag = "filter_benchmark";
+  std::atomic<bool> done = false;
+  std::thread writer([&] {
+    // Both levels filter out the DEBUG messages below.
+    for (uint32_t i = 0; !done.load(std::memory_order_relaxed); i++) {
+      SetMinimumLogSeverity(kTag, i % 2 ? INFO : ERROR);
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+
+  const uint64_t checks = uint64_t{messages} * 100;
+  auto begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (uint32_t t = 0; t < threads; t++) {
+    workers.emplace_back([&] {
+      for (uint64_t i = 0; i < checks; i++) {
+        // What LOG(DEBUG) expands to with a LOG_TAG of kTag. LOG_TAG has to be
+        // defined before logging.h is included, so it can't be set for just
+        // this benchmark.
+        if (ShouldLog(DEBUG, kTag)) {
+          LogMessage(__FILE__, __LINE__, DEBUG, kTag, -1).stream()
+              << "Filtered " << i;
+        }
+      }
+    });
+  }
+  for (std::thread& worker : workers) worker.join();
+  auto end = std::chrono::steady_clock::now();
+  done = true;
+  writer.join();
+
+  std::chrono::duration<double> elapsed = end - begin;
+  std::cout << std::format(
+      "{:<11} {} threads: {:.0f} checks/s, {:.0f} checks/s per thread\n",
+      "filter", threads, threads * checks / elapsed.count(),
+      checks / elapsed.count());
+}
+
+void RunSplitBenchmark(size_t size, uint32_t messages) {
+  // Lines like those of a stack dump.
+  std::string message;
+  for (int i = 0; message.size() < size; i++) {
+    message += std::format(
+        "      #{:02} pc {:016x}  /data/app/lib/arm64/libapp.so (Frame{}+{})\n",
+        i, i * 0x1234, i, i * 4);
+  }
+  message.resize(size);
+
+  uint64_t chunks = 0;
+  auto begin = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < messages; i++) {
+    SplitByLogdChunks(MAIN, INFO, "benchmark", __FILE__, __LINE__,
+                      message.c_str(),
+                      [&](LogId, LogSeverity, const char*, const char* chunk) {
+                        chunks += chunk[0] != '\0';
+                      });
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  std::chrono::duration<double> elapsed = end - begin;
+  std::cout << std::format(
+      "{:<11} {} bytes: {:.0f} messages/s, {:.0f} MB/s, "
+      "{:.2f} chunks/message\n",
+      "split", size, messages / elapsed.count(),
+      size * messages / elapsed.count() / 1e6,
+      static_cast<double>(chunks) / messages);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const Options options = ParseOptions(argc, argv);
+  const int dev_null = open("/dev/null", O_WRONLY | O_CLOEXEC);
+  if (dev_null == -1) {
+    PLOG(FATAL) << "open /dev/null";
+  }
+
+  std::vector<uint32_t> thread_counts = {1};
+  if (options.threads > 1) thread_counts.push_back(options.threads);
+
+  for (uint32_t threads : thread_counts) {
+    for (Mode mode : {Mode::kSync, Mode::kAsyncDrop, Mode::kAsyncBlock,
+                      Mode::kLogfBlock, Mode::kFile}) {
+      RunBenchmark(mode, threads, options.messages, dev_null);
+    }
+  }
+  for (uint32_t threads : {1u, std::max(options.threads, 8u)}) {
+    RunFilterBenchmark(threads, options.messages);
+  }
+  for (size_t size : {100, 4 * 1024, 64 * 1024}) {
+    RunSplitBenchmark(size, options.messages);
+  }
+  close(dev_null);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+
+#include "base/logging.h"
+#include "logging_platform.h"
+
+namespace ndksamples::base {
+
+const char* GetProgramName() { return program_invocation_short_name; }
+
+LogFunction DefaultLogger() { return StderrLogger; }
+
+// There's nowhere to put the message, but the aborter is passed it too, so it
+// can be written by a custom aborter.
+void SetAbortMessage(const char*) {}
+
+}  // namespace ndksamples::base
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// The parts of logging.cpp that differ between Android and other platforms.
+// CMakeLists.txt builds logging_android.cpp for Android and logging_host.cpp
+// for everything else.
+
+#include "base/logging.h"
+
+namespace ndksamples::base {
+
+// The default tag.
+const char* GetProgramName();
+
+// The logger used until SetLogger or InitLogging is called.
+LogFunction DefaultLogger();
+
+// Records the message that explains why the process is about to abort, for
+// crash reports.
+void SetAbortMessage(const char* message);
+
+}  // namespace ndksamples::base
@@ -17,9 +17,11 @@
 #pragma once
 
 #include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
 #include <time.h>
 
-#include <format>
+#include <algorithm>
 
 #include "base/logging.h"
 
@@ -33,11 +35,12 @@ namespace ndksamples::base {
 template <typename F, typename... Args>
 static void SplitByLines(const char* msg, const F& log_function,
                          Args&&... args) {
-  const char* newline = strchr(msg, '\n');
-  while (newline != nullptr) {
+  const char* end = msg + strlen(msg);
+  const char* newline;
+  while ((newline = static_cast<const char*>(memchr(msg, '\n', end - msg))) !=
+         nullptr) {
     log_function(msg, newline - msg, args...);
     msg = newline + 1;
-    newline = strchr(msg, '\n');
   }
 
   log_function(msg, -1, args...);
@@ -45,9 +48,12 @@ static void SplitByLines(const char* msg, const F& log_function,
 
 // This splits the message up into chunks that logs can process delimited by new
 // lines.  It calls log_function with the exact null terminated message that
-// should be sent to logd. Note, despite the loops and snprintf's, if severity
-// is not fatal and there are no new lines, this function simply calls
-// log_function with msg without any extra overhead.
+// should be sent to logd. If severity is not fatal and there are no new lines,
+// this function simply calls log_function with msg without any extra overhead.
+//
+// Otherwise the newlines are found with memchr, which libc vectorizes, and
+// the lines are copied into each chunk with memcpy, so long multi-line
+// messages such as stack dumps cost about as much as copying them.
 template <typename F>
 static void SplitByLogdChunks(LogId log_id, LogSeverity severity,
                               const char* tag, const char* file,
@@ -68,42 +74,46 @@ static void SplitByLogdChunks(LogId log_id, LogSeverity severity,
   bool add_file =
       file != nullptr && (severity == FATAL || severity == FATAL_WITHOUT_ABORT);
 
-  std::string file_header;
+  const char* const end = msg + strlen(msg);
+  const char* newline = static_cast<const char*>(memchr(msg, '\n', end - msg));
+  if (newline == nullptr && !add_file) {
+    log_function(log_id, severity, tag, msg);
+    return;
+  }
+
+  // The "file:line]" header that starts each line of a fatal message.
+  int file_header_size = 0;
   if (add_file) {
-    file_header = std::format("{}:{}]", file, line);
+    file_header_size = snprintf(nullptr, 0, "%s:%u]", file, line);
+  }
+  __attribute__((uninitialized)) char file_header[file_header_size + 1];
+  if (add_file) {
+    snprintf(file_header, sizeof(file_header), "%s:%u]", file, line);
   }
-  int file_header_size = file_header.size();
 
   __attribute__((uninitialized)) char logd_chunk[max_size + 1];
   ptrdiff_t chunk_position = 0;
 
   auto call_log_function = [&]() {
+    logd_chunk[chunk_position] = '\0';
     log_function(log_id, severity, tag, logd_chunk);
     chunk_position = 0;
   };
 
-  auto write_to_logd_chunk = [&](const char* message, int length) {
-    int size_written = 0;
-    const char* new_line = chunk_position > 0 ? "\n" : "";
-    if (add_file) {
-      size_written = snprintf(logd_chunk + chunk_position,
-                              sizeof(logd_chunk) - chunk_position, "%s%s%.*s",
-                              new_line, file_header.c_str(), length, message);
-    } else {
-      size_written = snprintf(logd_chunk + chunk_position,
-                              sizeof(logd_chunk) - chunk_position, "%s%.*s",
-                              new_line, length, message);
-    }
+  // Appends as much of data as fits in the chunk. A line too long to fit in
+  // an empty chunk is truncated.
+  auto append = [&](const char* data, ptrdiff_t size) {
+    size = std::min(size, max_size - chunk_position);
+    memcpy(logd_chunk + chunk_position, data, size);
+    chunk_position += size;
+  };
 
-    // This should never fail, if it does and we set size_written to 0, which
-    // will skip this line and move to the next one.
-    if (size_written < 0) {
-      size_written = 0;
-    }
-    chunk_position += size_written;
+  auto write_to_logd_chunk = [&](const char* message, ptrdiff_t length) {
+    if (chunk_position > 0) append("\n", 1);
+    append(file_header, file_header_size);
+    append(message, length);
   };
 
-  const char* newline = strchr(msg, '\n');
   while (newline != nullptr) {
     // If we have data in the buffer and this next line doesn't fit, write the
     // buffer.
@@ -118,15 +128,14 @@ static void SplitByLogdChunks(LogId log_id, LogSeverity severity,
     write_to_logd_chunk(msg, newline - msg);
 
     msg = newline + 1;
-    newline = strchr(msg, '\n');
+    newline = static_cast<const char*>(memchr(msg, '\n', end - msg));
   }
 
   // If we have left over data in the buffer and we can fit the rest of msg, add
   // it to the buffer then write the buffer.
   if (chunk_position != 0 &&
-      chunk_position + static_cast<int>(strlen(msg)) + 1 + file_header_size <=
-          max_size) {
-    write_to_logd_chunk(msg, -1);
+      chunk_position + (end - msg) + 1 + file_header_size <= max_size) {
+    write_to_logd_chunk(msg, end - msg);
     call_log_function();
   } else {
     // If the buffer is not empty and we can't fit the rest of msg into it,
@@ -136,9 +145,8 @@ static void SplitByLogdChunks(LogId log_id, LogSeverity severity,
     }
     // Then write the rest of the msg.
     if (add_file) {
-      snprintf(logd_chunk, sizeof(logd_chunk), "%s%s", file_header.c_str(),
-               msg);
-      log_function(log_id, severity, tag, logd_chunk);
+      write_to_logd_chunk(msg, end - msg);
+      call_log_function();
     } else {
       log_function(log_id, severity, tag, msg);
     }
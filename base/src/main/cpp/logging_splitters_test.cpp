@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "logging_splitters.h"
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace ndksamples::base {
+namespace {
+
+constexpr const char* kTag = "tag";
+
+// The most SplitByLogdChunks puts in one chunk for kTag.
+constexpr size_t kMaxChunkSize = LOGGER_ENTRY_MAX_PAYLOAD - 3 - 35;
+
+// Returns the chunks that SplitByLogdChunks passes to logd.
+std::vector<std::string> Split(LogSeverity severity, const std::string& msg) {
+  std::vector<std::string> chunks;
+  SplitByLogdChunks(MAIN, severity, kTag, "file.cpp", 42, msg.c_str(),
+                    [&](LogId id, LogSeverity chunk_severity, const char* tag,
+                        const char* chunk) {
+                      EXPECT_EQ(id, MAIN);
+                      EXPECT_EQ(chunk_severity, severity);
+                      EXPECT_STREQ(tag, kTag);
+                      chunks.push_back(chunk);
+                    });
+  return chunks;
+}
+
+// Returns the lines of msg, numbered so that a dropped or repeated line is
+// caught, each about size bytes long.
+std::string NumberedLines(int count, size_t size) {
+  std::string msg;
+  for (int i = 0; i < count; i++) {
+    if (i > 0) msg += '\n';
+    std::string line = std::to_string(i) + ' ';
+    line.resize(std::max(line.size(), size), 'x');
+    msg += line;
+  }
+  return msg;
+}
+
+// Joins chunks with newlines, which is how logcat shows them.
+std::string Join(const std::vector<std::string>& chunks) {
+  std::string joined;
+  for (const std::string& chunk : chunks) {
+    if (!joined.empty()) joined += '\n';
+    joined += chunk;
+  }
+  return joined;
+}
+
+TEST(SplitByLinesTest, Lines) {
+  std::vector<std::string> lines;
+  SplitByLines("a\n\nbc\n", [&](const char* line, int size) {
+    lines.push_back(size == -1 ? std::string(line) : std::string(line, size));
+  });
+  EXPECT_EQ(lines, (std::vector<std::string>{"a", "", "bc", ""}));
+}
+
+TEST(SplitByLogdChunksTest, SingleLine) {
+  EXPECT_EQ(Split(INFO, "message"), std::vector<std::string>{"message"});
+}
+
+TEST(SplitByLogdChunksTest, ShortLinesShareAChunk) {
+  EXPECT_EQ(Split(INFO, "a\nb\nc"), std::vector<std::string>{"a\nb\nc"});
+}
+
+// FATAL messages start every line with the file and line number.
+TEST(SplitByLogdChunksTest, FatalHeaders) {
+  for (LogSeverity severity : {FATAL_WITHOUT_ABORT, FATAL}) {
+    SCOPED_TRACE(severity);
+    EXPECT_EQ(Split(severity, "message"),
+              std::vector<std::string>{"file.cpp:42]message"});
+    EXPECT_EQ(Split(severity, "a\nb"),
+              std::vector<std::string>{"file.cpp:42]a\nfile.cpp:42]b"});
+  }
+}
+
+// Lines that exactly fill a chunk share it, and one more byte moves the last
+// line to the next chunk.
+TEST(SplitByLogdChunksTest, ChunkBoundary) {
+  const std::string first(kMaxChunkSize - 2, 'a');
+  EXPECT_EQ(Split(INFO, first + "\nb"),
+            std::vector<std::string>{first + "\nb"});
+  EXPECT_EQ(Split(INFO, first + "\nbc\nd"),
+            (std::vector<std::string>{first, "bc\nd"}));
+}
+
+// Many lines are split between chunks, without splitting any line.
+TEST(SplitByLogdChunksTest, ManyChunks) {
+  const std::string msg = NumberedLines(1000, 100);
+  const std::vector<std::string> chunks = Split(INFO, msg);
+  EXPECT_GT(chunks.size(), 20U);
+  for (const std::string& chunk : chunks) {
+    EXPECT_LE(chunk.size(), kMaxChunkSize);
+  }
+  EXPECT_EQ(Join(chunks), msg);
+}
+
+TEST(SplitByLogdChunksTest, ManyFatalChunks) {
+  const std::string msg = NumberedLines(1000, 100);
+  const std::vector<std::string> chunks = Split(FATAL, msg);
+  std::string expected;
+  for (size_t start = 0; start <= msg.size();) {
+    size_t newline = msg.find('\n', start);
+    if (newline == std::string::npos) newline = msg.size();
+    if (!expected.empty()) expected += '\n';
+    expected += "file.cpp:42]" + msg.substr(start, newline - start);
+    start = newline + 1;
+  }
+  for (const std::string& chunk : chunks) {
+    EXPECT_LE(chunk.size(), kMaxChunkSize);
+  }
+  EXPECT_EQ(Join(chunks), expected);
+}
+
+// A line too long for a chunk is truncated, except for the last line of a
+// message that isn't FATAL, which is passed on as is for logd to truncate.
+TEST(SplitByLogdChunksTest, LongLines) {
+  const std::string long_line(2 * kMaxChunkSize, 'x');
+  EXPECT_EQ(
+      Split(INFO, "first\n" + long_line + "\nlast"),
+      (std::vector<std::string>{"first", long_line.substr(0, kMaxChunkSize),
+                                "last"}));
+  EXPECT_EQ(Split(INFO, "first\n" + long_line),
+            (std::vector<std::string>{"first", long_line}));
+  EXPECT_EQ(Split(FATAL, "first\n" + long_line),
+            (std::vector<std::string>{
+                "file.cpp:42]first",
+                ("file.cpp:42]" + long_line).substr(0, kMaxChunkSize)}));
+}
+
+}  // namespace
+}  // namespace ndksamples::base
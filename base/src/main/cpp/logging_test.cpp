@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/logging.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ndksamples::base {
+namespace {
+
+TEST(TagSeverityTest, SetAndClear) {
+  EXPECT_EQ(GetMinimumLogSeverity("tag_severity_test"), std::nullopt);
+  EXPECT_EQ(SetMinimumLogSeverity("tag_severity_test", ERROR), std::nullopt);
+  EXPECT_EQ(GetMinimumLogSeverity("tag_severity_test"), ERROR);
+  EXPECT_FALSE(ShouldLog(WARNING, "tag_severity_test"));
+  EXPECT_TRUE(ShouldLog(ERROR, "tag_severity_test"));
+
+  EXPECT_EQ(SetMinimumLogSeverity("tag_severity_test", std::nullopt), ERROR);
+  EXPECT_EQ(GetMinimumLogSeverity("tag_severity_test"), std::nullopt);
+}
+
+// Every replaced TagSettings is freed, so this is mostly a test for sanitizers:
+// a reader that used a freed TagSettings would read freed memory.
+TEST(TagSeverityTest, ChangesWhileChecking) {
+  std::atomic<bool> done = false;
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; i++) {
+    readers.emplace_back([&] {
+      while (!done.load(std::memory_order_relaxed)) {
+        // Both levels filter out DEBUG and allow ERROR.
+        ASSERT_FALSE(ShouldLog(DEBUG, "tag_severity_test"));
+        ASSERT_TRUE(ShouldLog(ERROR, "tag_severity_test"));
+      }
+    });
+  }
+  for (int i = 0; i < 1000; i++) {
+    SetMinimumLogSeverity("tag_severity_test", i % 2 ? INFO : WARNING);
+  }
+  done = true;
+  for (std::thread& reader : readers) reader.join();
+  SetMinimumLogSeverity("tag_severity_test", std::nullopt);
+}
+
+// Each thread reads the settings through a slot of its own, which is reused
+// once the thread exits.
+TEST(TagSeverityTest, ChangesWhileThreadsExit) {
+  std::atomic<bool> done = false;
+  std::thread writer([&] {
+    for (int i = 0; !done.load(std::memory_order_relaxed); i++) {
+      SetMinimumLogSeverity("tag_severity_test", i % 2 ? INFO : WARNING);
+    }
+  });
+  for (int i = 0; i < 200; i++) {
+    std::thread([] {
+      EXPECT_FALSE(ShouldLog(DEBUG, "tag_severity_test"));
+      EXPECT_TRUE(ShouldLog(ERROR, "tag_severity_test"));
+    }).join();
+  }
+  done = true;
+  writer.join();
+  SetMinimumLogSeverity("tag_severity_test", std::nullopt);
+}
+
+// Messages logged without a tag get a copy of the default tag, so the logger
+// can change it while it's being used.
+TEST(DefaultTagTest, ChangeFromLogger) {
+  std::vector<std::string> tags;
+  LogFunction old_logger =
+      SetLogger([&](LogId, LogSeverity, const char* tag, const char*,
+                    unsigned int, const char*) {
+        tags.push_back(tag);
+        SetDefaultTag("changed_by_logger");
+      });
+  SetDefaultTag("default_tag_test");
+  LogMessage(__FILE__, __LINE__, INFO, nullptr, -1).stream() << "first";
+  LogMessage(__FILE__, __LINE__, INFO, nullptr, -1).stream() << "second";
+
+  const std::string long_tag(200, 'x');
+  SetDefaultTag(long_tag);
+  LogMessage(__FILE__, __LINE__, INFO, nullptr, -1).stream() << "long";
+
+  SetLogger(std::move(old_logger));
+  SetDefaultTag("");
+  EXPECT_EQ(tags, (std::vector<std::string>{"default_tag_test",
+                                            "changed_by_logger",
+                                            long_tag.substr(0, 127)}));
+}
+
+}  // namespace
+}  // namespace ndksamples::base
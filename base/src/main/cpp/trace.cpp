@@ -0,0 +1,346 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/trace.h"
+
+#if defined(__ANDROID__)
+#include <dlfcn.h>
+#endif
+#include <inttypes.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "base/logging.h"
+
+namespace ndksamples::base {
+
+std::atomic<uint32_t> trace_detail::gTraceFlags = 0;
+
+using trace_detail::gTraceFlags;
+using trace_detail::kATrace;
+using trace_detail::kRecording;
+
+namespace {
+
+struct TraceEvent {
+  int64_t timestamp_ns;
+  // The value of a counter.
+  int64_t value;
+  // Null for the end of a section.
+  const char* name;
+  // 'B', 'E' or 'C' for the beginning or end of a section, or a counter, as
+  // in the Chrome trace event format.
+  char phase;
+};
+
+// The events recorded by a single thread. Only that thread writes events, and
+// it publishes each one by incrementing size, so WriteChromeTrace can read the
+// events before size at any time.
+struct ThreadBuffer {
+  ThreadBuffer() : events(new TraceEvent[kTraceEventsPerThread]) {}
+
+  std::unique_ptr<TraceEvent[]> events;
+  // The session the events belong to. The thread discards its events when
+  // it sees that a new session has started.
+  std::atomic<uint32_t> session = 0;
+  std::atomic<size_t> size = 0;
+  // The number of events that didn't fit.
+  std::atomic<uint64_t> dropped = 0;
+  // The number of sections that have begun and not yet ended. Only used by
+  // the thread.
+  size_t open_sections = 0;
+
+  // These are guarded by TraceLock.
+  pid_t tid = 0;
+  bool in_use = false;
+};
+
+// Incremented by each StartTracing.
+std::atomic<uint32_t> gSession = 0;
+
+// Guards starting a session, reading the events of the current one, and
+// assigning buffers to threads.
+std::mutex& TraceLock() {
+  static auto& trace_lock = *new std::mutex();
+  return trace_lock;
+}
+
+// Every buffer, including those of threads that have exited. The buffer of an
+// exited thread is reused by a new thread once its events are no longer
+// needed.
+std::vector<ThreadBuffer*>& ThreadBuffers() {
+  static auto& buffers = *new std::vector<ThreadBuffer*>();
+  return buffers;
+}
+
+// These are trivially destructible, so they can still be used by thread_local
+// destructors that trace while the thread exits.
+thread_local ThreadBuffer* tls_buffer = nullptr;
+thread_local bool tls_exited = false;
+
+// Returns the thread's buffer to the pool when the thread exits.
+struct ThreadBufferReleaser {
+  ~ThreadBufferReleaser() {
+    std::lock_guard<std::mutex> lock(TraceLock());
+    tls_buffer->in_use = false;
+    tls_buffer = nullptr;
+    tls_exited = true;
+  }
+};
+thread_local ThreadBufferReleaser tls_releaser;
+
+// Returns the calling thread's buffer, or null if the thread is exiting.
+ThreadBuffer* GetThreadBuffer() {
+  if (LIKELY(tls_buffer != nullptr)) return tls_buffer;
+  if (tls_exited) return nullptr;
+
+  std::lock_guard<std::mutex> lock(TraceLock());
+  const uint32_t session = gSession.load(std::memory_order_relaxed);
+  ThreadBuffer* buffer = nullptr;
+  for (ThreadBuffer* unused : ThreadBuffers()) {
+    if (!unused->in_use &&
+        (unused->session.load(std::memory_order_relaxed) != session ||
+         unused->size.load(std::memory_order_relaxed) == 0)) {
+      buffer = unused;
+      break;
+    }
+  }
+  if (buffer == nullptr) {
+    buffer = new ThreadBuffer();
+    ThreadBuffers().push_back(buffer);
+  }
+  buffer->tid = gettid();
+  buffer->in_use = true;
+  buffer->open_sections = 0;
+  tls_buffer = buffer;
+  // Constructs tls_releaser, which registers its destructor.
+  (void)&tls_releaser;
+  return buffer;
+}
+
+int64_t NowNs() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// Returns false if the event was dropped.
+bool Record(char phase, const char* name, int64_t value) {
+  ThreadBuffer* buffer = GetThreadBuffer();
+  if (buffer == nullptr) return false;
+
+  const uint32_t session = gSession.load(std::memory_order_acquire);
+  if (buffer->session.load(std::memory_order_relaxed) != session) {
+    buffer->size.store(0, std::memory_order_relaxed);
+    buffer->dropped.store(0, std::memory_order_relaxed);
+    buffer->session.store(session, std::memory_order_release);
+  }
+
+  // Keep room for the end of every section that has begun, so that a full
+  // buffer drops whole sections rather than leaving one open. The end of a
+  // section always fits, since its room was kept when it began.
+  const size_t size = buffer->size.load(std::memory_order_relaxed);
+  size_t needed = buffer->open_sections + 1;
+  if (phase == 'B') needed++;
+  if (phase == 'E') needed--;
+  if (size + needed > kTraceEventsPerThread) {
+    buffer->dropped.store(buffer->dropped.load(std::memory_order_relaxed) + 1,
+                          std::memory_order_relaxed);
+    return false;
+  }
+  buffer->events[size] = {NowNs(), value, name, phase};
+  buffer->size.store(size + 1, std::memory_order_release);
+  if (phase == 'B') buffer->open_sections++;
+  if (phase == 'E') buffer->open_sections--;
+  return true;
+}
+
+#if defined(__ANDROID__)
+// The ATrace functions, which are looked up at runtime because they aren't
+// available on every API level this library supports.
+struct ATraceFunctions {
+  bool (*is_enabled)();
+  void (*begin_section)(const char* name);
+  void (*end_section)();
+  // Null before API 29.
+  void (*set_counter)(const char* name, int64_t value);
+};
+
+// Returns null if ATrace isn't available.
+const ATraceFunctions* GetATrace() {
+  static const ATraceFunctions* atrace = []() -> const ATraceFunctions* {
+    void* lib = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+    if (lib == nullptr) return nullptr;
+    auto* functions = new ATraceFunctions{
+        reinterpret_cast<bool (*)()>(dlsym(lib, "ATrace_isEnabled")),
+        reinterpret_cast<void (*)(const char*)>(
+            dlsym(lib, "ATrace_beginSection")),
+        reinterpret_cast<void (*)()>(dlsym(lib, "ATrace_endSection")),
+        reinterpret_cast<void (*)(const char*, int64_t)>(
+            dlsym(lib, "ATrace_setCounter")),
+    };
+    if (functions->is_enabled == nullptr ||
+        functions->begin_section == nullptr ||
+        functions->end_section == nullptr) {
+      delete functions;
+      return nullptr;
+    }
+    return functions;
+  }();
+  return atrace;
+}
+#endif
+
+}  // namespace
+
+bool EnableATrace() {
+#if defined(__ANDROID__)
+  if (GetATrace() != nullptr) {
+    gTraceFlags.fetch_or(kATrace, std::memory_order_relaxed);
+    return true;
+  }
+#endif
+  return false;
+}
+
+void StartTracing() {
+  std::lock_guard<std::mutex> lock(TraceLock());
+  gSession.fetch_add(1, std::memory_order_release);
+  gTraceFlags.fetch_or(kRecording, std::memory_order_relaxed);
+}
+
+void StopTracing() {
+  gTraceFlags.fetch_and(~kRecording, std::memory_order_relaxed);
+}
+
+uint32_t trace_detail::BeginSection(const char* name, uint32_t flags) {
+  uint32_t traced = 0;
+#if defined(__ANDROID__)
+  if ((flags & kATrace) != 0) {
+    const ATraceFunctions* atrace = GetATrace();
+    if (atrace->is_enabled()) {
+      atrace->begin_section(name);
+      traced |= kATrace;
+    }
+  }
+#endif
+  if ((flags & kRecording) != 0 && Record('B', name, 0)) {
+    traced |= kRecording;
+  }
+  return traced;
+}
+
+void trace_detail::EndSection(uint32_t flags) {
+  if ((flags & kRecording) != 0) {
+    Record('E', nullptr, 0);
+  }
+#if defined(__ANDROID__)
+  if ((flags & kATrace) != 0) {
+    GetATrace()->end_section();
+  }
+#endif
+}
+
+void trace_detail::Counter(const char* name, int64_t value) {
+  const uint32_t flags = gTraceFlags.load(std::memory_order_relaxed);
+#if defined(__ANDROID__)
+  if ((flags & kATrace) != 0) {
+    const ATraceFunctions* atrace = GetATrace();
+    if (atrace->set_counter != nullptr && atrace->is_enabled()) {
+      atrace->set_counter(name, value);
+    }
+  }
+#endif
+  if ((flags & kRecording) != 0) {
+    Record('C', name, value);
+  }
+}
+
+// Writes s as a JSON string.
+static void WriteJsonString(FILE* file, const char* s) {
+  fputc('"', file);
+  for (; *s != '\0'; s++) {
+    const unsigned char c = *s;
+    if (c == '"' || c == '\\') {
+      fputc('\\', file);
+      fputc(c, file);
+    } else if (c < 0x20) {
+      fprintf(file, "\\u%04x", c);
+    } else {
+      fputc(c, file);
+    }
+  }
+  fputc('"', file);
+}
+
+bool WriteChromeTrace(const char* path) {
+  FILE* file = fopen(path, "we");
+  if (file == nullptr) {
+    PLOG(ERROR) << "Failed to open " << path;
+    return false;
+  }
+
+  uint64_t dropped = 0;
+  {
+    std::lock_guard<std::mutex> lock(TraceLock());
+    const uint32_t session = gSession.load(std::memory_order_relaxed);
+    const pid_t pid = getpid();
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+    const char* separator = "\n";
+    for (const ThreadBuffer* buffer : ThreadBuffers()) {
+      if (buffer->session.load(std::memory_order_acquire) != session) {
+        continue;
+      }
+      const size_t size = buffer->size.load(std::memory_order_acquire);
+      for (size_t i = 0; i < size; i++) {
+        const TraceEvent& event = buffer->events[i];
+        fprintf(file, "%s{\"ph\":\"%c\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f",
+                separator, event.phase, pid, buffer->tid,
+                event.timestamp_ns / 1000.0);
+        if (event.name != nullptr) {
+          fputs(",\"name\":", file);
+          WriteJsonString(file, event.name);
+        }
+        if (event.phase == 'C') {
+          fprintf(file, ",\"args\":{\"value\":%" PRId64 "}", event.value);
+        }
+        fputc('}', file);
+        separator = ",\n";
+      }
+      dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    fputs("\n]}\n", file);
+  }
+
+  if (dropped != 0) {
+    LOG(WARNING) << path << " is missing " << dropped
+                 << " events that didn't fit in the trace buffers";
+  }
+  const bool failed = ferror(file) != 0;
+  if (fclose(file) != 0 || failed) {
+    PLOG(ERROR) << "Failed to write " << path;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace ndksamples::base
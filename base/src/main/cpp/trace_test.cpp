@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/trace.h"
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace ndksamples::base {
+namespace {
+
+class TraceTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    char path[] = "/tmp/trace_test.XXXXXX";
+    const int fd = mkstemp(path);
+    ASSERT_NE(fd, -1);
+    close(fd);
+    path_ = path;
+  }
+
+  void TearDown() override {
+    StopTracing();
+    unlink(path_.c_str());
+  }
+
+  // Writes the trace and returns the number of events of the given phase, or
+  // of every phase if phase is empty.
+  size_t CountEvents(std::optional<char> phase = {}) {
+    std::ifstream in(path_);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    const std::string trace = contents.str();
+    const std::string needle =
+        phase.has_value() ? std::string("\"ph\":\"") + *phase + '"' : "\"ph\":";
+    size_t count = 0;
+    for (size_t pos = trace.find(needle); pos != std::string::npos;
+         pos = trace.find(needle, pos + 1)) {
+      count++;
+    }
+    return count;
+  }
+
+  std::string path_;
+};
+
+TEST_F(TraceTest, RecordsSectionsAndCounters) {
+  StartTracing();
+  std::thread([] {
+    TRACE_SCOPE("outer");
+    {
+      TRACE_SCOPE("inner");
+      TRACE_COUNTER("counter", 42);
+    }
+  }).join();
+  StopTracing();
+  ASSERT_TRUE(WriteChromeTrace(path_.c_str()));
+
+  EXPECT_EQ(CountEvents('B'), 2U);
+  EXPECT_EQ(CountEvents('E'), 2U);
+  EXPECT_EQ(CountEvents('C'), 1U);
+}
+
+// A full buffer drops new sections and counters, but keeps room for the end
+// of every section that had already begun.
+TEST_F(TraceTest, FullBufferEndsEverySection) {
+  StartTracing();
+  std::thread([] {
+    TRACE_SCOPE("first");
+    TRACE_SCOPE("second");
+    TRACE_SCOPE("third");
+    for (size_t i = 0; i < kTraceEventsPerThread; i++) {
+      TRACE_COUNTER("counter", i);
+      TRACE_SCOPE("dropped");
+    }
+  }).join();
+  StopTracing();
+  ASSERT_TRUE(WriteChromeTrace(path_.c_str()));
+
+  const size_t begins = CountEvents('B');
+  EXPECT_GE(begins, 3U);
+  EXPECT_EQ(CountEvents('E'), begins);
+  EXPECT_EQ(CountEvents(), kTraceEventsPerThread);
+}
+
+}  // namespace
+}  // namespace ndksamples::base
@@ -0,0 +1,71 @@
+// Copyright (C) 2025 The Android Open Source Project
+// SPDX-License-Identifier: Apache-2.0
+
+#include "histogram.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+size_t LogLinearHistogram::BucketIndex(uint64_t value) {
+  value = std::min(value, (uint64_t{1} << kMaxValueBits) - 1);
+  if (value < kSubBuckets) return value;
+
+  // Values from 2^exponent up to 2^(exponent + 1) share a group of kSubBuckets
+  // buckets, each 2^(exponent - kSubBucketBits) wide.
+  const int exponent = 63 - __builtin_clzll(value);
+  const int shift = exponent - kSubBucketBits;
+  const uint64_t sub_bucket = (value >> shift) - kSubBuckets;
+  return (shift + 1) * kSubBuckets + sub_bucket;
+}
+
+uint64_t LogLinearHistogram::BucketUpperBound(size_t index) {
+  if (index < kSubBuckets) return index;
+
+  const int shift = static_cast<int>(index / kSubBuckets) - 1;
+  const uint64_t lower = (kSubBuckets + index % kSubBuckets) << shift;
+  return lower + (uint64_t{1} << shift) - 1;
+}
+
+void LogLinearHistogram::Record(uint64_t value_us) {
+  buckets_[BucketIndex(value_us)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+
+  uint64_t max = max_.load(std::memory_order_relaxed);
+  while (value_us > max &&
+         !max_.compare_exchange_weak(max, value_us,
+                                     std::memory_order_relaxed)) {
+  }
+}
+
+uint64_t LogLinearHistogram::Percentile(double fraction) const {
+  // Use the total of the buckets rather than count_, which may not match if
+  // values are being recorded concurrently.
+  std::array<uint64_t, kBuckets> counts;
+  uint64_t total = 0;
+  for (size_t i = 0; i < kBuckets; i++) {
+    counts[i] = buckets_[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+  if (total == 0) return 0;
+
+  const uint64_t target = std::clamp<uint64_t>(
+      static_cast<uint64_t>(ceil(fraction * static_cast<double>(total))), 1,
+      total);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBuckets; i++) {
+    seen += counts[i];
+    if (seen >= target) {
+      return std::min(BucketUpperBound(i), max());
+    }
+  }
+  return max();
+}
+
+void LogLinearHistogram::Reset() {
+  for (std::atomic<uint64_t>& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  count_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
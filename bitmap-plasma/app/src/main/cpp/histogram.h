@@ -0,0 +1,56 @@
+// Copyright (C) 2025 The Android Open Source Project
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+
+// A histogram of durations with a fixed amount of memory, which can be
+// recorded to and read from any number of threads without locks.
+//
+// Buckets are log-linear: values below 32 have a bucket each, and every power
+// of two above that is split into 32 equal buckets. Any value is therefore
+// reported to within 1/32 (about 3%), whatever its magnitude. Values are in
+// microseconds, and anything longer than about 71 minutes is counted in the
+// last bucket.
+//
+// Recording is a couple of relaxed atomic adds. Reads don't stop recording, so
+// a read that races with a recording may see it in some totals but not others.
+class LogLinearHistogram {
+ public:
+  // Counts one value.
+  void Record(uint64_t value_us);
+
+  // The number of values recorded.
+  uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+  // The largest value recorded, or 0 if there are none.
+  uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+  // Returns the smallest value that is at least the given fraction of the
+  // recorded values, for example 0.99 for the 99th percentile. The result is
+  // the upper bound of the bucket that the value fell in, but never more than
+  // the largest value recorded. Returns 0 if nothing has been recorded.
+  uint64_t Percentile(double fraction) const;
+
+  // Forgets every recorded value.
+  void Reset();
+
+ private:
+  static constexpr int kSubBucketBits = 5;
+  static constexpr uint64_t kSubBuckets = 1 << kSubBucketBits;
+  static constexpr int kMaxValueBits = 32;
+  static constexpr size_t kBuckets =
+      (kMaxValueBits - kSubBucketBits + 1) * kSubBuckets;
+
+  static size_t BucketIndex(uint64_t value);
+  static uint64_t BucketUpperBound(size_t index);
+
+  std::array<std::atomic<uint64_t>, kBuckets> buckets_ = {};
+  std::atomic<uint64_t> count_ = 0;
+  std::atomic<uint64_t> max_ = 0;
+};
@@ -0,0 +1,111 @@
+// Copyright (C) 2025 The Android Open Source Project
+// SPDX-License-Identifier: Apache-2.0
+
+#include "histogram.h"
+
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+namespace {
+
+constexpr uint64_t kMaxValue = (uint64_t{1} << 32) - 1;
+
+// Far above kMaxValue, so that it never caps a percentile below it.
+constexpr uint64_t kHuge = uint64_t{1} << 40;
+
+// The largest value in the same bucket as value, worked out from the
+// description of the buckets in histogram.h: exact below 32, and 32 buckets
+// per power of two above that.
+uint64_t ExpectedUpperBound(uint64_t value) {
+  if (value < 32) return value;
+  int exponent = 63;
+  while (!(value & (uint64_t{1} << exponent))) exponent--;
+  const uint64_t width = uint64_t{1} << (exponent - 5);
+  return value / width * width + width - 1;
+}
+
+// Returns the upper bound of the bucket that Record puts value in. value is
+// recorded with a larger one, so that the first half of the values is exactly
+// value's bucket and isn't capped by the largest value.
+uint64_t UpperBound(uint64_t value) {
+  LogLinearHistogram histogram;
+  histogram.Record(value);
+  histogram.Record(kHuge);
+  return histogram.Percentile(0.5);
+}
+
+TEST(LogLinearHistogramTest, Empty) {
+  LogLinearHistogram histogram;
+  EXPECT_EQ(histogram.count(), 0U);
+  EXPECT_EQ(histogram.max(), 0U);
+  EXPECT_EQ(histogram.Percentile(0), 0U);
+  EXPECT_EQ(histogram.Percentile(0.5), 0U);
+  EXPECT_EQ(histogram.Percentile(1), 0U);
+}
+
+// Values below 32 each have their own bucket.
+TEST(LogLinearHistogramTest, SmallValuesAreExact) {
+  for (uint64_t value = 0; value < 32; value++) {
+    EXPECT_EQ(UpperBound(value), value);
+  }
+}
+
+// Each power of two starts a new bucket, and the value before it ends one.
+TEST(LogLinearHistogramTest, PowerOfTwoBoundaries) {
+  for (int exponent = 5; exponent < 32; exponent++) {
+    SCOPED_TRACE(exponent);
+    const uint64_t power = uint64_t{1} << exponent;
+    EXPECT_EQ(UpperBound(power - 1), power - 1);
+    EXPECT_EQ(UpperBound(power), ExpectedUpperBound(power));
+    EXPECT_EQ(UpperBound(power + 1), ExpectedUpperBound(power + 1));
+    // Each bucket is within 1/32 of its values.
+    EXPECT_EQ(UpperBound(power), power + (power >> 5) - 1);
+  }
+}
+
+// Everything from 2^32 - 1 up shares the last bucket.
+TEST(LogLinearHistogramTest, ClampsLargeValues) {
+  EXPECT_EQ(UpperBound(kMaxValue), kMaxValue);
+
+  LogLinearHistogram histogram;
+  histogram.Record(kMaxValue + 1);
+  histogram.Record(kHuge);
+  histogram.Record(UINT64_MAX);
+  EXPECT_EQ(histogram.max(), UINT64_MAX);
+  EXPECT_EQ(histogram.Percentile(0), kMaxValue);
+  EXPECT_EQ(histogram.Percentile(1), kMaxValue);
+}
+
+// Percentile(0) is the smallest value's bucket and Percentile(1) is the
+// largest value's.
+TEST(LogLinearHistogramTest, ExtremePercentiles) {
+  LogLinearHistogram histogram;
+  for (uint64_t value : {7, 1000, 5000, 20000}) histogram.Record(value);
+  EXPECT_EQ(histogram.count(), 4U);
+  EXPECT_EQ(histogram.Percentile(0), 7U);
+  EXPECT_EQ(histogram.Percentile(0.25), 7U);
+  EXPECT_EQ(histogram.Percentile(0.5), ExpectedUpperBound(1000));
+  EXPECT_EQ(histogram.Percentile(0.75), ExpectedUpperBound(5000));
+  EXPECT_EQ(histogram.Percentile(1), 20000U);
+}
+
+// A percentile is never more than the largest value recorded, even though its
+// bucket goes higher.
+TEST(LogLinearHistogramTest, CapsAtMax) {
+  LogLinearHistogram histogram;
+  histogram.Record(1000);
+  ASSERT_GT(ExpectedUpperBound(1000), 1000U);
+  EXPECT_EQ(histogram.Percentile(0), 1000U);
+  EXPECT_EQ(histogram.Percentile(1), 1000U);
+}
+
+TEST(LogLinearHistogramTest, Reset) {
+  LogLinearHistogram histogram;
+  histogram.Record(1000);
+  histogram.Reset();
+  EXPECT_EQ(histogram.count(), 0U);
+  EXPECT_EQ(histogram.max(), 0U);
+  EXPECT_EQ(histogram.Percentile(1), 0U);
+}
+
+}  // namespace
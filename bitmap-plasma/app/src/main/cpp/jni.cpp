@@ -2,9 +2,10 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include <base/macros.h>
+#include <base/trace.h>
 #include <jni.h>
 
-#include "plasma.h"
+#include "plasma_jni.h"
 
 extern "C" JNIEXPORT jint JNI_OnLoad(JavaVM* _Nonnull vm, void* _Nullable) {
   JNIEnv* env;
@@ -12,15 +13,38 @@ extern "C" JNIEXPORT jint JNI_OnLoad(JavaVM* _Nonnull vm, void* _Nullable) {
     return JNI_ERR;
   }
 
+  // Shows the rendering in system traces.
+  ndksamples::base::EnableATrace();
+
   jclass c = env->FindClass("com/example/plasma/PlasmaView");
   if (c == nullptr) return JNI_ERR;
 
   static const JNINativeMethod methods[] = {
       {"renderPlasma", "(Landroid/graphics/Bitmap;J)V",
        reinterpret_cast<void*>(RenderPlasma)},
+      {"configureRendering", "(II)V",
+       reinterpret_cast<void*>(ConfigurePlasmaRendering)},
   };
   int rc = env->RegisterNatives(c, methods, arraysize(methods));
   if (rc != JNI_OK) return rc;
 
+  c = env->FindClass("com/example/plasma/Plasma");
+  if (c == nullptr) return JNI_ERR;
+
+  static const JNINativeMethod activity_methods[] = {
+      {"benchmarkPlasma", "(IIIZ)D", reinterpret_cast<void*>(BenchmarkPlasma)},
+  };
+  rc = env->RegisterNatives(c, activity_methods, arraysize(activity_methods));
+  if (rc != JNI_OK) return rc;
+
+  c = env->FindClass("com/example/plasma/FrameTimeStats");
+  if (c == nullptr) return JNI_ERR;
+
+  static const JNINativeMethod stats_methods[] = {
+      {"getFrameStats", "(Z)[D", reinterpret_cast<void*>(GetPlasmaFrameStats)},
+  };
+  rc = env->RegisterNatives(c, stats_methods, arraysize(stats_methods));
+  if (rc != JNI_OK) return rc;
+
   return JNI_VERSION_1_6;
 }
\ No newline at end of file
@@ -0,0 +1,58 @@
+// Copyright (C) 2025 The Android Open Source Project
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdint.h>
+
+#include <concepts>
+
+// The pixel formats that the plasma can be rendered in.
+//
+// Each format has the type of a single pixel, a name for logging, and FromRgb,
+// which converts an 8-bit per channel color to a pixel. Everything that
+// depends on the format is a template over one of these, so each format gets
+// its own copy of the inner loops with no per-pixel branching.
+template <typename T>
+concept PixelFormat = requires(int red, int green, int blue) {
+  typename T::Pixel;
+  { T::kName } -> std::convertible_to<const char*>;
+  { T::FromRgb(red, green, blue) } -> std::same_as<typename T::Pixel>;
+};
+
+// 16 bits per pixel: 5 bits of red, 6 of green, and 5 of blue, with red in the
+// high bits. ANDROID_BITMAP_FORMAT_RGB_565.
+struct Rgb565 {
+  using Pixel = uint16_t;
+  static constexpr const char* kName = "RGB_565";
+
+  static constexpr Pixel FromRgb(int red, int green, int blue) {
+    return (Pixel)(((red << 8) & 0xf800) | ((green << 3) & 0x07e0) |
+                   ((blue >> 3) & 0x001f));
+  }
+};
+
+// 32 bits per pixel, stored as the bytes red, green, blue, and alpha.
+// ANDROID_BITMAP_FORMAT_RGBA_8888. The plasma is opaque.
+struct Rgba8888 {
+  using Pixel = uint32_t;
+  static constexpr const char* kName = "RGBA_8888";
+
+  static constexpr Pixel FromRgb(int red, int green, int blue) {
+    // Android is always little-endian, so the first byte is the lowest.
+    return (Pixel)(red & 0xff) | ((Pixel)(green & 0xff) << 8) |
+           ((Pixel)(blue & 0xff) << 16) | 0xff000000u;
+  }
+};
+
+// 8 bits of alpha per pixel. ANDROID_BITMAP_FORMAT_A_8. Since there's no
+// color, the alpha is the luma of the color.
+struct Alpha8 {
+  using Pixel = uint8_t;
+  static constexpr const char* kName = "A_8";
+
+  static constexpr Pixel FromRgb(int red, int green, int blue) {
+    // BT.601 weights, scaled to sum to 256.
+    return (Pixel)((red * 77 + green * 150 + blue * 29) >> 8);
+  }
+};
@@ -14,29 +14,24 @@
  * limitations under the License.
  */
 
-#include <android/bitmap.h>
-#include <android/log.h>
-#include <jni.h>
+#include "plasma.h"
+
+#include <base/trace.h>
 #include <math.h>
-#include <stdio.h>
-#include <stdlib.h>
 #include <time.h>
 
-#define LOG_TAG "libplasma"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
-
-/* Set to 1 to enable debug log traces. */
-#define DEBUG 0
+#include <algorithm>
+#include <thread>
 
-/* Set to 1 to optimize memory stores when generating plasma. */
-#define OPTIMIZE_WRITES 1
+#include "histogram.h"
+#include "plasma_kernels.h"
+#include "worker_pool.h"
 
 /* Return current time in milliseconds */
 static double now_ms(void) {
-  struct timeval tv;
-  gettimeofday(&tv, NULL);
-  return tv.tv_sec * 1000. + tv.tv_usec / 1000.;
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000. + ts.tv_nsec / 1000000.;
 }
 
 /* We're going to perform computations for every pixel of the target
@@ -120,246 +115,242 @@ static __inline__ Fixed fixed_sin(Fixed f) {
 #error PALETTE_BITS must be smaller than FIXED_BITS
 #endif
 
-static uint16_t palette[PALETTE_SIZE];
+static_assert(PALETTE_SIZE == kPlasmaPaletteSize);
 
-static uint16_t make565(int red, int green, int blue) {
-  return (uint16_t)(((red << 8) & 0xf800) | ((green << 3) & 0x07e0) |
-                    ((blue >> 3) & 0x001f));
-}
+/* One palette for each pixel format, followed by the padding required by
+ * PlasmaRowKernel.
+ */
+template <PixelFormat Format>
+static typename Format::Pixel palette[PALETTE_SIZE + kPlasmaPalettePadding];
 
+template <PixelFormat Format>
 static void init_palette(void) {
   int nn, mm = 0;
   /* fun with colors */
   for (nn = 0; nn < PALETTE_SIZE / 4; nn++) {
     int jj = (nn - mm) * 4 * 255 / PALETTE_SIZE;
-    palette[nn] = make565(255, jj, 255 - jj);
+    palette<Format>[nn] = Format::FromRgb(255, jj, 255 - jj);
   }
 
   for (mm = nn; nn < PALETTE_SIZE / 2; nn++) {
     int jj = (nn - mm) * 4 * 255 / PALETTE_SIZE;
-    palette[nn] = make565(255 - jj, 255, jj);
+    palette<Format>[nn] = Format::FromRgb(255 - jj, 255, jj);
   }
 
   for (mm = nn; nn < PALETTE_SIZE * 3 / 4; nn++) {
     int jj = (nn - mm) * 4 * 255 / PALETTE_SIZE;
-    palette[nn] = make565(0, 255 - jj, 255);
+    palette<Format>[nn] = Format::FromRgb(0, 255 - jj, 255);
   }
 
   for (mm = nn; nn < PALETTE_SIZE; nn++) {
     int jj = (nn - mm) * 4 * 255 / PALETTE_SIZE;
-    palette[nn] = make565(jj, 0, 255);
+    palette<Format>[nn] = Format::FromRgb(jj, 0, 255);
   }
 }
 
-static __inline__ uint16_t palette_from_fixed(Fixed x) {
-  if (x < 0) x = -x;
-  if (x >= FIXED_ONE) x = FIXED_ONE - 1;
-  int idx = FIXED_FRAC(x) >> (FIXED_BITS - PALETTE_BITS);
-  return palette[idx & (PALETTE_SIZE - 1)];
-}
-
 /* Angles expressed as fixed point radians */
 
+/* Safe to call from any thread. The tables are only built by the first call. */
 static void init_tables(void) {
-  init_palette();
-  init_angles();
+  static const bool initialized = [] {
+    init_palette<Rgb565>();
+    init_palette<Rgba8888>();
+    init_palette<Alpha8>();
+    init_angles();
+    return true;
+  }();
+  (void)initialized;
 }
 
-static void fill_plasma(AndroidBitmapInfo* info, void* pixels, double t) {
-  Fixed yt1 = FIXED_FROM_FLOAT(t / 1230.);
-  Fixed yt2 = yt1;
-  Fixed xt10 = FIXED_FROM_FLOAT(t / 3000.);
-  Fixed xt20 = xt10;
+#define XT1_INCR FIXED_FROM_FLOAT(1 / 173.)
+#define XT2_INCR FIXED_FROM_FLOAT(1 / 242.)
 
 #define YT1_INCR FIXED_FROM_FLOAT(1 / 100.)
 #define YT2_INCR FIXED_FROM_FLOAT(1 / 163.)
 
-  for (uint32_t yy = 0; yy < info->height; yy++) {
-    uint16_t* line = (uint16_t*)pixels;
+/* The plasma value of a pixel is the sum of a term that only depends on its
+ * row and a term that only depends on its column. Rather than computing both
+ * sines of the column term for every pixel, compute the column terms once per
+ * frame and reuse them for every row.
+ */
+static void fill_column_terms(Fixed* terms, uint32_t width, double t) {
+  Fixed xt1 = FIXED_FROM_FLOAT(t / 3000.);
+  Fixed xt2 = xt1;
+
+  for (uint32_t xx = 0; xx < width; xx++) {
+    terms[xx] = fixed_sin(xt1) + fixed_sin(xt2);
+    xt1 += XT1_INCR;
+    xt2 += XT2_INCR;
+  }
+}
+
+/* Renders rows first_row through end_row - 1. column_terms holds the result of
+ * fill_column_terms for the frame, and kernel renders each row.
+ */
+template <PixelFormat Format>
+static void fill_plasma_rows(const PlasmaBuffer& buffer, double t,
+                             const Fixed* column_terms,
+                             const PlasmaKernel<Format>& kernel,
+                             uint32_t first_row, uint32_t end_row) {
+  /* Equivalent to stepping yt1 and yt2 through each of the rows above. */
+  Fixed yt1 = FIXED_FROM_FLOAT(t / 1230.) + (Fixed)(first_row * YT1_INCR);
+  Fixed yt2 = FIXED_FROM_FLOAT(t / 1230.) + (Fixed)(first_row * YT2_INCR);
+
+  char* pixels = (char*)buffer.pixels + (size_t)first_row * buffer.stride;
+  for (uint32_t yy = first_row; yy < end_row; yy++) {
+    typename Format::Pixel* line = (typename Format::Pixel*)pixels;
     Fixed base = fixed_sin(yt1) + fixed_sin(yt2);
-    Fixed xt1 = xt10;
-    Fixed xt2 = xt20;
 
     yt1 += YT1_INCR;
     yt2 += YT2_INCR;
 
-#define XT1_INCR FIXED_FROM_FLOAT(1 / 173.)
-#define XT2_INCR FIXED_FROM_FLOAT(1 / 242.)
-
-#if OPTIMIZE_WRITES
-    /* optimize memory writes by generating one aligned 32-bit store
-     * for every pair of pixels.
-     */
-    uint16_t* line_end = line + info->width;
-
-    if (line < line_end) {
-      if (((uint32_t)(uintptr_t)line & 3) != 0) {
-        Fixed ii = base + fixed_sin(xt1) + fixed_sin(xt2);
-
-        xt1 += XT1_INCR;
-        xt2 += XT2_INCR;
+    kernel.fill_row(line, buffer.width, base, column_terms, palette<Format>);
 
-        line[0] = palette_from_fixed(ii >> 2);
-        line++;
-      }
-
-      while (line + 2 <= line_end) {
-        Fixed i1 = base + fixed_sin(xt1) + fixed_sin(xt2);
-        xt1 += XT1_INCR;
-        xt2 += XT2_INCR;
-
-        Fixed i2 = base + fixed_sin(xt1) + fixed_sin(xt2);
-        xt1 += XT1_INCR;
-        xt2 += XT2_INCR;
-
-        uint32_t pixel = ((uint32_t)palette_from_fixed(i1 >> 2) << 16) |
-                         (uint32_t)palette_from_fixed(i2 >> 2);
-
-        ((uint32_t*)line)[0] = pixel;
-        line += 2;
-      }
-
-      if (line < line_end) {
-        Fixed ii = base + fixed_sin(xt1) + fixed_sin(xt2);
-        line[0] = palette_from_fixed(ii >> 2);
-        line++;
-      }
-    }
-#else  /* !OPTIMIZE_WRITES */
-    int xx;
-    for (xx = 0; xx < info->width; xx++) {
-      Fixed ii = base + fixed_sin(xt1) + fixed_sin(xt2);
+    // go to next line
+    pixels += buffer.stride;
+  }
+}
 
-      xt1 += XT1_INCR;
-      xt2 += XT2_INCR;
 
-      line[xx] = palette_from_fixed(ii / 4);
-    }
-#endif /* !OPTIMIZE_WRITES */
+/* Frames are split into bands of rows, which are rendered in parallel by a
+ * pool of threads. See PlasmaRenderer::Configure.
+ */
+#define DEFAULT_BAND_HEIGHT 32
 
-    // go to next line
-    pixels = (char*)pixels + info->stride;
+/* Calls fn with a value of the PixelFormat type for a PlasmaFormat, so that fn
+ * can be a generic lambda that is instantiated for every format. Returns false
+ * if the format isn't supported.
+ */
+template <typename Fn>
+static bool with_pixel_format(PlasmaFormat format, Fn&& fn) {
+  switch (format) {
+    case PlasmaFormat::kRgb565:
+      fn(Rgb565{});
+      return true;
+    case PlasmaFormat::kRgba8888:
+      fn(Rgba8888{});
+      return true;
+    case PlasmaFormat::kAlpha8:
+      fn(Alpha8{});
+      return true;
   }
+  return false;
 }
 
-/* simple stats management */
-typedef struct {
-  double renderTime;
-  double frameTime;
-} FrameStats;
-
-#define MAX_FRAME_STATS 200
-#define MAX_PERIOD_MS 1500
-
-typedef struct {
-  double firstTime;
-  double lastTime;
-  double frameTime;
-
-  int firstFrame;
-  int numFrames;
-  FrameStats frames[MAX_FRAME_STATS];
-} Stats;
-
-static void stats_init(Stats* s) {
-  s->lastTime = now_ms();
-  s->firstTime = 0.;
-  s->firstFrame = 0;
-  s->numFrames = 0;
+template <PixelFormat Format>
+static const PlasmaKernel<Format>& get_kernel(bool scalar) {
+  return scalar ? ScalarPlasmaKernel<Format>() : BestPlasmaKernel<Format>();
 }
 
-static void stats_startFrame(Stats* s) { s->frameTime = now_ms(); }
+const char* PlasmaFormatName(PlasmaFormat format) {
+  const char* name = nullptr;
+  with_pixel_format(format, [&](auto pixel_format) {
+    name = decltype(pixel_format)::kName;
+  });
+  return name;
+}
 
-static void stats_endFrame(Stats* s) {
-  double now = now_ms();
-  double renderTime = now - s->frameTime;
-  double frameTime = now - s->lastTime;
-  int nn;
+size_t PlasmaBytesPerPixel(PlasmaFormat format) {
+  size_t size = 0;
+  with_pixel_format(format, [&](auto pixel_format) {
+    size = sizeof(typename decltype(pixel_format)::Pixel);
+  });
+  return size;
+}
 
-  if (now - s->firstTime >= MAX_PERIOD_MS) {
-    if (s->numFrames > 0) {
-      double minRender, maxRender, avgRender;
-      double minFrame, maxFrame, avgFrame;
-      int count;
-
-      nn = s->firstFrame;
-      minRender = maxRender = avgRender = s->frames[nn].renderTime;
-      minFrame = maxFrame = avgFrame = s->frames[nn].frameTime;
-      for (count = s->numFrames; count > 0; count--) {
-        nn += 1;
-        if (nn >= MAX_FRAME_STATS) nn -= MAX_FRAME_STATS;
-        double render = s->frames[nn].renderTime;
-        if (render < minRender) minRender = render;
-        if (render > maxRender) maxRender = render;
-        double frame = s->frames[nn].frameTime;
-        if (frame < minFrame) minFrame = frame;
-        if (frame > maxFrame) maxFrame = frame;
-        avgRender += render;
-        avgFrame += frame;
-      }
-      avgRender /= s->numFrames;
-      avgFrame /= s->numFrames;
-
-      LOGI(
-          "frame/s (avg,min,max) = (%.1f,%.1f,%.1f) "
-          "render time ms (avg,min,max) = (%.1f,%.1f,%.1f)\n",
-          1000. / avgFrame, 1000. / maxFrame, 1000. / minFrame, avgRender,
-          minRender, maxRender);
-    }
-    s->numFrames = 0;
-    s->firstFrame = 0;
-    s->firstTime = now;
-  }
+const char* PlasmaKernelName(PlasmaFormat format, bool scalar) {
+  const char* name = nullptr;
+  with_pixel_format(format, [&](auto pixel_format) {
+    name = get_kernel<decltype(pixel_format)>(scalar).name;
+  });
+  return name;
+}
 
-  nn = s->firstFrame + s->numFrames;
-  if (nn >= MAX_FRAME_STATS) nn -= MAX_FRAME_STATS;
+PlasmaRenderer::PlasmaRenderer(uint32_t threads, uint32_t band_height) {
+  init_tables();
+  Configure(threads, band_height);
+}
 
-  s->frames[nn].renderTime = renderTime;
-  s->frames[nn].frameTime = frameTime;
+PlasmaRenderer::~PlasmaRenderer() = default;
 
-  if (s->numFrames < MAX_FRAME_STATS) {
-    s->numFrames += 1;
-  } else {
-    s->firstFrame += 1;
-    if (s->firstFrame >= MAX_FRAME_STATS) s->firstFrame -= MAX_FRAME_STATS;
+void PlasmaRenderer::Configure(uint32_t threads, uint32_t band_height) {
+  if (threads == 0) {
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  if (!pool_ || pool_->threads() != threads) {
+    pool_.reset();
+    pool_ = std::make_unique<WorkerPool>(threads);
   }
+  band_height_ = band_height > 0 ? band_height : DEFAULT_BAND_HEIGHT;
+}
 
-  s->lastTime = now;
+size_t PlasmaRenderer::threads() const { return pool_->threads(); }
+
+bool PlasmaRenderer::Render(const PlasmaBuffer& buffer, double time_ms,
+                            bool scalar) {
+  TRACE_SCOPE("PlasmaRenderer::Render");
+  return with_pixel_format(buffer.format, [&](auto pixel_format) {
+    using Format = decltype(pixel_format);
+    const PlasmaKernel<Format>& kernel = get_kernel<Format>(scalar);
+
+    column_terms_.resize(buffer.width);
+    fill_column_terms(column_terms_.data(), buffer.width, time_ms);
+
+    const uint32_t band_height = band_height_;
+    const uint32_t bands = (buffer.height + band_height - 1) / band_height;
+    band_times_.resize(bands);
+    pool_->Run(bands, [&](size_t band) {
+      TRACE_SCOPE("fill_plasma_rows");
+      double start = now_ms();
+      uint32_t first_row = (uint32_t)band * band_height;
+      uint32_t end_row = std::min(first_row + band_height, buffer.height);
+      fill_plasma_rows(buffer, time_ms, column_terms_.data(), kernel,
+                       first_row, end_row);
+      band_times_[band] = now_ms() - start;
+    });
+  });
 }
 
-void RenderPlasma(JNIEnv* env, jclass, jobject bitmap, jlong time_ms) {
-  AndroidBitmapInfo info;
-  void* pixels;
-  int ret;
-  static Stats stats;
-  static int init;
-
-  if (!init) {
-    init_tables();
-    stats_init(&stats);
-    init = 1;
-  }
+/* The animation time step between benchmark frames, as if running at 60 fps. */
+#define BENCHMARK_FRAME_MS 16
 
-  if ((ret = AndroidBitmap_getInfo(env, bitmap, &info)) < 0) {
-    LOGE("AndroidBitmap_getInfo() failed ! error=%d", ret);
-    return;
-  }
+std::optional<PlasmaBenchmarkResult> BenchmarkPlasmaRenderer(
+    PlasmaRenderer& renderer, const PlasmaBenchmarkOptions& options,
+    LogLinearHistogram* frame_times) {
+  const size_t pixel_size = PlasmaBytesPerPixel(options.format);
+  if (pixel_size == 0) return std::nullopt;
 
-  if (info.format != ANDROID_BITMAP_FORMAT_RGB_565) {
-    LOGE("Bitmap format is not RGB_565 !");
-    return;
-  }
-
-  if ((ret = AndroidBitmap_lockPixels(env, bitmap, &pixels)) < 0) {
-    LOGE("AndroidBitmap_lockPixels() failed ! error=%d", ret);
-  }
+  PlasmaBuffer buffer = {};
+  buffer.width = options.width;
+  buffer.height = options.height;
+  buffer.stride = options.width * pixel_size;
+  buffer.format = options.format;
 
-  stats_startFrame(&stats);
+  std::vector<char> pixels(buffer.stride * options.height);
+  buffer.pixels = pixels.data();
+  double t = 0.;
 
-  /* Now fill the values with a nice little plasma */
-  fill_plasma(&info, pixels, time_ms);
+  for (uint32_t nn = 0; nn < options.warmup_frames; nn++) {
+    renderer.Render(buffer, t, options.scalar);
+    t += BENCHMARK_FRAME_MS;
+  }
 
-  AndroidBitmap_unlockPixels(env, bitmap);
+  PlasmaBenchmarkResult result = {};
+  double start = now_ms();
+  double frame_start = start;
+  do {
+    renderer.Render(buffer, t, options.scalar);
+    t += BENCHMARK_FRAME_MS;
+    result.frames++;
+
+    double now = now_ms();
+    if (frame_times != nullptr) {
+      frame_times->Record((uint64_t)llround((now - frame_start) * 1000.));
+    }
+    frame_start = now;
+    result.elapsed_ms = now - start;
+  } while (result.frames < options.min_frames ||
+           result.elapsed_ms < options.min_ms);
 
-  stats_endFrame(&stats);
+  return result;
 }
@@ -3,6 +3,116 @@
 
 #pragma once
 
-#include <jni.h>
+#include <stddef.h>
+#include <stdint.h>
 
-void RenderPlasma(JNIEnv* env, jclass, jobject bitmap, jlong time_ms);
+#include <memory>
+#include <optional>
+#include <vector>
+
+// The plasma generator. Nothing here depends on Android, so that the same code
+// can be built for a Linux host and profiled without a device (see
+// plasma_main.cpp). plasma_jni.h adapts it to Android bitmaps.
+
+class LogLinearHistogram;
+class WorkerPool;
+
+// The pixel formats the plasma can be rendered in. The values are those of the
+// matching ANDROID_BITMAP_FORMAT, so an Android bitmap's format can be used as
+// is.
+enum class PlasmaFormat : int32_t {
+  kRgba8888 = 1,
+  kRgb565 = 4,
+  kAlpha8 = 8,
+};
+
+// Returns the name of a format for logging, for example "RGB_565", or nullptr
+// if format isn't one of the values above.
+const char* PlasmaFormatName(PlasmaFormat format);
+
+// Returns the size of a pixel of a format in bytes, or 0 if format isn't one of
+// the values above.
+size_t PlasmaBytesPerPixel(PlasmaFormat format);
+
+// Memory to render a frame into. Rows start stride bytes apart, which must be
+// at least width pixels.
+struct PlasmaBuffer {
+  void* pixels;
+  uint32_t width;
+  uint32_t height;
+  size_t stride;
+  PlasmaFormat format;
+};
+
+// Renders frames of plasma.
+//
+// Each frame is split into bands of rows, which are rendered in parallel by a
+// pool of threads. The thread that calls Render renders bands too. A renderer
+// renders one frame at a time, so callers on different threads must
+// synchronize.
+class PlasmaRenderer {
+ public:
+  // See Configure.
+  explicit PlasmaRenderer(uint32_t threads = 0, uint32_t band_height = 0);
+  ~PlasmaRenderer();
+
+  PlasmaRenderer(const PlasmaRenderer&) = delete;
+  PlasmaRenderer& operator=(const PlasmaRenderer&) = delete;
+
+  // Sets the number of threads that render each frame, counting the caller,
+  // and the height in rows of the bands that each frame is split into. Zero
+  // selects the default: one thread per CPU, and bands of 32 rows.
+  void Configure(uint32_t threads, uint32_t band_height);
+
+  size_t threads() const;
+  uint32_t band_height() const { return band_height_; }
+
+  // Renders the plasma at time_ms, in milliseconds since the start of the
+  // animation. If scalar is true, uses the portable kernel rather than the
+  // fastest one. Returns false, having rendered nothing, if the buffer's format
+  // isn't supported.
+  bool Render(const PlasmaBuffer& buffer, double time_ms, bool scalar = false);
+
+  // The render time of each band of the last frame, in milliseconds.
+  const std::vector<double>& band_times() const { return band_times_; }
+
+ private:
+  uint32_t band_height_;
+  std::unique_ptr<WorkerPool> pool_;
+  std::vector<int32_t> column_terms_;
+  std::vector<double> band_times_;
+};
+
+// Returns the name of the kernel that renders each row of a format, for example
+// "avx2", or nullptr if the format isn't supported. See Render for scalar.
+const char* PlasmaKernelName(PlasmaFormat format, bool scalar);
+
+struct PlasmaBenchmarkOptions {
+  uint32_t width = 1920;
+  uint32_t height = 1080;
+  PlasmaFormat format = PlasmaFormat::kRgb565;
+  bool scalar = false;
+
+  // Frames rendered before measuring, which are not counted.
+  uint32_t warmup_frames = 3;
+
+  // The minimum number of frames, and minimum time in milliseconds, to
+  // measure. Whichever takes longer wins.
+  uint32_t min_frames = 10;
+  double min_ms = 1000.;
+};
+
+struct PlasmaBenchmarkResult {
+  uint32_t frames;
+  double elapsed_ms;
+
+  double frames_per_second() const { return frames * 1000. / elapsed_ms; }
+};
+
+// Renders frames into an offscreen buffer, advancing the animation as if
+// running at 60 fps. If frame_times isn't null, the render time of each
+// measured frame is recorded in it, in microseconds. Returns nullopt if the
+// format isn't supported.
+std::optional<PlasmaBenchmarkResult> BenchmarkPlasmaRenderer(
+    PlasmaRenderer& renderer, const PlasmaBenchmarkOptions& options,
+    LogLinearHistogram* frame_times = nullptr);
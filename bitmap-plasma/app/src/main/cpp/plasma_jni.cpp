@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "plasma_jni.h"
+
+#include <android/bitmap.h>
+#include <android/log.h>
+#include <base/macros.h>
+#include <jni.h>
+#include <math.h>
+#include <sys/time.h>
+
+#include <algorithm>
+#include <mutex>
+
+#include "histogram.h"
+#include "plasma.h"
+
+#define LOG_TAG "libplasma"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+static_assert((int32_t)PlasmaFormat::kRgb565 == ANDROID_BITMAP_FORMAT_RGB_565);
+static_assert((int32_t)PlasmaFormat::kRgba8888 ==
+              ANDROID_BITMAP_FORMAT_RGBA_8888);
+static_assert((int32_t)PlasmaFormat::kAlpha8 == ANDROID_BITMAP_FORMAT_A_8);
+
+/* Return current time in milliseconds */
+static double now_ms(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000. + tv.tv_usec / 1000.;
+}
+
+/* The renderer for every bitmap. Only one frame is rendered at a time, so the
+ * lock is held while rendering.
+ */
+static std::mutex render_mutex;
+
+/* Requires render_mutex. The renderer's threads are started by the first call.
+ */
+static PlasmaRenderer& get_renderer(void) {
+  static PlasmaRenderer renderer;
+  return renderer;
+}
+
+void ConfigurePlasmaRendering(JNIEnv*, jclass, jint threads,
+                              jint band_height) {
+  std::lock_guard lock(render_mutex);
+  PlasmaRenderer& renderer = get_renderer();
+  renderer.Configure(threads > 0 ? (uint32_t)threads : 0,
+                     band_height > 0 ? (uint32_t)band_height : 0);
+  LOGI("Rendering with %u threads in bands of %u rows",
+       (uint32_t)renderer.threads(), renderer.band_height());
+}
+
+/* simple stats management */
+#define MAX_PERIOD_MS 1500
+
+/* The render time and frame time of every frame, in microseconds. */
+typedef struct {
+  LogLinearHistogram renderTime;
+  LogLinearHistogram frameTime;
+} FrameTimes;
+
+typedef struct {
+  double firstTime;
+  double lastTime;
+  double frameTime;
+
+  /* Every frame since the last report. */
+  FrameTimes period;
+
+  /* Render times of every band of every frame since the last report. */
+  double bandTimeTotal;
+  double minBandTime;
+  double maxBandTime;
+  int numBands;
+} Stats;
+
+/* Every frame since the library was loaded, or since GetPlasmaFrameStats was
+ * last asked to reset it.
+ */
+static FrameTimes all_frame_times;
+
+static uint64_t ms_to_us(double ms) {
+  return ms > 0. ? (uint64_t)llround(ms * 1000.) : 0;
+}
+
+static void stats_init(Stats* s) {
+  s->lastTime = now_ms();
+  s->firstTime = 0.;
+  s->numBands = 0;
+}
+
+static void stats_startFrame(Stats* s) { s->frameTime = now_ms(); }
+
+/* Logs the percentiles of a histogram of durations, in milliseconds. */
+static void log_percentiles(const char* name, const LogLinearHistogram& h) {
+  LOGI("%s ms (p50,p90,p99,p99.9,max) = (%.1f,%.1f,%.1f,%.1f,%.1f)", name,
+       h.Percentile(0.5) / 1000., h.Percentile(0.9) / 1000.,
+       h.Percentile(0.99) / 1000., h.Percentile(0.999) / 1000.,
+       h.max() / 1000.);
+}
+
+static void stats_endFrame(Stats* s, const double* bandTimes, int numBands) {
+  double now = now_ms();
+  uint64_t renderTime = ms_to_us(now - s->frameTime);
+  uint64_t frameTime = ms_to_us(now - s->lastTime);
+  int nn;
+
+  if (now - s->firstTime >= MAX_PERIOD_MS) {
+    if (s->period.frameTime.count() > 0) {
+      LOGI("frame/s (median) = %.1f over %llu frames",
+           1e6 / std::max<uint64_t>(s->period.frameTime.Percentile(0.5), 1),
+           (unsigned long long)s->period.frameTime.count());
+      log_percentiles("frame time", s->period.frameTime);
+      log_percentiles("render time", s->period.renderTime);
+    }
+    if (s->numBands > 0) {
+      LOGI("band render time ms (avg,min,max) = (%.2f,%.2f,%.2f) over %d bands",
+           s->bandTimeTotal / s->numBands, s->minBandTime, s->maxBandTime,
+           s->numBands);
+    }
+    s->period.renderTime.Reset();
+    s->period.frameTime.Reset();
+    s->numBands = 0;
+    s->firstTime = now;
+  }
+
+  for (nn = 0; nn < numBands; nn++) {
+    double band = bandTimes[nn];
+    if (s->numBands == 0) {
+      s->bandTimeTotal = 0.;
+      s->minBandTime = s->maxBandTime = band;
+    }
+    if (band < s->minBandTime) s->minBandTime = band;
+    if (band > s->maxBandTime) s->maxBandTime = band;
+    s->bandTimeTotal += band;
+    s->numBands += 1;
+  }
+
+  s->period.renderTime.Record(renderTime);
+  s->period.frameTime.Record(frameTime);
+  all_frame_times.renderTime.Record(renderTime);
+  all_frame_times.frameTime.Record(frameTime);
+
+  s->lastTime = now;
+}
+
+jdoubleArray GetPlasmaFrameStats(JNIEnv* env, jclass, jboolean reset) {
+  const LogLinearHistogram* histograms[] = {&all_frame_times.renderTime,
+                                            &all_frame_times.frameTime};
+  jdouble values[1 + 2 * 5];
+  values[0] = (jdouble)all_frame_times.frameTime.count();
+  jdouble* value = &values[1];
+  for (const LogLinearHistogram* h : histograms) {
+    *value++ = h->Percentile(0.5) / 1000.;
+    *value++ = h->Percentile(0.9) / 1000.;
+    *value++ = h->Percentile(0.99) / 1000.;
+    *value++ = h->Percentile(0.999) / 1000.;
+    *value++ = h->max() / 1000.;
+  }
+  if (reset) {
+    all_frame_times.renderTime.Reset();
+    all_frame_times.frameTime.Reset();
+  }
+
+  jdoubleArray array = env->NewDoubleArray(arraysize(values));
+  if (array == nullptr) return nullptr;
+  env->SetDoubleArrayRegion(array, 0, arraysize(values), values);
+  return array;
+}
+
+void RenderPlasma(JNIEnv* env, jclass, jobject bitmap, jlong time_ms) {
+  AndroidBitmapInfo info;
+  void* pixels;
+  int ret;
+  static Stats stats;
+  static int init;
+
+  if (!init) {
+    stats_init(&stats);
+    init = 1;
+  }
+
+  if ((ret = AndroidBitmap_getInfo(env, bitmap, &info)) < 0) {
+    LOGE("AndroidBitmap_getInfo() failed ! error=%d", ret);
+    return;
+  }
+
+  PlasmaBuffer buffer = {};
+  buffer.width = info.width;
+  buffer.height = info.height;
+  buffer.stride = info.stride;
+  buffer.format = (PlasmaFormat)info.format;
+  if (PlasmaFormatName(buffer.format) == nullptr) {
+    LOGE("Bitmap format %d is not supported !", info.format);
+    return;
+  }
+
+  if ((ret = AndroidBitmap_lockPixels(env, bitmap, &pixels)) < 0) {
+    LOGE("AndroidBitmap_lockPixels() failed ! error=%d", ret);
+    return;
+  }
+  buffer.pixels = pixels;
+
+  std::lock_guard lock(render_mutex);
+  PlasmaRenderer& renderer = get_renderer();
+  stats_startFrame(&stats);
+
+  /* Now fill the values with a nice little plasma */
+  renderer.Render(buffer, time_ms);
+
+  AndroidBitmap_unlockPixels(env, bitmap);
+
+  stats_endFrame(&stats, renderer.band_times().data(),
+                 (int)renderer.band_times().size());
+}
+
+jdouble BenchmarkPlasma(JNIEnv*, jclass, jint width, jint height, jint format,
+                        jboolean scalar) {
+  if (width <= 0 || height <= 0) {
+    LOGE("Invalid benchmark size %dx%d", width, height);
+    return 0.;
+  }
+
+  PlasmaBenchmarkOptions options;
+  options.width = (uint32_t)width;
+  options.height = (uint32_t)height;
+  options.format = (PlasmaFormat)format;
+  options.scalar = scalar;
+
+  std::lock_guard lock(render_mutex);
+  PlasmaRenderer& renderer = get_renderer();
+  std::optional<PlasmaBenchmarkResult> result =
+      BenchmarkPlasmaRenderer(renderer, options);
+  if (!result) {
+    LOGE("Bitmap format %d is not supported !", format);
+    return 0.;
+  }
+
+  double fps = result->frames_per_second();
+  LOGI("%ux%u %s %s, %u threads: %.1f frame/s (%.2f ms/frame)", options.width,
+       options.height, PlasmaFormatName(options.format),
+       PlasmaKernelName(options.format, options.scalar),
+       (uint32_t)renderer.threads(), fps, result->elapsed_ms / result->frames);
+  return fps;
+}
@@ -0,0 +1,31 @@
+// Copyright (C) 2025 The Android Open Source Project
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <jni.h>
+
+// The JNI side of the sample, which renders the plasma generator in plasma.h
+// into Android bitmaps.
+
+void RenderPlasma(JNIEnv* env, jclass, jobject bitmap, jlong time_ms);
+
+// Sets the number of threads that render each frame, counting the caller, and
+// the height in rows of the bands that each frame is split into. Zero or less
+// selects the default: one thread per CPU, and bands of 32 rows.
+void ConfigurePlasmaRendering(JNIEnv* env, jclass, jint threads,
+                              jint band_height);
+
+// Renders plasma frames into an offscreen buffer of the given size and
+// ANDROID_BITMAP_FORMAT for at least a second and returns the number of frames
+// rendered per second, or 0 if the format isn't supported. If scalar is true,
+// uses the portable kernel rather than the fastest one.
+jdouble BenchmarkPlasma(JNIEnv* env, jclass, jint width, jint height,
+                        jint format, jboolean scalar);
+
+// Returns the percentiles of the render time and frame time of every frame
+// rendered since the library was loaded, or since the last call that reset
+// them. The array holds the number of frames, then the p50, p90, p99, p99.9
+// and maximum render time, then the same for frame time, all in milliseconds.
+// If reset is true, the frames are forgotten after they are read.
+jdoubleArray GetPlasmaFrameStats(JNIEnv* env, jclass, jboolean reset);
@@ -0,0 +1,329 @@
+// Copyright (C) 2025 The Android Open Source Project
+// SPDX-License-Identifier: Apache-2.0
+
+#define LOG_TAG "libplasma"
+
+#include "plasma_kernels.h"
+
+#include <base/logging.h>
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/* Set to 1 to optimize memory stores when generating plasma. */
+#define OPTIMIZE_WRITES 1
+
+template <typename Pixel>
+static inline Pixel PlasmaPixel(int32_t base, int32_t term,
+                                const Pixel* palette) {
+  return palette[PlasmaPaletteIndex((base + term) >> 2)];
+}
+
+template <typename Pixel>
+static void FillRowScalar(Pixel* line, uint32_t width, int32_t base,
+                          const int32_t* terms, const Pixel* palette) {
+  if constexpr (OPTIMIZE_WRITES && sizeof(Pixel) == 2) {
+    /* optimize memory writes by generating one aligned 32-bit store
+     * for every pair of pixels. Android is always little-endian, so the first
+     * pixel goes in the low half.
+     */
+    Pixel* line_end = line + width;
+
+    if (line < line_end) {
+      if (((uint32_t)(uintptr_t)line & 3) != 0) {
+        line[0] = PlasmaPixel(base, *terms++, palette);
+        line++;
+      }
+
+      while (line + 2 <= line_end) {
+        uint32_t pixel = (uint32_t)PlasmaPixel(base, terms[0], palette) |
+                         ((uint32_t)PlasmaPixel(base, terms[1], palette) << 16);
+        terms += 2;
+
+        ((uint32_t*)line)[0] = pixel;
+        line += 2;
+      }
+
+      if (line < line_end) {
+        line[0] = PlasmaPixel(base, terms[0], palette);
+        line++;
+      }
+    }
+  } else {
+    for (uint32_t xx = 0; xx < width; xx++) {
+      line[xx] = PlasmaPixel(base, terms[xx], palette);
+    }
+  }
+}
+
+#if defined(__ARM_NEON)
+// Only vectorizes the index computation, and looks up the palette one pixel at
+// a time. Used where the palette doesn't fit in lookup tables.
+template <typename Pixel>
+static void FillRowNeonIndexed(Pixel* line, uint32_t width, int32_t base,
+                               const int32_t* terms, const Pixel* palette) {
+  const int32x4_t base_vec = vdupq_n_s32(base);
+  uint32_t xx = 0;
+  for (; xx + 8 <= width; xx += 8) {
+    uint16x4_t index16[2];
+    for (int part = 0; part < 2; part++) {
+      int32x4_t v = vaddq_s32(base_vec, vld1q_s32(terms + xx + part * 4));
+      uint32x4_t magnitude =
+          vreinterpretq_u32_s32(vabsq_s32(vshrq_n_s32(v, 2)));
+      index16[part] = vqmovn_u32(vshrq_n_u32(magnitude, 8));
+    }
+    uint16_t index[8];
+    vst1q_u16(index, vminq_u16(vcombine_u16(index16[0], index16[1]),
+                               vdupq_n_u16(kPlasmaPaletteSize - 1)));
+    for (int ii = 0; ii < 8; ii++) {
+      line[xx + ii] = palette[index[ii]];
+    }
+  }
+
+  for (; xx < width; xx++) {
+    line[xx] = PlasmaPixel(base, terms[xx], palette);
+  }
+}
+#endif
+
+#if defined(__aarch64__)
+// 16 pixels per step. The palette is split into one plane per byte of a pixel,
+// and each plane is looked up as four 64-byte tables, so four TBL/TBX
+// instructions per plane. One plane's tables fill 16 of the 32 vector
+// registers, so two planes' wouldn't leave room for anything else. Instead the
+// row is done in chunks: the indices of a chunk are computed once, and then
+// looked up one plane at a time, loading that plane's tables for each chunk.
+// This is only used for pixels of one or two bytes.
+template <typename Pixel>
+  requires(sizeof(Pixel) <= 2)
+static void FillRowNeonTable(Pixel* line, uint32_t width, int32_t base,
+                             const int32_t* terms, const Pixel* palette) {
+  constexpr int kPlanes = sizeof(Pixel);
+  constexpr uint32_t kChunkSize = 128;
+  alignas(16) uint8_t planes[kPlanes][kPlasmaPaletteSize];
+  for (size_t nn = 0; nn < kPlasmaPaletteSize; nn += 16) {
+    const uint8_t* entries = reinterpret_cast<const uint8_t*>(palette + nn);
+    if constexpr (kPlanes == 1) {
+      vst1q_u8(&planes[0][nn], vld1q_u8(entries));
+    } else {
+      const uint8x16x2_t bytes = vld2q_u8(entries);
+      vst1q_u8(&planes[0][nn], bytes.val[0]);
+      vst1q_u8(&planes[1][nn], bytes.val[1]);
+    }
+  }
+
+  const int32x4_t base_vec = vdupq_n_s32(base);
+  const uint8x16_t table_size = vdupq_n_u8(64);
+  uint32_t xx = 0;
+  while (width - xx >= 16) {
+    const uint32_t chunk = std::min(kChunkSize, (width - xx) & ~15u);
+    alignas(16) uint8_t indices[kChunkSize];
+    for (uint32_t ii = 0; ii < chunk; ii += 16) {
+      uint16x4_t index16[4];
+      for (int part = 0; part < 4; part++) {
+        int32x4_t v =
+            vaddq_s32(base_vec, vld1q_s32(terms + xx + ii + part * 4));
+        // abs(v >> 2) >> 8, narrowed with saturation. Saturating at 255 is the
+        // same as clamping to just below 1.0 before the shift.
+        uint32x4_t magnitude =
+            vreinterpretq_u32_s32(vabsq_s32(vshrq_n_s32(v, 2)));
+        index16[part] = vqmovn_u32(vshrq_n_u32(magnitude, 8));
+      }
+      vst1q_u8(&indices[ii],
+               vcombine_u8(vqmovn_u16(vcombine_u16(index16[0], index16[1])),
+                           vqmovn_u16(vcombine_u16(index16[2], index16[3]))));
+    }
+
+    // The first plane of two-byte pixels waits here to be interleaved with the
+    // second.
+    alignas(16) uint8_t low_bytes[kChunkSize];
+    for (int plane = 0; plane < kPlanes; plane++) {
+      uint8x16x4_t tables[4];
+      for (int table = 0; table < 4; table++) {
+        tables[table] = vld1q_u8_x4(&planes[plane][table * 64]);
+      }
+      for (uint32_t ii = 0; ii < chunk; ii += 16) {
+        // Indices outside of a table select zero from TBL and leave the lane
+        // unchanged for TBX, so each table only fills in its own quarter.
+        uint8x16_t index = vld1q_u8(&indices[ii]);
+        uint8x16_t bytes = vqtbl4q_u8(tables[0], index);
+        for (int table = 1; table < 4; table++) {
+          index = vsubq_u8(index, table_size);
+          bytes = vqtbx4q_u8(bytes, tables[table], index);
+        }
+
+        uint8_t* out = reinterpret_cast<uint8_t*>(line + xx + ii);
+        if constexpr (kPlanes == 1) {
+          vst1q_u8(out, bytes);
+        } else if (plane == 0) {
+          vst1q_u8(&low_bytes[ii], bytes);
+        } else {
+          const uint8x16x2_t pixels = {{vld1q_u8(&low_bytes[ii]), bytes}};
+          vst2q_u8(out, pixels);
+        }
+      }
+    }
+    xx += chunk;
+  }
+
+  for (; xx < width; xx++) {
+    line[xx] = PlasmaPixel(base, terms[xx], palette);
+  }
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+// SSE2 has no gathers, so this only vectorizes the index computation and looks
+// up the palette one pixel at a time. SSE2 also has no 32-bit abs or min, so
+// the absolute value is computed with the sign mask and the clamp is done after
+// narrowing to 16 bits.
+template <typename Pixel>
+static void FillRowSse2(Pixel* line, uint32_t width, int32_t base,
+                        const int32_t* terms, const Pixel* palette) {
+  const __m128i base_vec = _mm_set1_epi32(base);
+  const __m128i max_index = _mm_set1_epi16(kPlasmaPaletteSize - 1);
+  uint32_t xx = 0;
+  for (; xx + 8 <= width; xx += 8) {
+    __m128i index32[2];
+    for (int part = 0; part < 2; part++) {
+      __m128i v = _mm_add_epi32(
+          base_vec, _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+                        terms + xx + part * 4)));
+      v = _mm_srai_epi32(v, 2);
+      const __m128i sign = _mm_srai_epi32(v, 31);
+      v = _mm_sub_epi32(_mm_xor_si128(v, sign), sign);
+      index32[part] = _mm_srli_epi32(v, 8);
+    }
+    alignas(16) uint16_t index[8];
+    _mm_store_si128(reinterpret_cast<__m128i*>(index),
+                    _mm_min_epi16(_mm_packs_epi32(index32[0], index32[1]),
+                                  max_index));
+    for (int ii = 0; ii < 8; ii++) {
+      line[xx + ii] = palette[index[ii]];
+    }
+  }
+
+  for (; xx < width; xx++) {
+    line[xx] = PlasmaPixel(base, terms[xx], palette);
+  }
+}
+
+// 16 pixels per iteration, with the palette looked up by gathers. Each gather
+// loads 32 bits, so for smaller pixels the rest of each lane is the following
+// palette entries (or padding) and is masked off before narrowing.
+template <typename Pixel>
+[[gnu::target("avx2")]] static void FillRowAvx2(Pixel* line, uint32_t width,
+                                                int32_t base,
+                                                const int32_t* terms,
+                                                const Pixel* palette) {
+  const __m256i base_vec = _mm256_set1_epi32(base);
+  const __m256i max_magnitude = _mm256_set1_epi32((1 << 16) - 1);
+  const __m256i pixel_mask =
+      _mm256_set1_epi32((int)(0xffffffffu >> (32 - 8 * sizeof(Pixel))));
+  const int* table = reinterpret_cast<const int*>(palette);
+  uint32_t xx = 0;
+  for (; xx + 16 <= width; xx += 16) {
+    __m256i pixels32[2];
+    for (int part = 0; part < 2; part++) {
+      __m256i v = _mm256_add_epi32(
+          base_vec, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+                        terms + xx + part * 8)));
+      v = _mm256_min_epi32(_mm256_abs_epi32(_mm256_srai_epi32(v, 2)),
+                           max_magnitude);
+      const __m256i index = _mm256_srli_epi32(v, 8);
+      // Entry i is at byte offset i * sizeof(Pixel), so that's the scale.
+      pixels32[part] = _mm256_i32gather_epi32(table, index, sizeof(Pixel));
+    }
+
+    if constexpr (sizeof(Pixel) == 4) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(line + xx), pixels32[0]);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(line + xx + 8),
+                          pixels32[1]);
+    } else {
+      // packus works within 128-bit lanes, so put the quadwords back in order.
+      const __m256i pixels16 = _mm256_permute4x64_epi64(
+          _mm256_packus_epi32(_mm256_and_si256(pixels32[0], pixel_mask),
+                              _mm256_and_si256(pixels32[1], pixel_mask)),
+          0xd8);
+      if constexpr (sizeof(Pixel) == 2) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(line + xx), pixels16);
+      } else {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(line + xx),
+                         _mm_packus_epi16(_mm256_castsi256_si128(pixels16),
+                                          _mm256_extracti128_si256(pixels16,
+                                                                   1)));
+      }
+    }
+  }
+
+  for (; xx < width; xx++) {
+    line[xx] = PlasmaPixel(base, terms[xx], palette);
+  }
+}
+#endif
+
+template <PixelFormat Format>
+static constexpr PlasmaKernel<Format> kScalarKernel = {
+    "scalar", FillRowScalar<typename Format::Pixel>};
+
+template <PixelFormat Format>
+const PlasmaKernel<Format>& ScalarPlasmaKernel() {
+  return kScalarKernel<Format>;
+}
+
+template <PixelFormat Format>
+std::vector<PlasmaKernel<Format>> SupportedPlasmaKernels() {
+  using Pixel = Format::Pixel;
+  std::vector<PlasmaKernel<Format>> kernels;
+#if defined(__aarch64__)
+  if constexpr (sizeof(Pixel) <= 2) {
+    kernels.push_back({"neon", FillRowNeonTable<Pixel>});
+  } else {
+    kernels.push_back({"neon", FillRowNeonIndexed<Pixel>});
+  }
+#elif defined(__ARM_NEON)
+  kernels.push_back({"neon", FillRowNeonIndexed<Pixel>});
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+  if (__builtin_cpu_supports("avx2")) {
+    kernels.push_back({"avx2", FillRowAvx2<Pixel>});
+  }
+  kernels.push_back({"sse2", FillRowSse2<Pixel>});
+#endif
+  return kernels;
+}
+
+template <PixelFormat Format>
+const PlasmaKernel<Format>& BestPlasmaKernel() {
+  static const PlasmaKernel<Format> best = [] {
+    const std::vector<PlasmaKernel<Format>> kernels =
+        SupportedPlasmaKernels<Format>();
+    const PlasmaKernel<Format> kernel =
+        kernels.empty() ? kScalarKernel<Format> : kernels.front();
+    LOG(INFO) << "Using the " << kernel.name << " plasma kernel for "
+              << Format::kName;
+    return kernel;
+  }();
+  return best;
+}
+
+template const PlasmaKernel<Rgb565>& ScalarPlasmaKernel<Rgb565>();
+template const PlasmaKernel<Rgba8888>& ScalarPlasmaKernel<Rgba8888>();
+template const PlasmaKernel<Alpha8>& ScalarPlasmaKernel<Alpha8>();
+
+template std::vector<PlasmaKernel<Rgb565>> SupportedPlasmaKernels<Rgb565>();
+template std::vector<PlasmaKernel<Rgba8888>>
+SupportedPlasmaKernels<Rgba8888>();
+template std::vector<PlasmaKernel<Alpha8>> SupportedPlasmaKernels<Alpha8>();
+
+template const PlasmaKernel<Rgb565>& BestPlasmaKernel<Rgb565>();
+template const PlasmaKernel<Rgba8888>& BestPlasmaKernel<Rgba8888>();
+template const PlasmaKernel<Alpha8>& BestPlasmaKernel<Alpha8>();
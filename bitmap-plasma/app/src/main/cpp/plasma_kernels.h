@@ -0,0 +1,67 @@
+// Copyright (C) 2025 The Android Open Source Project
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "pixel_format.h"
+
+// The number of entries in the plasma palette.
+inline constexpr size_t kPlasmaPaletteSize = 256;
+
+// The number of entries of padding that must follow the palette. This lets
+// the gather kernel load any entry as a 32-bit value, whatever the size of a
+// pixel.
+inline constexpr size_t kPlasmaPalettePadding = 3;
+
+// Returns the index of the palette entry for a plasma value, in 16.16 fixed
+// point. The palette is indexed by the magnitude of the value, clamped to just
+// below 1.0.
+inline uint32_t PlasmaPaletteIndex(int32_t x) {
+  if (x < 0) x = -x;
+  if (x >= (1 << 16)) x = (1 << 16) - 1;
+  return static_cast<uint32_t>(x) >> 8;
+}
+
+// Renders one row of plasma.
+//
+// Pixel x is palette[PlasmaPaletteIndex((base + terms[x]) >> 2)], where base
+// is the row's term of the plasma and terms holds the term of each column.
+//
+// palette must have kPlasmaPaletteSize + kPlasmaPalettePadding entries.
+template <typename Pixel>
+using PlasmaRowKernel = void (*)(Pixel* line, uint32_t width, int32_t base,
+                                 const int32_t* terms, const Pixel* palette);
+
+template <PixelFormat Format>
+struct PlasmaKernel {
+  // A short name for logging, for example "avx2".
+  const char* name;
+  PlasmaRowKernel<typename Format::Pixel> fill_row;
+};
+
+// Returns the portable kernel, which is always available. Every other kernel
+// must produce exactly the same pixels as this one.
+//
+// Defined for Rgb565, Rgba8888 and Alpha8.
+template <PixelFormat Format>
+const PlasmaKernel<Format>& ScalarPlasmaKernel();
+
+// Returns every kernel other than the scalar one that this CPU supports,
+// fastest first. plasma_kernels_test.cpp checks each of them against the
+// scalar kernel.
+//
+// Defined for Rgb565, Rgba8888 and Alpha8.
+template <PixelFormat Format>
+std::vector<PlasmaKernel<Format>> SupportedPlasmaKernels();
+
+// Returns the fastest kernel that this CPU supports, which is the first of
+// SupportedPlasmaKernels, or the scalar kernel if there are none.
+//
+// Defined for Rgb565, Rgba8888 and Alpha8.
+template <PixelFormat Format>
+const PlasmaKernel<Format>& BestPlasmaKernel();
@@ -0,0 +1,80 @@
+// Copyright (C) 2025 The Android Open Source Project
+// SPDX-License-Identifier: Apache-2.0
+
+#include "plasma_kernels.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+template <typename Format>
+class PlasmaKernelTest : public testing::Test {};
+
+using Formats = testing::Types<Rgb565, Rgba8888, Alpha8>;
+TYPED_TEST_SUITE(PlasmaKernelTest, Formats);
+
+// Checks every kernel this CPU supports against the scalar kernel. The row and
+// column terms are each the sum of two sines, so their sum is within +/-4.0.
+// One row covers every value in that range, starting at an odd pixel to catch
+// alignment problems, and a second row checks a nonzero base with a width that
+// leaves a remainder.
+TYPED_TEST(PlasmaKernelTest, MatchesScalar) {
+  using Pixel = TypeParam::Pixel;
+  constexpr int32_t kMaxValue = 4 << 16;
+  const uint32_t width = 2 * kMaxValue + 1;
+  std::vector<int32_t> terms(width);
+  for (uint32_t xx = 0; xx < width; xx++) {
+    terms[xx] = static_cast<int32_t>(xx) - kMaxValue;
+  }
+
+  // Every entry is different, even for 8-bit pixels.
+  Pixel palette[kPlasmaPaletteSize + kPlasmaPalettePadding];
+  for (size_t nn = 0; nn < kPlasmaPaletteSize + kPlasmaPalettePadding; nn++) {
+    palette[nn] = static_cast<Pixel>(nn * 0x01010101u + 1);
+  }
+
+  const std::vector<PlasmaKernel<TypeParam>> kernels =
+      SupportedPlasmaKernels<TypeParam>();
+  if (kernels.empty()) GTEST_SKIP() << "Only the scalar kernel is supported";
+
+  std::vector<Pixel> expected(width + 1);
+  std::vector<Pixel> actual(width + 1);
+  const struct {
+    int32_t base;
+    uint32_t width;
+  } rows[] = {{0, width}, {-12345, 1000 - 3}};
+  for (const PlasmaKernel<TypeParam>& kernel : kernels) {
+    SCOPED_TRACE(kernel.name);
+    for (const auto& row : rows) {
+      SCOPED_TRACE(row.base);
+      const int32_t* row_terms = terms.data() + (width - row.width) / 2;
+      ScalarPlasmaKernel<TypeParam>().fill_row(expected.data() + 1, row.width,
+                                               row.base, row_terms, palette);
+      kernel.fill_row(actual.data() + 1, row.width, row.base, row_terms,
+                      palette);
+      const auto [expected_end, actual_end] =
+          std::mismatch(expected.begin() + 1, expected.begin() + 1 + row.width,
+                        actual.begin() + 1);
+      EXPECT_EQ(expected_end, expected.begin() + 1 + row.width)
+          << "first mismatch at x = " << (expected_end - expected.begin() - 1)
+          << ": expected " << +*expected_end << ", got " << +*actual_end;
+    }
+  }
+}
+
+// BestPlasmaKernel is the fastest supported kernel.
+TYPED_TEST(PlasmaKernelTest, BestIsFastestSupported) {
+  const std::vector<PlasmaKernel<TypeParam>> kernels =
+      SupportedPlasmaKernels<TypeParam>();
+  const PlasmaKernel<TypeParam>& best = BestPlasmaKernel<TypeParam>();
+  if (kernels.empty()) {
+    EXPECT_EQ(best.fill_row, ScalarPlasmaKernel<TypeParam>().fill_row);
+  } else {
+    EXPECT_EQ(best.fill_row, kernels.front().fill_row);
+  }
+}
+
+}  // namespace
@@ -0,0 +1,241 @@
+// Copyright (C) 2025 The Android Open Source Project
+// SPDX-License-Identifier: Apache-2.0
+
+// Command line driver for the plasma generator. This is only built for the host
+// (see CMakeLists.txt), so the generator can be profiled and checked in CI
+// without an Android device.
+//
+// Usage: plasma_benchmark [--size=WIDTHxHEIGHT]
+//            [--format=RGB_565|RGBA_8888|A_8] [--frames=N] [--warmup=N]
+//            [--threads=N] [--band-height=N] [--scalar=0|1] [--dump=PATH]
+//            [--dump-time=MS] [--trace=PATH]
+//
+// Renders --frames frames into memory (1920x1080 RGB_565 and 100 frames by
+// default) and writes one line to stdout with the frame rate, the pixel
+// throughput and the render time percentiles. Logs go to stderr.
+// --threads and --band-height are as for PlasmaRenderer::Configure.
+// --scalar=1 uses the portable kernel rather than the fastest one.
+// --dump=PATH also writes the frame at --dump-time milliseconds (0 by default)
+// to PATH, as a binary PPM for RGB_565 and RGBA_8888 or a PGM for A_8. The
+// file only depends on the size, format and time, so it can be compared
+// byte for byte with a golden image.
+// --trace=PATH records the benchmark with TRACE_SCOPE and writes it to PATH as
+// a Chrome trace, which can be opened with https://ui.perfetto.dev.
+
+#include <base/trace.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "histogram.h"
+#include "plasma.h"
+
+namespace {
+
+struct Options {
+  PlasmaBenchmarkOptions benchmark;
+  uint32_t threads = 0;
+  uint32_t band_height = 0;
+  std::optional<std::string> dump;
+  double dump_time_ms = 0.;
+  std::optional<std::string> trace;
+};
+
+constexpr PlasmaFormat kFormats[] = {
+    PlasmaFormat::kRgb565,
+    PlasmaFormat::kRgba8888,
+    PlasmaFormat::kAlpha8,
+};
+
+[[noreturn]] void Usage(std::string_view error) {
+  std::cerr << error << "\n"
+            << "usage: plasma_benchmark [--size=WIDTHxHEIGHT] "
+               "[--format=RGB_565|RGBA_8888|A_8] [--frames=N] [--warmup=N] "
+               "[--threads=N] [--band-height=N] [--scalar=0|1] [--dump=PATH] "
+               "[--dump-time=MS] [--trace=PATH]\n";
+  exit(EXIT_FAILURE);
+}
+
+uint32_t ParseCount(std::string_view flag, std::string_view value) {
+  char* end = nullptr;
+  std::string str(value);
+  unsigned long result = strtoul(str.c_str(), &end, 10);
+  if (str.empty() || *end != '\0') {
+    Usage("invalid value for " + std::string(flag) + ": " + str);
+  }
+  return static_cast<uint32_t>(result);
+}
+
+PlasmaFormat ParseFormat(std::string_view value) {
+  for (PlasmaFormat format : kFormats) {
+    if (value == PlasmaFormatName(format)) return format;
+  }
+  Usage("unknown format: " + std::string(value));
+}
+
+Options ParseOptions(int argc, char** argv) {
+  Options options;
+  options.benchmark.min_frames = 100;
+  options.benchmark.min_ms = 0.;
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg = argv[i];
+    auto separator = arg.find('=');
+    if (!arg.starts_with("--") || separator == std::string_view::npos) {
+      Usage("unexpected argument: " + std::string(arg));
+    }
+    std::string_view flag = arg.substr(0, separator);
+    std::string_view value = arg.substr(separator + 1);
+    if (flag == "--size") {
+      auto x = value.find('x');
+      if (x == std::string_view::npos) {
+        Usage("invalid value for --size: " + std::string(value));
+      }
+      options.benchmark.width = ParseCount(flag, value.substr(0, x));
+      options.benchmark.height = ParseCount(flag, value.substr(x + 1));
+      if (options.benchmark.width == 0 || options.benchmark.height == 0) {
+        Usage("--size must be at least 1x1");
+      }
+    } else if (flag == "--format") {
+      options.benchmark.format = ParseFormat(value);
+    } else if (flag == "--frames") {
+      options.benchmark.min_frames = ParseCount(flag, value);
+      if (options.benchmark.min_frames == 0) {
+        Usage("--frames must be at least 1");
+      }
+    } else if (flag == "--warmup") {
+      options.benchmark.warmup_frames = ParseCount(flag, value);
+    } else if (flag == "--threads") {
+      options.threads = ParseCount(flag, value);
+    } else if (flag == "--band-height") {
+      options.band_height = ParseCount(flag, value);
+    } else if (flag == "--scalar") {
+      if (value != "0" && value != "1") {
+        Usage("invalid value for --scalar: " + std::string(value));
+      }
+      options.benchmark.scalar = value == "1";
+    } else if (flag == "--dump") {
+      options.dump = value;
+    } else if (flag == "--dump-time") {
+      options.dump_time_ms = ParseCount(flag, value);
+    } else if (flag == "--trace") {
+      options.trace = value;
+    } else {
+      Usage("unknown flag: " + std::string(flag));
+    }
+  }
+  return options;
+}
+
+// Expands a channel of bits bits to 8 bits, so that 0 and the maximum map to 0
+// and 255.
+uint8_t ExpandChannel(uint32_t value, int bits) {
+  return static_cast<uint8_t>((value << (8 - bits)) |
+                              (value >> (2 * bits - 8)));
+}
+
+// Writes a frame as a binary PPM, or a PGM for A_8. Returns false on error.
+bool WriteFrame(const std::string& path, const PlasmaBuffer& buffer) {
+  const bool gray = buffer.format == PlasmaFormat::kAlpha8;
+  const size_t channels = gray ? 1 : 3;
+  std::vector<uint8_t> row(buffer.width * channels);
+
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == nullptr) return false;
+  fprintf(file, "%s\n%u %u\n255\n", gray ? "P5" : "P6", buffer.width,
+          buffer.height);
+
+  for (uint32_t y = 0; y < buffer.height; y++) {
+    const char* line =
+        static_cast<const char*>(buffer.pixels) + y * buffer.stride;
+    uint8_t* out = row.data();
+    for (uint32_t x = 0; x < buffer.width; x++) {
+      switch (buffer.format) {
+        case PlasmaFormat::kRgb565: {
+          const uint16_t pixel = reinterpret_cast<const uint16_t*>(line)[x];
+          *out++ = ExpandChannel(pixel >> 11, 5);
+          *out++ = ExpandChannel((pixel >> 5) & 0x3f, 6);
+          *out++ = ExpandChannel(pixel & 0x1f, 5);
+          break;
+        }
+        case PlasmaFormat::kRgba8888: {
+          // Drop the alpha, which is always opaque.
+          const uint8_t* pixel =
+              reinterpret_cast<const uint8_t*>(line) + x * 4;
+          *out++ = pixel[0];
+          *out++ = pixel[1];
+          *out++ = pixel[2];
+          break;
+        }
+        case PlasmaFormat::kAlpha8:
+          *out++ = static_cast<uint8_t>(line[x]);
+          break;
+      }
+    }
+    fwrite(row.data(), 1, row.size(), file);
+  }
+  const bool ok = !ferror(file);
+  return fclose(file) == 0 && ok;
+}
+
+// Renders the frame for --dump and writes it. Returns false on error.
+bool DumpFrame(PlasmaRenderer& renderer, const Options& options) {
+  PlasmaBuffer buffer = {};
+  buffer.width = options.benchmark.width;
+  buffer.height = options.benchmark.height;
+  buffer.stride = buffer.width * PlasmaBytesPerPixel(options.benchmark.format);
+  buffer.format = options.benchmark.format;
+
+  std::vector<char> pixels(buffer.stride * buffer.height);
+  buffer.pixels = pixels.data();
+  renderer.Render(buffer, options.dump_time_ms, options.benchmark.scalar);
+
+  if (!WriteFrame(*options.dump, buffer)) {
+    perror(options.dump->c_str());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const Options options = ParseOptions(argc, argv);
+  PlasmaRenderer renderer(options.threads, options.band_height);
+
+  if (options.trace) ndksamples::base::StartTracing();
+  LogLinearHistogram frame_times;
+  const std::optional<PlasmaBenchmarkResult> result =
+      BenchmarkPlasmaRenderer(renderer, options.benchmark, &frame_times);
+  if (options.trace) {
+    ndksamples::base::StopTracing();
+    if (!ndksamples::base::WriteChromeTrace(options.trace->c_str())) {
+      return EXIT_FAILURE;
+    }
+  }
+  if (!result) {
+    std::cerr << "format not supported\n";
+    return EXIT_FAILURE;
+  }
+
+  const PlasmaBenchmarkOptions& benchmark = options.benchmark;
+  const double pixels = static_cast<double>(benchmark.width) * benchmark.height;
+  printf(
+      "%ux%u %s %s, %zu threads: %u frames in %.1f ms, %.1f frame/s, "
+      "%.1f Mpixel/s, ms (p50,p90,p99,max) = (%.2f,%.2f,%.2f,%.2f)\n",
+      benchmark.width, benchmark.height, PlasmaFormatName(benchmark.format),
+      PlasmaKernelName(benchmark.format, benchmark.scalar), renderer.threads(),
+      result->frames, result->elapsed_ms, result->frames_per_second(),
+      result->frames_per_second() * pixels / 1e6,
+      frame_times.Percentile(0.5) / 1000., frame_times.Percentile(0.9) / 1000.,
+      frame_times.Percentile(0.99) / 1000., frame_times.max() / 1000.);
+
+  if (options.dump && !DumpFrame(renderer, options)) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
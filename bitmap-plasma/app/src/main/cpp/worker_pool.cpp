@@ -0,0 +1,91 @@
+// Copyright (C) 2025 The Android Open Source Project
+// SPDX-License-Identifier: Apache-2.0
+
+#include "worker_pool.h"
+
+WorkerPool::WorkerPool(size_t threads) {
+  for (size_t i = 1; i < threads; i++) {
+    workers_.emplace_back(&WorkerPool::WorkerLoop, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  work_ready_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+void WorkerPool::Run(size_t count, const std::function<void(size_t)>& task) {
+  if (count == 0) return;
+
+  std::lock_guard run_lock(run_mutex_);
+  if (workers_.empty()) {
+    for (size_t i = 0; i < count; i++) task(i);
+    return;
+  }
+
+  {
+    std::lock_guard lock(mutex_);
+    task_ = &task;
+    task_count_ = count;
+    tasks_remaining_ = count;
+    next_task_.store(0, std::memory_order_relaxed);
+    generation_++;
+  }
+  work_ready_.notify_all();
+
+  RunTasks();
+
+  // Also wait for every thread to stop looking at this batch, so that none of
+  // them can take a task from the next one using this batch's task.
+  std::unique_lock lock(mutex_);
+  work_done_.wait(lock,
+                  [this] { return tasks_remaining_ == 0 && active_ == 0; });
+  task_ = nullptr;
+}
+
+void WorkerPool::WorkerLoop() {
+  uint64_t seen_generation = 0;
+  while (true) {
+    {
+      std::unique_lock lock(mutex_);
+      work_ready_.wait(lock, [&] {
+        return stopping_ || generation_ != seen_generation;
+      });
+      if (stopping_) return;
+      seen_generation = generation_;
+    }
+    RunTasks();
+  }
+}
+
+void WorkerPool::RunTasks() {
+  const std::function<void(size_t)>* task;
+  size_t count;
+  {
+    std::lock_guard lock(mutex_);
+    if (task_ == nullptr) return;
+    task = task_;
+    count = task_count_;
+    active_++;
+  }
+
+  size_t finished = 0;
+  for (size_t i = next_task_.fetch_add(1, std::memory_order_relaxed);
+       i < count; i = next_task_.fetch_add(1, std::memory_order_relaxed)) {
+    (*task)(i);
+    finished++;
+  }
+
+  std::lock_guard lock(mutex_);
+  tasks_remaining_ -= finished;
+  active_--;
+  if (tasks_remaining_ == 0 && active_ == 0) {
+    work_done_.notify_one();
+  }
+}
@@ -0,0 +1,68 @@
+// Copyright (C) 2025 The Android Open Source Project
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of threads that run batches of independent tasks.
+//
+// The threads are started once and wait between batches, so running a batch
+// only costs a wakeup rather than a thread creation. The thread that calls Run
+// works on the batch too, so a pool of N threads starts N - 1 workers.
+class WorkerPool {
+ public:
+  // Creates a pool of threads threads, counting the caller of Run. A pool of
+  // one thread (or zero) runs every task on the caller.
+  explicit WorkerPool(size_t threads);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  // The number of threads that run tasks, counting the caller of Run.
+  size_t threads() const { return workers_.size() + 1; }
+
+  // Runs task(0) through task(count - 1) and returns when they've all
+  // finished. Tasks are handed out in order to whichever thread is free, so
+  // they may run in any order and on any thread. Concurrent calls are run one
+  // at a time.
+  void Run(size_t count, const std::function<void(size_t)>& task);
+
+ private:
+  void WorkerLoop();
+
+  // Runs tasks from the current batch until there are none left.
+  void RunTasks();
+
+  std::vector<std::thread> workers_;
+
+  // Serializes calls to Run.
+  std::mutex run_mutex_;
+
+  // Guards everything below except next_task_.
+  std::mutex mutex_;
+  std::condition_variable work_ready_;
+  std::condition_variable work_done_;
+  bool stopping_ = false;
+
+  // Incremented for every batch, so that workers can tell a new batch from a
+  // spurious wakeup.
+  uint64_t generation_ = 0;
+  const std::function<void(size_t)>* task_ = nullptr;
+  size_t task_count_ = 0;
+  size_t tasks_remaining_ = 0;
+
+  // The number of threads in RunTasks.
+  size_t active_ = 0;
+
+  std::atomic<size_t> next_task_ = 0;
+};
@@ -0,0 +1,48 @@
+// Copyright (C) 2025 The Android Open Source Project
+// SPDX-License-Identifier: Apache-2.0
+
+#include "worker_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Runs many batches back to back with varying sizes. Every task of a batch runs
+// exactly once, and only while that batch is the current one: a worker that
+// was slow to leave one batch must not pick up a task of the next.
+TEST(WorkerPoolTest, RunsEachTaskOnceInItsBatch) {
+  for (size_t threads : {1, 2, 3, 4, 8}) {
+    SCOPED_TRACE(threads);
+    WorkerPool pool(threads);
+    ASSERT_EQ(pool.threads(), threads);
+
+    std::atomic<size_t> current_batch = 0;
+    std::atomic<size_t> misplaced_tasks = 0;
+    for (size_t batch = 1; batch <= 500; batch++) {
+      // Includes empty batches, batches of one, and batches with fewer tasks
+      // than threads.
+      const size_t count = (batch * 7) % 41;
+      std::vector<std::atomic<int>> runs(count);
+      current_batch.store(batch);
+      pool.Run(count, [&, batch](size_t i) {
+        if (current_batch.load() != batch) misplaced_tasks++;
+        runs[i]++;
+        // Keep some tasks busy so that threads finish at different times.
+        if (i % 3 == 0) std::this_thread::yield();
+        if (current_batch.load() != batch) misplaced_tasks++;
+      });
+      current_batch.store(0);
+
+      for (size_t i = 0; i < count; i++) {
+        ASSERT_EQ(runs[i].load(), 1) << "batch " << batch << ", task " << i;
+      }
+    }
+    EXPECT_EQ(misplaced_tasks.load(), 0U);
+  }
+}
+
+}  // namespace
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package com.example.plasma;
+
+// Percentiles of the time taken by the frames that the plasma has rendered.
+//
+// Render time is the time spent rendering the plasma into the bitmap. Frame
+// time is the time from the end of one frame to the end of the next. All
+// times are in milliseconds, and are accurate to about 3%.
+public final class FrameTimeStats {
+    public final long frames;
+
+    public final double renderP50Ms;
+    public final double renderP90Ms;
+    public final double renderP99Ms;
+    public final double renderP999Ms;
+    public final double renderMaxMs;
+
+    public final double frameP50Ms;
+    public final double frameP90Ms;
+    public final double frameP99Ms;
+    public final double frameP999Ms;
+    public final double frameMaxMs;
+
+    private FrameTimeStats(double[] values) {
+        frames = (long) values[0];
+        renderP50Ms = values[1];
+        renderP90Ms = values[2];
+        renderP99Ms = values[3];
+        renderP999Ms = values[4];
+        renderMaxMs = values[5];
+        frameP50Ms = values[6];
+        frameP90Ms = values[7];
+        frameP99Ms = values[8];
+        frameP999Ms = values[9];
+        frameMaxMs = values[10];
+    }
+
+    // Returns the stats for every frame since the app started, or since the
+    // last call with reset set. Polling with reset set gives the stats for
+    // each polling interval. Safe to call from any thread.
+    public static FrameTimeStats poll(boolean reset) {
+        return new FrameTimeStats(getFrameStats(reset));
+    }
+
+    @Override public String toString() {
+        return String.format(
+            "%d frames, render ms (p50,p90,p99,p99.9,max) = "
+                + "(%.1f,%.1f,%.1f,%.1f,%.1f), frame ms = "
+                + "(%.1f,%.1f,%.1f,%.1f,%.1f)",
+            frames, renderP50Ms, renderP90Ms, renderP99Ms, renderP999Ms,
+            renderMaxMs, frameP50Ms, frameP90Ms, frameP99Ms, frameP999Ms,
+            frameMaxMs);
+    }
+
+    // implementend by libplasma.so
+    private static native double[] getFrameStats(boolean reset);
+
+    static {
+        System.loadLibrary("plasma");
+    }
+}
@@ -23,22 +23,99 @@ import android.content.Context;
 import android.view.View;
 import android.graphics.Bitmap;
 import android.graphics.Canvas;
+import android.util.Log;
 import android.view.Display;
 import android.view.WindowManager;
+import android.widget.TextView;
 
 public class Plasma extends Activity
 {
+    private static final String TAG = "Plasma";
+
+    // Launch with this boolean extra set to benchmark the renderer instead of
+    // showing the animation:
+    // adb shell am start -n com.example.plasma/.Plasma --ez benchmark true
+    private static final String EXTRA_BENCHMARK = "benchmark";
+
+    // Integer extras that set the number of threads that render each frame,
+    // and the height of the bands of rows that each frame is split into. Zero
+    // or unset uses the defaults.
+    private static final String EXTRA_THREADS = "threads";
+    private static final String EXTRA_BAND_HEIGHT = "band_height";
+
+    // A string extra that sets the Bitmap.Config of the animation: RGB_565
+    // (the default), ARGB_8888 or ALPHA_8.
+    private static final String EXTRA_FORMAT = "format";
+
+    // Bitmap sizes to benchmark: 720p, 1080p and 4K.
+    private static final int[][] BENCHMARK_SIZES = {
+        {1280, 720}, {1920, 1080}, {3840, 2160},
+    };
+
+    // Pixel formats to benchmark, as the ANDROID_BITMAP_FORMAT values from
+    // <android/bitmap.h>, and their names.
+    private static final int[] BENCHMARK_FORMATS = {4, 1, 8};
+    private static final String[] BENCHMARK_FORMAT_NAMES = {
+        "RGB_565", "RGBA_8888", "A_8",
+    };
+
     // Called when the activity is first created.
     @Override
     public void onCreate(Bundle savedInstanceState)
     {
         super.onCreate(savedInstanceState);
+        PlasmaView.configureRendering(
+            getIntent().getIntExtra(EXTRA_THREADS, 0),
+            getIntent().getIntExtra(EXTRA_BAND_HEIGHT, 0));
+        if (getIntent().getBooleanExtra(EXTRA_BENCHMARK, false)) {
+            runBenchmarks();
+            return;
+        }
+        String format = getIntent().getStringExtra(EXTRA_FORMAT);
+        Bitmap.Config config = format == null
+            ? Bitmap.Config.RGB_565 : Bitmap.Config.valueOf(format);
         Display display = getWindowManager().getDefaultDisplay();
         Point displaySize = new Point();
         display.getSize(displaySize);
-        setContentView(new PlasmaView(this, displaySize.x, displaySize.y));
+        setContentView(
+            new PlasmaView(this, displaySize.x, displaySize.y, config));
+    }
+
+    // Runs the benchmarks on a background thread, then shows the results.
+    private void runBenchmarks() {
+        final TextView text = new TextView(this);
+        text.setText("Benchmarking...");
+        setContentView(text);
+        new Thread(new Runnable() {
+            @Override public void run() {
+                final StringBuilder results = new StringBuilder();
+                for (int[] size : BENCHMARK_SIZES) {
+                    for (int ii = 0; ii < BENCHMARK_FORMATS.length; ii++) {
+                        for (boolean scalar : new boolean[] {true, false}) {
+                            double fps = benchmarkPlasma(size[0], size[1],
+                                BENCHMARK_FORMATS[ii], scalar);
+                            String result = String.format(
+                                "%dx%d %s %s: %.1f frame/s", size[0],
+                                size[1], BENCHMARK_FORMAT_NAMES[ii],
+                                scalar ? "scalar" : "fastest", fps);
+                            Log.i(TAG, result);
+                            results.append(result).append('\n');
+                        }
+                    }
+                }
+                runOnUiThread(new Runnable() {
+                    @Override public void run() {
+                        text.setText(results.toString());
+                    }
+                });
+            }
+        }).start();
     }
 
+    // implementend by libplasma.so
+    private static native double benchmarkPlasma(int width, int height,
+                                                 int format, boolean scalar);
+
     // load our native library
     static {
         System.loadLibrary("plasma");
@@ -52,14 +129,18 @@ public class Plasma extends Activity
 @SuppressLint("ViewConstructor")
 class PlasmaView extends View {
     private Bitmap mBitmap;
+    private final Bitmap.Config mConfig;
     private long mStartTime;
 
     // implementend by libplasma.so
     private static native void renderPlasma(Bitmap  bitmap, long time_ms);
+    static native void configureRendering(int threads, int bandHeight);
 
-    public PlasmaView(Context context, int width, int height) {
+    public PlasmaView(Context context, int width, int height,
+                      Bitmap.Config config) {
         super(context);
-        mBitmap = Bitmap.createBitmap(width, height, Bitmap.Config.RGB_565);
+        mConfig = config;
+        mBitmap = Bitmap.createBitmap(width, height, mConfig);
         mStartTime = System.currentTimeMillis();
     }
 
@@ -71,7 +152,7 @@ class PlasmaView extends View {
     }
 
     @Override protected void onSizeChanged(int w, int h, int oldw, int oldh) {
-        mBitmap = Bitmap.createBitmap(w, h, Bitmap.Config.RGB_565);
+        mBitmap = Bitmap.createBitmap(w, h, mConfig);
     }
 
 }
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <base/trace.h>
+
 #include "native_engine.hpp"
 
 extern "C" {
@@ -21,6 +23,9 @@ void android_main(struct android_app* state);
 };
 
 void android_main(struct android_app* app) {
+  // Shows each frame in system traces.
+  ndksamples::base::EnableATrace();
+
   NativeEngine* engine = new NativeEngine(app);
   engine->GameLoop();
   delete engine;
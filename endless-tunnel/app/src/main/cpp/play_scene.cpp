@@ -15,6 +15,8 @@
  */
 #include "play_scene.hpp"
 
+#include <base/trace.h>
+
 #include <cstdio>
 
 #include "anim.hpp"
@@ -278,6 +280,7 @@ void PlayScene::OnKillGraphics() {
 }
 
 void PlayScene::DoFrame() {
+  TRACE_SCOPE("PlayScene::DoFrame");
   float deltaT = mFrameClock.ReadDelta();
   float previousY = mPlayerPos.y;
 
@@ -14,34 +14,30 @@
  * limitations under the License.
  */
 
+#define LOG_TAG "NativeCodec-looper"
+
 #include "looper.h"
 
-#include <assert.h>
+#include <base/logging.h>
 #include <errno.h>
-#include <fcntl.h>
-#include <jni.h>
-#include <limits.h>
 #include <pthread.h>
+#include <sched.h>
 #include <semaphore.h>
-#include <stdio.h>
-#include <string.h>
-#include <sys/stat.h>
-#include <sys/types.h>
-#include <unistd.h>
-
-// for __android_log_print(ANDROID_LOG_INFO, "YourApp", "formatted message");
-#include <android/log.h>
-#define TAG "NativeCodec-looper"
-#define LOGV(...) __android_log_print(ANDROID_LOG_VERBOSE, TAG, __VA_ARGS__)
 
-struct loopermessage;
-typedef struct loopermessage loopermessage;
+#include <bit>
 
 struct loopermessage {
+  std::atomic<loopermessage*> next;
   int what;
   void* obj;
-  loopermessage* next;
   bool quit;
+  // The flushgeneration when the message was posted. If it has changed by the
+  // time the message is handled, the message is dropped.
+  uint32_t generation;
+  // The next free message, in the same form as looper::freelist.
+  std::atomic<uint32_t> nextfree;
+  // The message's index in the pool.
+  uint32_t index;
 };
 
 void* looper::trampoline(void* p) {
@@ -49,9 +45,13 @@ void* looper::trampoline(void* p) {
   return NULL;
 }
 
-looper::looper() {
+looper::looper() : freelist(0), flushgeneration(0) {
+  // The first message starts as head, as if it had already been handled, and
+  // the rest are free.
+  head = addchunk();
+  tail.store(head, std::memory_order_relaxed);
+
   sem_init(&headdataavailable, 0, 0);
-  sem_init(&headwriteprotect, 0, 1);
   pthread_attr_t attr;
   pthread_attr_init(&attr);
 
@@ -61,89 +61,141 @@ looper::looper() {
 
 looper::~looper() {
   if (running) {
-    LOGV(
-        "Looper deleted while still running. Some messages will not be "
-        "processed");
+    LOG(VERBOSE)
+        << "Looper deleted while still running. Some messages will not be "
+           "processed";
     quit();
   }
+  const uint32_t count = chunkcount.load(std::memory_order_relaxed);
+  for (uint32_t chunk = 0; chunk < count; chunk++) {
+    delete[] chunks[chunk].load(std::memory_order_relaxed);
+  }
+}
+
+loopermessage* looper::allocmsg() {
+  uint64_t top = freelist.load(std::memory_order_acquire);
+  while (static_cast<uint32_t>(top) != 0) {
+    loopermessage* msg = message(static_cast<uint32_t>(top) - 1);
+    uint64_t next = ((top >> 32) + 1) << 32 |
+                    msg->nextfree.load(std::memory_order_relaxed);
+    if (freelist.compare_exchange_weak(top, next, std::memory_order_acquire,
+                                       std::memory_order_acquire)) {
+      return msg;
+    }
+  }
+  // More messages are waiting than the pool holds.
+  return addchunk();
 }
 
+// Grows the pool by a chunk, and returns its first message. The rest are
+// freed. Several posters may find the pool empty at once, and each adds a
+// chunk.
+loopermessage* looper::addchunk() {
+  const uint32_t chunk = chunkcount.fetch_add(1, std::memory_order_relaxed);
+  CHECK_LT(chunk, kMaxChunks) << "too many messages waiting";
+  const uint32_t size = kPoolSize << chunk;
+  const uint32_t first = kPoolSize * ((1u << chunk) - 1);
+  LOG(VERBOSE) << "adding " << size << " messages to the pool";
+  loopermessage* msgs = new loopermessage[size];
+  for (uint32_t i = 0; i < size; i++) {
+    msgs[i].next.store(NULL, std::memory_order_relaxed);
+    msgs[i].nextfree.store(first + i + 2, std::memory_order_relaxed);
+    msgs[i].index = first + i;
+  }
+  chunks[chunk].store(msgs, std::memory_order_relaxed);
+  if (size > 1) freemsgs(&msgs[1], &msgs[size - 1]);
+  return &msgs[0];
+}
+
+// Only valid for the index of a message that has been freed, since freeing
+// it publishes its chunk.
+loopermessage* looper::message(uint32_t index) {
+  const uint32_t chunk = std::bit_width(index / kPoolSize + 1) - 1;
+  return &chunks[chunk].load(std::memory_order_relaxed)
+              [index - kPoolSize * ((1u << chunk) - 1)];
+}
+
+// Frees the messages from first to last, which are already linked through
+// nextfree.
+void looper::freemsgs(loopermessage* first, loopermessage* last) {
+  uint64_t top = freelist.load(std::memory_order_relaxed);
+  do {
+    last->nextfree.store(static_cast<uint32_t>(top),
+                         std::memory_order_relaxed);
+  } while (!freelist.compare_exchange_weak(
+      top, ((top >> 32) + 1) << 32 | (first->index + 1),
+      std::memory_order_release, std::memory_order_relaxed));
+}
+
+// Only called by the worker.
+void looper::freemsg(loopermessage* msg) { freemsgs(msg, msg); }
+
 void looper::post(int what, void* data, bool flush) {
-  loopermessage* msg = new loopermessage();
+  loopermessage* msg = allocmsg();
   msg->what = what;
   msg->obj = data;
-  msg->next = NULL;
   msg->quit = false;
-  addmsg(msg, flush);
-}
-
-void looper::addmsg(loopermessage* msg, bool flush) {
-  sem_wait(&headwriteprotect);
-  loopermessage* h = head;
-
   if (flush) {
-    while (h) {
-      loopermessage* next = h->next;
-      delete h;
-      h = next;
-    }
-    h = NULL;
-  }
-  if (h) {
-    while (h->next) {
-      h = h->next;
-    }
-    h->next = msg;
+    msg->generation =
+        flushgeneration.fetch_add(1, std::memory_order_acq_rel) + 1;
   } else {
-    head = msg;
+    msg->generation = flushgeneration.load(std::memory_order_acquire);
   }
-  LOGV("post msg %d", msg->what);
-  sem_post(&headwriteprotect);
+  LOG(VERBOSE) << "post msg " << what;
+  addmsg(msg);
+}
+
+void looper::addmsg(loopermessage* msg) {
+  msg->next.store(NULL, std::memory_order_relaxed);
+  // The worker can't free prev until it has a next, so it's safe to link it
+  // after the swap.
+  loopermessage* prev = tail.exchange(msg, std::memory_order_acq_rel);
+  prev->next.store(msg, std::memory_order_release);
   sem_post(&headdataavailable);
 }
 
 void looper::loop() {
   while (true) {
     // wait for available message
-    sem_wait(&headdataavailable);
-
-    // get next available message
-    sem_wait(&headwriteprotect);
-    loopermessage* msg = head;
-    if (msg == NULL) {
-      LOGV("no msg");
-      sem_post(&headwriteprotect);
-      continue;
+    while (sem_wait(&headdataavailable) == -1 && errno == EINTR) {
     }
-    head = msg->next;
-    sem_post(&headwriteprotect);
+
+    // get next available message. Its post has linked it in, but a post that
+    // swapped the tail before it may not have linked its own message yet.
+    loopermessage* msg;
+    while ((msg = head->next.load(std::memory_order_acquire)) == NULL) {
+      sched_yield();
+    }
+    freemsg(head);
+    head = msg;
 
     if (msg->quit) {
-      LOGV("quitting");
-      delete msg;
+      LOG(VERBOSE) << "quitting";
       return;
     }
-    LOGV("processing msg %d", msg->what);
+    if (msg->generation != flushgeneration.load(std::memory_order_acquire)) {
+      LOG(VERBOSE) << "flushed msg " << msg->what;
+      continue;
+    }
+    LOG(VERBOSE) << "processing msg " << msg->what;
     handle(msg->what, msg->obj);
-    delete msg;
   }
 }
 
 void looper::quit() {
-  LOGV("quit");
-  loopermessage* msg = new loopermessage();
+  LOG(VERBOSE) << "quit";
+  loopermessage* msg = allocmsg();
   msg->what = 0;
   msg->obj = NULL;
-  msg->next = NULL;
   msg->quit = true;
-  addmsg(msg, false);
+  msg->generation = flushgeneration.load(std::memory_order_acquire);
+  addmsg(msg);
   void* retval;
   pthread_join(worker, &retval);
   sem_destroy(&headdataavailable);
-  sem_destroy(&headwriteprotect);
   running = false;
 }
 
 void looper::handle(int what, void* obj) {
-  LOGV("dropping msg %d %p", what, obj);
+  LOG(VERBOSE) << "dropping msg " << what << " " << obj;
 }
@@ -16,28 +16,68 @@
 
 #include <pthread.h>
 #include <semaphore.h>
+#include <stdint.h>
+
+#include <atomic>
 
 struct loopermessage;
 
+// Calls handle for each posted message, in order, on a worker thread.
+//
+// Posting never takes a lock. Messages come from a pool that the worker
+// returns them to. The pool starts with kPoolSize messages, and whenever it
+// runs out, because more messages are waiting than it holds, a post adds a
+// chunk twice the size of the last one. So posting only allocates when the
+// backlog reaches a new high, and never once the pool has grown to fit it. The
+// pool is only freed with the looper. Messages are queued on an intrusive list
+// that posters append to by swapping the tail pointer, and that only the
+// worker removes from.
 class looper {
  public:
+  static constexpr uint32_t kPoolSize = 64;
+
   looper();
   looper& operator=(const looper&) = delete;
   looper(looper&) = delete;
   virtual ~looper();
 
+  // If flush is true, messages posted before this one that haven't been
+  // handled yet are dropped.
   void post(int what, void* data, bool flush = false);
+  // Waits for the messages posted so far to be handled, and stops the worker.
   void quit();
 
   virtual void handle(int what, void* data);
 
  private:
-  void addmsg(loopermessage* msg, bool flush);
+  // Enough chunks for every index that freelist can hold.
+  static constexpr uint32_t kMaxChunks = 26;
+
+  loopermessage* allocmsg();
+  loopermessage* addchunk();
+  loopermessage* message(uint32_t index);
+  void freemsgs(loopermessage* first, loopermessage* last);
+  void freemsg(loopermessage* msg);
+  void addmsg(loopermessage* msg);
   static void* trampoline(void* p);
   void loop();
+  // The pool. Chunk k holds kPoolSize << k messages, with consecutive indices
+  // following those of chunk k - 1.
+  std::atomic<loopermessage*> chunks[kMaxChunks] = {};
+  std::atomic<uint32_t> chunkcount = 0;
+  // The index + 1 of the first free message in the pool, or 0 if there are
+  // none, in the low 32 bits. The high 32 bits count the changes, so that a message
+  // that is taken and returned while another thread is taking it can't be
+  // taken twice.
+  std::atomic<uint64_t> freelist;
+  // The last message handled, whose next is the next to handle. Only used by
+  // the worker.
   loopermessage* head;
+  // The last message posted.
+  std::atomic<loopermessage*> tail;
+  // Incremented by each flush.
+  std::atomic<uint32_t> flushgeneration;
   pthread_t worker;
-  sem_t headwriteprotect;
   sem_t headdataavailable;
   bool running;
 };
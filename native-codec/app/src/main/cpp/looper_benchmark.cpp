@@ -0,0 +1,173 @@
+// Copyright (C) 2025 The Android Open Source Project
+// SPDX-License-Identifier: Apache-2.0
+
+// Benchmarks of the looper. This is only built for the host (see
+// CMakeLists.txt).
+//
+// Usage: looper_benchmark [--messages=N] [--threads=N]
+//
+// "post" posts --messages messages (1000000 by default) from each of 1 and
+// --threads threads (4 by default), and "repost" has the handler post the next
+// message itself, --messages times, the way doCodecWork does. Each writes one
+// line to stdout with the number of messages posted per second, the number
+// handled per second including waiting for the worker to finish, and the
+// average number of heap allocations made for each post, counted by replacing
+// operator new.
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "looper.h"
+
+namespace {
+
+std::atomic<uint64_t> gAllocations = 0;
+
+}  // namespace
+
+void* operator new(size_t size) {
+  gAllocations.fetch_add(1, std::memory_order_relaxed);
+  void* p = malloc(size == 0 ? 1 : size);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+namespace {
+
+struct Options {
+  uint32_t messages = 1000000;
+  uint32_t threads = 4;
+};
+
+[[noreturn]] void Usage(std::string_view error) {
+  std::cerr << error << "\n"
+            << "usage: looper_benchmark [--messages=N] [--threads=N]\n";
+  exit(EXIT_FAILURE);
+}
+
+uint32_t ParseCount(std::string_view flag, std::string_view value) {
+  char* end = nullptr;
+  std::string str(value);
+  unsigned long result = strtoul(str.c_str(), &end, 10);
+  if (str.empty() || *end != '\0' || result == 0) {
+    Usage(std::format("invalid value for {}: {}", flag, value));
+  }
+  return static_cast<uint32_t>(result);
+}
+
+Options ParseOptions(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg = argv[i];
+    auto separator = arg.find('=');
+    if (!arg.starts_with("--") || separator == std::string_view::npos) {
+      Usage(std::format("unexpected argument: {}", arg));
+    }
+    std::string_view flag = arg.substr(0, separator);
+    std::string_view value = arg.substr(separator + 1);
+    if (flag == "--messages") {
+      options.messages = ParseCount(flag, value);
+    } else if (flag == "--threads") {
+      options.threads = ParseCount(flag, value);
+    } else {
+      Usage(std::format("unknown flag: {}", flag));
+    }
+  }
+  return options;
+}
+
+enum { kMsgCount, kMsgRepost };
+
+class CountingLooper : public looper {
+ public:
+  explicit CountingLooper(uint32_t reposts) : reposts_(reposts) {}
+
+  void handle(int what, void*) override {
+    const uint64_t handled =
+        handled_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (what == kMsgRepost && handled < reposts_) {
+      post(kMsgRepost, nullptr);
+    }
+  }
+
+  uint64_t handled() const { return handled_.load(); }
+
+ private:
+  const uint32_t reposts_;
+  std::atomic<uint64_t> handled_ = 0;
+};
+
+void Report(std::string_view name, uint32_t threads, uint64_t posts,
+            std::chrono::duration<double> posting,
+            std::chrono::duration<double> handling, uint64_t handled,
+            uint64_t allocations) {
+  std::cout << std::format(
+      "{:<6} {} threads: {:.0f} posts/s, {:.0f} handled/s, "
+      "allocations/post {:.3f}\n",
+      name, threads, posts / posting.count(), handled / handling.count(),
+      static_cast<double>(allocations) / posts);
+}
+
+void RunPostBenchmark(uint32_t threads, uint32_t messages) {
+  CountingLooper counter(0);
+  const uint64_t allocations_before = gAllocations.load();
+  auto begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> posters;
+  for (uint32_t t = 0; t < threads; t++) {
+    posters.emplace_back([&] {
+      for (uint32_t i = 0; i < messages; i++) {
+        counter.post(kMsgCount, nullptr);
+      }
+    });
+  }
+  for (std::thread& poster : posters) poster.join();
+  auto posted = std::chrono::steady_clock::now();
+  const uint64_t allocations = gAllocations.load() - allocations_before;
+  counter.quit();
+  auto end = std::chrono::steady_clock::now();
+
+  Report("post", threads, uint64_t{threads} * messages, posted - begin,
+         end - begin, counter.handled(), allocations);
+}
+
+void RunRepostBenchmark(uint32_t messages) {
+  CountingLooper counter(messages);
+  const uint64_t allocations_before = gAllocations.load();
+  auto begin = std::chrono::steady_clock::now();
+  counter.post(kMsgRepost, nullptr);
+  while (counter.handled() < messages) std::this_thread::yield();
+  auto end = std::chrono::steady_clock::now();
+  const uint64_t allocations = gAllocations.load() - allocations_before;
+  counter.quit();
+
+  Report("repost", 1, messages, end - begin, end - begin, counter.handled(),
+         allocations);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const Options options = ParseOptions(argc, argv);
+
+  std::vector<uint32_t> thread_counts = {1};
+  if (options.threads > 1) thread_counts.push_back(options.threads);
+  for (uint32_t threads : thread_counts) {
+    RunPostBenchmark(threads, options.messages);
+  }
+  RunRepostBenchmark(options.messages);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+// Copyright (C) 2025 The Android Open Source Project
+// SPDX-License-Identifier: Apache-2.0
+
+#include "looper.h"
+
+#include <gtest/gtest.h>
+
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// A looper that keeps the what of every message it handles. If block_on is
+// set, handling that message doesn't return until Release is called, which
+// keeps the following messages waiting.
+class RecordingLooper : public looper {
+ public:
+  explicit RecordingLooper(int block_on = -1)
+      : block_on_(block_on), released_(release_.get_future().share()) {}
+
+  // Waits until the worker is handling the block_on message.
+  void WaitUntilBlocked() { blocked_.get_future().wait(); }
+
+  void Release() { release_.set_value(); }
+
+  // Only valid after quit.
+  const std::vector<int>& handled() const { return handled_; }
+
+  void handle(int what, void*) override {
+    handled_.push_back(what);
+    if (what == block_on_) {
+      blocked_.set_value();
+      released_.wait();
+    }
+  }
+
+ private:
+  const int block_on_;
+  std::promise<void> blocked_;
+  std::promise<void> release_;
+  std::shared_future<void> released_;
+  // Only used by the worker until quit.
+  std::vector<int> handled_;
+};
+
+std::vector<int> Range(int begin, int end) {
+  std::vector<int> range;
+  for (int i = begin; i < end; i++) range.push_back(i);
+  return range;
+}
+
+TEST(LooperTest, HandlesInOrder) {
+  RecordingLooper loop;
+  for (int i = 0; i < 1000; i++) loop.post(i, nullptr);
+  loop.quit();
+  EXPECT_EQ(loop.handled(), Range(0, 1000));
+}
+
+// Every message from every thread is handled, and each thread's messages are
+// handled in the order that thread posted them.
+TEST(LooperTest, HandlesFromMultiplePosters) {
+  constexpr int kThreads = 4;
+  constexpr int kMessagesPerThread = 1000;
+  RecordingLooper loop;
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < kThreads; thread++) {
+    threads.emplace_back([&loop, thread] {
+      for (int i = 0; i < kMessagesPerThread; i++) {
+        loop.post(thread * kMessagesPerThread + i, nullptr);
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  loop.quit();
+
+  std::vector<int> next(kThreads);
+  for (int what : loop.handled()) {
+    const int thread = what / kMessagesPerThread;
+    ASSERT_EQ(what % kMessagesPerThread, next[thread]) << "thread " << thread;
+    next[thread]++;
+  }
+  EXPECT_EQ(next, std::vector<int>(kThreads, kMessagesPerThread));
+}
+
+// Messages that are waiting when a message is posted with flush are dropped,
+// and the flushing message and those after it are handled.
+TEST(LooperTest, FlushDropsWaitingMessages) {
+  RecordingLooper loop(/*block_on=*/0);
+  loop.post(0, nullptr);
+  loop.WaitUntilBlocked();
+  for (int i = 1; i < 4; i++) loop.post(i, nullptr);
+  loop.post(4, nullptr, /*flush=*/true);
+  loop.post(5, nullptr);
+  loop.Release();
+  loop.quit();
+  EXPECT_EQ(loop.handled(), (std::vector<int>{0, 4, 5}));
+}
+
+// quit handles everything posted before it. So many messages are waiting that
+// the pool has to grow several times.
+TEST(LooperTest, QuitHandlesWaitingMessages) {
+  constexpr int kMessages = 8 * looper::kPoolSize;
+  RecordingLooper loop(/*block_on=*/0);
+  loop.post(0, nullptr);
+  loop.WaitUntilBlocked();
+  for (int i = 1; i < kMessages; i++) loop.post(i, nullptr);
+  loop.Release();
+  loop.quit();
+  EXPECT_EQ(loop.handled(), Range(0, kMessages));
+}
+
+}  // namespace
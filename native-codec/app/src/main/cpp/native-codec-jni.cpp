@@ -50,6 +50,7 @@
 #include <android/asset_manager_jni.h>
 #include <android/native_window_jni.h>
 #include <base/macros.h>
+#include <base/trace.h>
 
 typedef struct {
   int fd;
@@ -87,6 +88,7 @@ int64_t systemnanotime() {
 }
 
 void doCodecWork(workerdata* d) {
+  TRACE_SCOPE("doCodecWork");
   ssize_t bufidx = -1;
   if (!d->sawInputEOS) {
     bufidx = AMediaCodec_dequeueInputBuffer(d->codec, 2000);
@@ -122,6 +124,7 @@ void doCodecWork(workerdata* d) {
         d->renderstart = systemnanotime() - presentationNano;
       }
       int64_t delay = (d->renderstart + presentationNano) - systemnanotime();
+      TRACE_COUNTER("frame delay us", delay / 1000);
       if (delay > 0) {
         usleep(delay / 1000);
       }
@@ -319,6 +322,9 @@ extern "C" JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* _Nonnull vm,
     return JNI_ERR;
   }
 
+  // Shows the decoding in system traces.
+  ndksamples::base::EnableATrace();
+
   jclass c = env->FindClass("com/example/nativecodec/NativeCodec");
   if (c == nullptr) return JNI_ERR;
 
@@ -9,6 +9,14 @@ android {
     defaultConfig {
         applicationId = "com.android.ndk.samples.vectorization"
 
+        testInstrumentationRunner = "androidx.test.runner.AndroidJUnitRunner"
+
+        ndk {
+            // junit-gtest and googletest don't currently (August 2025) include
+            // riscv64 libraries.
+            abiFilters.remove("riscv64")
+        }
+
         vectorDrawables {
             useSupportLibrary = true
         }
@@ -28,6 +36,17 @@ android {
     composeOptions {
         kotlinCompilerExtensionVersion = "1.5.1"
     }
+
+    packaging {
+        jniLibs {
+            // Gradle has no way of knowing which of the libraries in our
+            // CMakeLists.txt are for the app and which are for tests, so we
+            // have to tell it which libraries are test libraries. Without
+            // this, the test libraries will end up packaged in the real APK
+            // and not just the test APK.
+            testOnly += "**/libapp_tests.so"
+        }
+    }
 }
 
 dependencies {
@@ -40,6 +59,9 @@ dependencies {
     implementation(libs.androidx.ui.graphics)
     implementation(libs.androidx.ui.tooling.preview)
     implementation(libs.androidx.material3)
+    implementation(libs.androidx.junit.gtest)
+    implementation(libs.googletest)
+    androidTestImplementation(libs.ext.junit)
     debugImplementation(libs.androidx.ui.tooling)
     debugImplementation(libs.androidx.ui.test.manifest)
 }
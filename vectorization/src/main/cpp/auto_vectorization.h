@@ -18,10 +18,99 @@
 
 #include <stdint.h>
 
+#include <array>
+
+#include "blocked_multiply.h"
 #include "matrix.h"
 
 namespace samples::vectorization {
 
+/**
+ * Computes C += A * B for one tile of BlockedMultiply with plain loops.
+ *
+ * See BlockedMultiply for the meaning of each argument.
+ *
+ * @tparam T The type of each operand cell.
+ * @tparam M The column stride of a and c.
+ * @tparam N The column stride of b.
+ * @tparam Acc The type of each result cell.
+ */
+template <typename T, size_t M, size_t N, typename Acc = T>
+[[clang::always_inline]] void AutoVectorizationMicroKernel(
+    const T* _Nonnull a, const T* _Nonnull b, Acc* _Nonnull c, size_t depth) {
+  // The accumulator is small enough that Clang can keep it in registers, and
+  // the inner loop is a vector-width multiply-add over a column of the tile.
+  Acc accumulator[kMicroTileColumns][kMicroTileRows];
+  for (auto column = 0U; column < kMicroTileColumns; column++) {
+    for (auto row = 0U; row < kMicroTileRows; row++) {
+      accumulator[column][row] = c[column * M + row];
+    }
+  }
+  for (size_t k = 0; k < depth; k++) {
+    for (auto column = 0U; column < kMicroTileColumns; column++) {
+      const Acc scalar = b[column * N + k];
+      for (auto row = 0U; row < kMicroTileRows; row++) {
+        accumulator[column][row] += static_cast<Acc>(a[k * M + row]) * scalar;
+      }
+    }
+  }
+  for (auto column = 0U; column < kMicroTileColumns; column++) {
+    for (auto row = 0U; row < kMicroTileRows; row++) {
+      c[column * M + row] = accumulator[column][row];
+    }
+  }
+}
+
+/**
+ * Multiplies two compatible matrices, writing the result to an existing
+ * matrix.
+ *
+ * @tparam T The type of each operand cell.
+ * @tparam Acc The type of each result cell, which may be wider than T. See
+ * BlockedMultiply.
+ * @tparam M The number of rows in the left operand and the result.
+ * @tparam N The number of columns in the left operand, and the rows in the
+ * right operand.
+ * @tparam P The number of columns in the right operand and the result.
+ * @param lhs The left operand.
+ * @param rhs The right operand.
+ * @param result The destination for lhs * rhs. Must not be either operand.
+ */
+template <typename T, typename Acc, size_t M, size_t N, size_t P>
+[[clang::always_inline]] void MultiplyWithAutoVectorization(
+    const Matrix<M, N, T>& lhs, const Matrix<N, P, T>& rhs,
+    Matrix<M, P, Acc>& result) {
+  if constexpr (kUseBlockedMultiply<M, N, P>) {
+    BlockedMultiply<T, M, N, P>(lhs.data(), rhs.data(), result.data(),
+                                AutoVectorizationMicroKernel<T, M, N, Acc>);
+  } else {
+    // This may look like an unfair benchmark because this implementation uses
+    // the less vector friendly one than the others, however, using the vector
+    // friendly algorithm here actually made performance worse.
+    //
+    // This is a good illustration of why it's important to benchmark your own
+    // code and not rely on what someone else tells you about which works best:
+    // it depends.
+    //
+    // It's probably also worth mentioning that if what you need is
+    // *consistent* performance across compiler versions, the only real choice
+    // you have is writing assembly. Even the instruction intrinsics (at least
+    // for Neon) are subject to the compiler's instruction selection. That will
+    // be overkill for most users, since it's substantially more difficult to
+    // write and maintain, but is how you'll see some code bases deal with this
+    // (codecs in particular are willing to make that trade-off).
+    for (auto i = 0U; i < M; i++) {
+      for (auto j = 0U; j < P; j++) {
+        Acc sum = {};
+        for (auto k = 0U; k < N; k++) {
+          sum += static_cast<Acc>(lhs.get(i, k)) * static_cast<Acc>(rhs[k, j]);
+        }
+        result[i, j] = sum;
+      }
+    }
+  }
+}
+
 /**
  * Multiplies two compatible matrices and returns the result.
  *
@@ -37,32 +126,209 @@ namespace samples::vectorization {
 template <typename T, size_t M, size_t N, size_t P>
 Matrix<M, P, T> MultiplyWithAutoVectorization(const Matrix<M, N, T>& lhs,
                                               const Matrix<N, P, T>& rhs) {
-  // This may look like an unfair benchmark because this implementation uses the
-  // less vector friendly one than the others, however, using the vector
-  // friendly algorithm here actually made performance worse.
-  //
-  // This is a good illustration of why it's important to benchmark your own
-  // code and not rely on what someone else tells you about which works best: it
-  // depends.
-  //
-  // It's probably also worth mentioning that if what you need is *consistent*
-  // performance across compiler versions, the only real choice you have is
-  // writing assembly. Even the instruction intrinsics (at least for Neon) are
-  // subject to the compiler's instruction selection. That will be overkill for
-  // most users, since it's substantially more difficult to write and maintain,
-  // but is how you'll see some code bases deal with this (codecs in particular
-  // are willing to make that trade-off).
   Matrix<M, P, T> result;
-  for (auto i = 0U; i < M; i++) {
-    for (auto j = 0U; j < P; j++) {
-      T sum = {};
-      for (auto k = 0U; k < N; k++) {
-        sum += lhs.get(i, k) * rhs[k, j];
-      }
-      result[i, j] = sum;
-    }
+  MultiplyWithAutoVectorization(lhs, rhs, result);
+  return result;
+}
+
+/**
+ * Transforms each point in a batch by a matrix, writing the results to out.
+ *
+ * @tparam T The type of each matrix cell.
+ * @param m The transform to apply.
+ * @param in The points to transform.
+ * @param out The destination for the transformed points. Must be the same size
+ * as in. May be the same buffers as in.
+ */
+template <typename T>
+[[clang::always_inline]] void TransformPointsWithAutoVectorization(
+    const Mat4<T>& m, PointSpan<const T> in, PointSpan<T> out) {
+  DCHECK(in.IsValid());
+  DCHECK(out.IsValid());
+  DCHECK_EQ(in.size(), out.size());
+
+  // Work from a local copy of the matrix. Otherwise Clang can't prove that the
+  // stores to out don't modify m, and it would have to reload every cell of m
+  // on each iteration.
+  const Mat4<T> local_m = m;
+
+  for (size_t i = 0; i < in.size(); i++) {
+    const T x = in.x[i];
+    const T y = in.y[i];
+    const T z = in.z[i];
+    const T w = in.w[i];
+    out.x[i] = local_m[0, 0] * x + local_m[0, 1] * y + local_m[0, 2] * z +
+               local_m[0, 3] * w;
+    out.y[i] = local_m[1, 0] * x + local_m[1, 1] * y + local_m[1, 2] * z +
+               local_m[1, 3] * w;
+    out.z[i] = local_m[2, 0] * x + local_m[2, 1] * y + local_m[2, 2] * z +
+               local_m[2, 3] * w;
+    out.w[i] = local_m[3, 0] * x + local_m[3, 1] * y + local_m[3, 2] * z +
+               local_m[3, 3] * w;
+  }
+}
+
+/**
+ * Returns the first three cells of column j of m.
+ */
+template <typename T, size_t N>
+[[clang::always_inline]] std::array<T, 3> AutoVectorizationColumn(
+    const Matrix<N, N, T>& m, size_t j) {
+  std::array<T, 3> result;
+  for (auto i = 0U; i < 3; i++) {
+    result[i] = m[i, j];
   }
   return result;
 }
 
+/**
+ * Returns the cross product of two 3D vectors.
+ */
+template <typename T>
+[[clang::always_inline]] std::array<T, 3> AutoVectorizationCross(
+    const std::array<T, 3>& a, const std::array<T, 3>& b) {
+  std::array<T, 3> result;
+  for (auto i = 0U; i < 3; i++) {
+    const auto j = (i + 1) % 3;
+    const auto k = (i + 2) % 3;
+    result[i] = a[j] * b[k] - a[k] * b[j];
+  }
+  return result;
+}
+
+/**
+ * Returns the dot product of two 3D vectors.
+ */
+template <typename T>
+[[clang::always_inline]] T AutoVectorizationDot(const std::array<T, 3>& a,
+                                                const std::array<T, 3>& b) {
+  T sum = {};
+  for (auto i = 0U; i < 3; i++) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+/**
+ * Transposes a 3x3 or 4x4 matrix with plain loops.
+ *
+ * @tparam T The type of each matrix cell.
+ * @tparam N The number of rows and columns in m.
+ * @param m The matrix to transpose.
+ * @param result The destination for the transpose of m. Must not be m.
+ */
+template <typename T, size_t N>
+  requires(N == 3 || N == 4)
+[[clang::always_inline]] void TransposeWithAutoVectorization(
+    const Matrix<N, N, T>& m, Matrix<N, N, T>& result) {
+  for (auto row = 0U; row < N; row++) {
+    for (auto column = 0U; column < N; column++) {
+      result[column, row] = m[row, column];
+    }
+  }
+}
+
+/**
+ * Computes the determinant of a 3x3 or 4x4 matrix with plain loops.
+ *
+ * See InverseWithClangMatrices for the algorithm.
+ *
+ * @tparam T The type of each matrix cell.
+ * @tparam N The number of rows and columns in m.
+ * @param m The matrix.
+ * @return The determinant of m.
+ */
+template <typename T, size_t N>
+  requires(N == 3 || N == 4)
+[[clang::always_inline]] T DeterminantWithAutoVectorization(
+    const Matrix<N, N, T>& m) {
+  const auto a = AutoVectorizationColumn(m, 0);
+  const auto b = AutoVectorizationColumn(m, 1);
+  const auto c = AutoVectorizationColumn(m, 2);
+  if constexpr (N == 3) {
+    return AutoVectorizationDot(a, AutoVectorizationCross(b, c));
+  } else {
+    const auto d = AutoVectorizationColumn(m, 3);
+    std::array<T, 3> u;
+    std::array<T, 3> v;
+    for (auto i = 0U; i < 3; i++) {
+      u[i] = a[i] * m[3, 1] - b[i] * m[3, 0];
+      v[i] = c[i] * m[3, 3] - d[i] * m[3, 2];
+    }
+    return AutoVectorizationDot(AutoVectorizationCross(a, b), v) +
+           AutoVectorizationDot(AutoVectorizationCross(c, d), u);
+  }
+}
+
+/**
+ * Inverts a 3x3 or 4x4 matrix with plain loops.
+ *
+ * See InverseWithClangMatrices for the algorithm.
+ * Each 3D operation is a three iteration loop, which Clang unrolls and may
+ * combine into vector instructions with the SLP vectorizer.
+ *
+ * @tparam T The type of each matrix cell.
+ * @tparam N The number of rows and columns in m.
+ * @param m The matrix to invert. Must be invertible; otherwise the result is
+ * infinite or NaN.
+ * @param result The destination for the inverse of m. Must not be m.
+ */
+template <typename T, size_t N>
+  requires(N == 3 || N == 4)
+[[clang::always_inline]] void InverseWithAutoVectorization(
+    const Matrix<N, N, T>& m, Matrix<N, N, T>& result) {
+  const auto a = AutoVectorizationColumn(m, 0);
+  const auto b = AutoVectorizationColumn(m, 1);
+  const auto c = AutoVectorizationColumn(m, 2);
+  if constexpr (N == 3) {
+    const auto bc = AutoVectorizationCross(b, c);
+    const auto ca = AutoVectorizationCross(c, a);
+    const auto ab = AutoVectorizationCross(a, b);
+    const T inv_det = 1 / AutoVectorizationDot(a, bc);
+    for (auto i = 0U; i < 3; i++) {
+      result[0, i] = bc[i] * inv_det;
+      result[1, i] = ca[i] * inv_det;
+      result[2, i] = ab[i] * inv_det;
+    }
+  } else {
+    const auto d = AutoVectorizationColumn(m, 3);
+    const T x = m[3, 0];
+    const T y = m[3, 1];
+    const T z = m[3, 2];
+    const T w = m[3, 3];
+
+    auto s = AutoVectorizationCross(a, b);
+    auto t = AutoVectorizationCross(c, d);
+    std::array<T, 3> u;
+    std::array<T, 3> v;
+    for (auto i = 0U; i < 3; i++) {
+      u[i] = a[i] * y - b[i] * x;
+      v[i] = c[i] * w - d[i] * z;
+    }
+    const T inv_det =
+        1 / (AutoVectorizationDot(s, v) + AutoVectorizationDot(t, u));
+    for (auto i = 0U; i < 3; i++) {
+      s[i] *= inv_det;
+      t[i] *= inv_det;
+      u[i] *= inv_det;
+      v[i] *= inv_det;
+    }
+
+    const auto bv = AutoVectorizationCross(b, v);
+    const auto va = AutoVectorizationCross(v, a);
+    const auto du = AutoVectorizationCross(d, u);
+    const auto uc = AutoVectorizationCross(u, c);
+    for (auto i = 0U; i < 3; i++) {
+      result[0, i] = bv[i] + t[i] * y;
+      result[1, i] = va[i] - t[i] * x;
+      result[2, i] = du[i] + s[i] * w;
+      result[3, i] = uc[i] - s[i] * z;
+    }
+    result[0, 3] = -AutoVectorizationDot(b, t);
+    result[1, 3] = AutoVectorizationDot(a, t);
+    result[2, 3] = -AutoVectorizationDot(d, s);
+    result[3, 3] = AutoVectorizationDot(c, s);
+  }
+}
+
 }  // namespace samples::vectorization
@@ -19,58 +19,100 @@
 #include <base/logging.h>
 #include <stdint.h>
 
+#include <algorithm>
+#include <cmath>
 #include <expected>
 #include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
-#include "auto_vectorization.h"
-#include "clang_vector.h"
+#include "kernels.h"
 #include "matrix.h"
-#include "omp_simd.h"
-
-constexpr uint32_t kNumRuns = 1'000'000;
+#include "matrix_expression.h"
+#include "operands.h"
 
 namespace samples::vectorization {
 
 Vec4 result;
 
+std::string_view BackendName(Backend backend) {
+  switch (backend) {
+    case Backend::kAutoVectorization:
+      return "auto_vectorization";
+    case Backend::kCxxSimd:
+      return "cxx_simd";
+    case Backend::kClangVector:
+      return "clang_vector";
+    case Backend::kClangMatrix:
+      return "clang_matrix";
+    case Backend::kOpenMp:
+      return "openmp";
+    default:
+      return "unknown";
+  }
+}
+
+/**
+ * Finds the kernels to benchmark, or the reason they can't be benchmarked.
+ *
+ * @param backend The backend to benchmark.
+ * @param variant The instruction set to benchmark.
+ * @return The kernels, or an error code.
+ */
+[[nodiscard]] static std::expected<Kernels, BenchmarkError> FindKernels(
+    Backend backend, CpuVariant variant) {
+  if (std::ranges::find(kBackends, backend) == kBackends.end()) {
+    return std::unexpected{BenchmarkError::kUnknownBackend};
+  }
+  if (!IsSupported(variant)) {
+    return std::unexpected{BenchmarkError::kNotSupported};
+  }
+
+  auto kernels = GetKernels(backend, variant);
+  if (!kernels.has_value()) {
+    return std::unexpected{BenchmarkError::kNotImplemented};
+  }
+  return *kernels;
+}
+
 /**
  * Benchmarks a given matrix multiply operation.
  *
- * The multiply is given here as a callback to try to keep Clang from folding,
- * unrolling, or inlining inconsistently across each benchmarked implementation.
- * We want Clang to do as much as possible to optimize *within* the multiply
- * function itself, but inconsistent optimization of the benchmark code itself
- * could skew results.
+ * The harness calls the benchmark body through a std::function to try to keep
+ * Clang from folding, unrolling, or inlining inconsistently across each
+ * benchmarked implementation. We want Clang to do as much as possible to
+ * optimize *within* the multiply function itself, but inconsistent
+ * optimization of the benchmark code itself could skew results. The multiply
+ * itself is a call through a pointer to the kernel for the chosen CpuVariant,
+ * which is the same small overhead for every backend.
  *
  * @param position A position vector.
  * @param translation A translation vector.
  * @param func The multiplication function to use.
- * @return The average duration per call in nanoseconds.
+ * @param options Controls how the benchmark is measured.
+ * @return The statistics for a single call.
  */
-[[nodiscard, clang::noinline]] std::chrono::nanoseconds Benchmark(
-    Vec4<>& position, Mat4<>& translation,
-    std::function<Vec4<>(const Vec4<>&, const Mat4<>&)> func) {
+template <typename F>
+[[nodiscard, clang::noinline]] BenchmarkStats Benchmark(
+    Vec4<>& position, Mat4<>& translation, F func,
+    const HarnessOptions& options) {
   // TODO: Move to a unit test.
   auto test = func(position, translation);
   auto expected = Vec4{{20, 10, 10, 1}};
   CHECK_EQ(test, expected);
 
-  auto begin = std::chrono::steady_clock::now();
-
-  // This is another attempt to prevent Clang from optimizing the benchmark
-  // harness inconsistently.
-#pragma clang loop unroll(disable)
-  for (auto i = 0U; i < kNumRuns; i++) {
-    result = func(position, translation);
-  }
-
-  auto end = std::chrono::steady_clock::now();
-
-  return (end - begin) / kNumRuns;
+  return RunBenchmark([&]() { result = func(position, translation); },
+                      options);
 }
 
-[[nodiscard]] std::expected<std::chrono::nanoseconds, BenchmarkError>
-BenchmarkMatrixMultiplication(Backend backend) {
+[[nodiscard]] std::expected<BenchmarkStats, BenchmarkError>
+BenchmarkMatrixMultiplication(Backend backend, const HarnessOptions& options,
+                              CpuVariant variant) {
   Vec4 position{{10.0f, 10.0f, 10.0f, 1.0f}};
   Mat4 translation{{
       {1.0f, 0.0f, 0.0f, 10.0f},
@@ -79,40 +121,552 @@ BenchmarkMatrixMultiplication(Backend backend) {
       {0.0f, 0.0f, 0.0f, 1.0f},
   }};
 
-  switch (backend) {
-    case Backend::kAutoVectorization:
-      LOG(INFO) << "Benchmarking auto-vectorization";
-      return Benchmark(position, translation, [](Vec4<> p, Mat4<> t) {
-        return MultiplyWithAutoVectorization(t, p);
-      });
-    case Backend::kCxxSimd:
-#if __NDK_MAJOR__ >= 29
-#error check if std::simd works yet
-#endif
-      // The libc++ in NDK r27 has only a skeleton implementation of std::simd.
-      // Some things we can do without, but it doesn't actually have operator*,
-      // which is sort of essential :)
-      LOG(INFO) << "Benchmarking std::simd";
-      return std::unexpected{BenchmarkError::kNotImplemented};
-    case Backend::kClangVector:
-      LOG(INFO) << "Benchmarking Clang vectors";
-      return Benchmark(position, translation, [](Vec4<> p, Mat4<> t) {
-        return MultiplyWithClangVectors(t, p);
-      });
-    case Backend::kClangMatrix:
-      LOG(INFO) << "Benchmarking Clang matrices";
-      return Benchmark(position, translation, [](Vec4<> p, Mat4<> t) {
-        // This is the default implementation since it's the fastest.
-        return t * p;
-      });
-    case Backend::kOpenMp:
-      LOG(INFO) << "Benchmarking OpenMP SIMD";
-      return Benchmark(position, translation, [](Vec4<> p, Mat4<> t) {
-        return MultiplyWithOpenMP(t, p);
-      });
+  auto kernels = FindKernels(backend, variant);
+  if (!kernels.has_value()) {
+    return std::unexpected{kernels.error()};
+  }
+
+  LOG(INFO) << "Benchmarking " << BackendName(backend) << " with "
+            << CpuVariantName(variant) << " kernels";
+  return Benchmark(
+      position, translation,
+      [multiply = kernels->multiply_vec4](Vec4<> p, Mat4<> t) {
+        return multiply(t, p);
+      },
+      options);
+}
+
+/**
+ * Calls func with a std::integral_constant holding size, so that it can be
+ * used as a template argument.
+ *
+ * @param size One of kSquareMatrixSizes.
+ * @param func The function to call.
+ * @return The result of func, or kUnknownSize.
+ */
+template <typename F, typename R = std::invoke_result_t<
+                          F, std::integral_constant<size_t, 16>>>
+[[nodiscard]] std::expected<R, BenchmarkError> WithSquareSize(size_t size,
+                                                              F func) {
+  // Keep in sync with kSquareMatrixSizes.
+  switch (size) {
+    case 16:
+      return func(std::integral_constant<size_t, 16>());
+    case 32:
+      return func(std::integral_constant<size_t, 32>());
+    case 64:
+      return func(std::integral_constant<size_t, 64>());
+    case 128:
+      return func(std::integral_constant<size_t, 128>());
+    case 256:
+      return func(std::integral_constant<size_t, 256>());
+    case 512:
+      return func(std::integral_constant<size_t, 512>());
+    default:
+      return std::unexpected{BenchmarkError::kUnknownSize};
+  }
+}
+
+/**
+ * Benchmarks a given square matrix multiply operation.
+ *
+ * The matrices are heap allocated since the larger sizes don't fit on the
+ * stack of the thread that runs the benchmarks.
+ *
+ * @tparam Size The number of rows and columns in each matrix.
+ * @param func The multiplication function to use.
+ * @param options Controls how the benchmark is measured.
+ * @return The statistics for a single multiply.
+ */
+template <size_t Size>
+[[nodiscard, clang::noinline]] BenchmarkStats BenchmarkSquareMultiply(
+    SquareMultiplyKernel<Size> func, const HarnessOptions& options) {
+  auto lhs = std::make_unique<Matrix<Size, Size>>();
+  auto rhs = std::make_unique<Matrix<Size, Size>>();
+  auto result = std::make_unique<Matrix<Size, Size>>();
+  InitSquareOperands(*lhs, *rhs);
+
+  return RunBenchmark([&]() { func(*lhs, *rhs, *result); }, options);
+}
+
+[[nodiscard]] std::expected<BenchmarkStats, BenchmarkError>
+BenchmarkSquareMatrixMultiplication(Backend backend, size_t size,
+                                    const HarnessOptions& options,
+                                    CpuVariant variant) {
+  if (std::ranges::find(kSquareMatrixSizes, size) == kSquareMatrixSizes.end()) {
+    return std::unexpected{BenchmarkError::kUnknownSize};
+  }
+
+  auto kernels = FindKernels(backend, variant);
+  if (!kernels.has_value()) {
+    return std::unexpected{kernels.error()};
+  }
+
+  LOG(INFO) << "Benchmarking " << BackendName(backend) << " with "
+            << CpuVariantName(variant) << " kernels, " << size << "x" << size;
+  return WithSquareSize(size, [&](auto size_constant) {
+    constexpr size_t kSize = decltype(size_constant)::value;
+    return BenchmarkSquareMultiply<kSize>(
+        kernels->square_multiply_kernel<kSize>(), options);
+  });
+}
+
+std::string_view PrecisionName(Precision precision) {
+  switch (precision) {
+    case Precision::kFloat32:
+      return "f32";
+    case Precision::kFloat16:
+      return "f16";
+    case Precision::kInt8:
+      return "i8";
+    default:
+      return "unknown";
+  }
+}
+
+/**
+ * Benchmarks a given square matrix multiply operation at a reduced precision.
+ *
+ * @tparam Size The number of rows and columns in each matrix.
+ * @tparam precision The number format that func multiplies in.
+ * @param func The multiplication function to use.
+ * @param options Controls how the benchmark is measured.
+ * @return The statistics for a single multiply and the error of its result.
+ */
+template <size_t Size, Precision precision>
+[[nodiscard, clang::noinline]] PrecisionBenchmarkStats
+BenchmarkPrecisionMultiply(SquareMultiplyKernel<Size, precision> func,
+                           const HarnessOptions& options) {
+  using Cell = PrecisionTraits<precision>::Cell;
+  using Accumulator = PrecisionTraits<precision>::Accumulator;
+
+  auto lhs = std::make_unique<Matrix<Size, Size>>();
+  auto rhs = std::make_unique<Matrix<Size, Size>>();
+  InitPrecisionOperands(*lhs, *rhs);
+  const std::vector<double> expected = ExactMultiply(*lhs, *rhs);
+
+  auto converted_lhs = std::make_unique<Matrix<Size, Size, Cell>>();
+  auto converted_rhs = std::make_unique<Matrix<Size, Size, Cell>>();
+  auto result = std::make_unique<Matrix<Size, Size, Accumulator>>();
+  const float lhs_scale = Quantize(*lhs, *converted_lhs);
+  const float rhs_scale = Quantize(*rhs, *converted_rhs);
+
+  func(*converted_lhs, *converted_rhs, *result);
+  PrecisionBenchmarkStats stats;
+  stats.max_error = MaxError(*result, lhs_scale * rhs_scale, expected);
+
+  stats.stats = RunBenchmark(
+      [&]() { func(*converted_lhs, *converted_rhs, *result); }, options);
+  return stats;
+}
+
+[[nodiscard]] std::expected<PrecisionBenchmarkStats, BenchmarkError>
+BenchmarkSquareMatrixMultiplication(Backend backend, size_t size,
+                                    Precision precision,
+                                    const HarnessOptions& options,
+                                    CpuVariant variant) {
+  if (std::ranges::find(kPrecisions, precision) == kPrecisions.end()) {
+    return std::unexpected{BenchmarkError::kUnknownPrecision};
+  }
+  if (std::ranges::find(kSquareMatrixSizes, size) == kSquareMatrixSizes.end()) {
+    return std::unexpected{BenchmarkError::kUnknownSize};
+  }
+
+  auto kernels = FindKernels(backend, variant);
+  if (!kernels.has_value()) {
+    return std::unexpected{kernels.error()};
+  }
+
+  LOG(INFO) << "Benchmarking " << BackendName(backend) << " with "
+            << CpuVariantName(variant) << " kernels, " << size << "x" << size
+            << ", " << PrecisionName(precision);
+  return WithSquareSize(size, [&](auto size_constant) {
+    constexpr size_t kSize = decltype(size_constant)::value;
+    switch (precision) {
+      case Precision::kFloat32:
+        return BenchmarkPrecisionMultiply<kSize, Precision::kFloat32>(
+            kernels->square_multiply_kernel<kSize, Precision::kFloat32>(),
+            options);
+      case Precision::kFloat16:
+        return BenchmarkPrecisionMultiply<kSize, Precision::kFloat16>(
+            kernels->square_multiply_kernel<kSize, Precision::kFloat16>(),
+            options);
+      case Precision::kInt8:
+        return BenchmarkPrecisionMultiply<kSize, Precision::kInt8>(
+            kernels->square_multiply_kernel<kSize, Precision::kInt8>(),
+            options);
+      default:
+        std::unreachable();
+    }
+  });
+}
+
+/**
+ * Benchmarks a given batched transform operation.
+ *
+ * As with Benchmark, the transform is given as a callback to keep the harness
+ * from being optimized differently for each implementation.
+ *
+ * @param batch_size The number of points in each batch.
+ * @param func The transform function to use.
+ * @param options Controls how the benchmark is measured.
+ * @return The statistics for transforming a single batch.
+ */
+[[nodiscard, clang::noinline]] BenchmarkStats BenchmarkTransform(
+    size_t batch_size, TransformKernel func, const HarnessOptions& options) {
+  Mat4<> translation = Translation();
+  PointBuffer input(batch_size);
+  InitPoints(input.view());
+  PointBuffer output(batch_size);
+
+  return RunBenchmark(
+      [&]() { func(translation, input.view(), output.view()); }, options);
+}
+
+[[nodiscard]] std::expected<BenchmarkStats, BenchmarkError>
+BenchmarkTransformPoints(Backend backend, size_t batch_size,
+                         const HarnessOptions& options, CpuVariant variant) {
+  auto kernels = FindKernels(backend, variant);
+  if (!kernels.has_value()) {
+    return std::unexpected{kernels.error()};
+  }
+
+  LOG(INFO) << "Benchmarking batched " << BackendName(backend) << " with "
+            << CpuVariantName(variant) << " kernels, " << batch_size
+            << " points";
+  return BenchmarkTransform(batch_size, kernels->transform_points, options);
+}
+
+std::string_view MatrixOperationName(MatrixOperation operation) {
+  switch (operation) {
+    case MatrixOperation::kTranspose:
+      return "transpose";
+    case MatrixOperation::kDeterminant:
+      return "determinant";
+    case MatrixOperation::kInverse:
+      return "inverse";
+    default:
+      return "unknown";
+  }
+}
+
+/**
+ * Benchmarks a transpose kernel.
+ *
+ * @tparam Size The number of rows and columns in each matrix.
+ * @param func The transpose function to use.
+ * @param options Controls how the benchmark is measured.
+ * @return The statistics for a batch of kMatrixOperationBatchSize calls.
+ */
+template <size_t Size>
+[[nodiscard, clang::noinline]] BenchmarkStats BenchmarkTranspose(
+    TransposeKernel<Size> func, const HarnessOptions& options) {
+  const auto inputs = MakeOperationInputs<Size>();
+  std::vector<Matrix<Size, Size>> outputs(inputs.size());
+  auto body = [&]() {
+    for (size_t i = 0; i < inputs.size(); i++) {
+      func(inputs[i], outputs[i]);
+    }
+  };
+
+  return RunBenchmark(body, options);
+}
+
+/**
+ * Benchmarks a determinant kernel.
+ *
+ * @tparam Size The number of rows and columns in each matrix.
+ * @param func The determinant function to use.
+ * @param options Controls how the benchmark is measured.
+ * @return The statistics for a batch of kMatrixOperationBatchSize calls.
+ */
+template <size_t Size>
+[[nodiscard, clang::noinline]] BenchmarkStats BenchmarkDeterminant(
+    DeterminantKernel<Size> func, const HarnessOptions& options) {
+  const auto inputs = MakeOperationInputs<Size>();
+  std::vector<float> outputs(inputs.size());
+  auto body = [&]() {
+    for (size_t i = 0; i < inputs.size(); i++) {
+      outputs[i] = func(inputs[i]);
+    }
+  };
+
+  return RunBenchmark(body, options);
+}
+
+/**
+ * Benchmarks an inverse kernel.
+ *
+ * @tparam Size The number of rows and columns in each matrix.
+ * @param func The inverse function to use.
+ * @param options Controls how the benchmark is measured.
+ * @return The statistics for a batch of kMatrixOperationBatchSize calls.
+ */
+template <size_t Size>
+[[nodiscard, clang::noinline]] BenchmarkStats BenchmarkInverse(
+    InverseKernel<Size> func, const HarnessOptions& options) {
+  const auto inputs = MakeOperationInputs<Size>();
+  std::vector<Matrix<Size, Size>> outputs(inputs.size());
+  auto body = [&]() {
+    for (size_t i = 0; i < inputs.size(); i++) {
+      func(inputs[i], outputs[i]);
+    }
+  };
+
+  return RunBenchmark(body, options);
+}
+
+[[nodiscard]] std::expected<BenchmarkStats, BenchmarkError>
+BenchmarkMatrixOperation(Backend backend, MatrixOperation operation,
+                         size_t size, const HarnessOptions& options,
+                         CpuVariant variant) {
+  if (std::ranges::find(kMatrixOperations, operation) ==
+      kMatrixOperations.end()) {
+    return std::unexpected{BenchmarkError::kUnknownOperation};
+  }
+
+  auto kernels = FindKernels(backend, variant);
+  if (!kernels.has_value()) {
+    return std::unexpected{kernels.error()};
+  }
+
+  auto run = [&](auto size_constant) {
+    constexpr size_t kSize = decltype(size_constant)::value;
+    LOG(INFO) << "Benchmarking " << MatrixOperationName(operation) << " with "
+              << BackendName(backend) << " and " << CpuVariantName(variant)
+              << " kernels, " << kSize << "x" << kSize;
+    switch (operation) {
+      case MatrixOperation::kTranspose:
+        return BenchmarkTranspose<kSize>(kernels->transpose_kernel<kSize>(),
+                                         options);
+      case MatrixOperation::kDeterminant:
+        return BenchmarkDeterminant<kSize>(
+            kernels->determinant_kernel<kSize>(), options);
+      case MatrixOperation::kInverse:
+        return BenchmarkInverse<kSize>(kernels->inverse_kernel<kSize>(),
+                                       options);
+      default:
+        // Checked above.
+        std::unreachable();
+    }
+  };
+
+  // Keep in sync with kMatrixOperationSizes.
+  switch (size) {
+    case 3:
+      return run(std::integral_constant<size_t, 3>());
+    case 4:
+      return run(std::integral_constant<size_t, 4>());
+    default:
+      return std::unexpected{BenchmarkError::kUnknownSize};
+  }
+}
+
+std::string_view EvaluationName(Evaluation evaluation) {
+  switch (evaluation) {
+    case Evaluation::kEager:
+      return "eager";
+    case Evaluation::kFused:
+      return "fused";
+    default:
+      return "unknown";
+  }
+}
+
+/**
+ * Transforms every vertex with Matrix::operator*.
+ */
+[[clang::noinline]] static void TransformMvpEager(
+    const MvpInputs& inputs, std::span<Vec4<>> out) {
+  for (size_t i = 0; i < out.size(); i++) {
+    out[i] =
+        inputs.projection * inputs.view * inputs.models[i] * inputs.vertices[i];
+  }
+}
+
+/**
+ * Transforms every vertex with the expressions in matrix_expression.h.
+ */
+[[clang::noinline]] static void TransformMvpFused(
+    const MvpInputs& inputs, std::span<Vec4<>> out) {
+  for (size_t i = 0; i < out.size(); i++) {
+    Evaluate(Lazy(inputs.projection) * Lazy(inputs.view) *
+                 Lazy(inputs.models[i]) * Lazy(inputs.vertices[i]),
+             out[i]);
+  }
+}
+
+[[nodiscard]] std::expected<BenchmarkStats, BenchmarkError>
+BenchmarkMvpTransform(Evaluation evaluation, const HarnessOptions& options) {
+  if (std::ranges::find(kEvaluations, evaluation) == kEvaluations.end()) {
+    return std::unexpected{BenchmarkError::kUnknownEvaluation};
+  }
+
+  const MvpInputs inputs = MakeMvpInputs();
+  std::vector<Vec4<>> eager(kMvpBatchSize);
+  std::vector<Vec4<>> fused(kMvpBatchSize);
+
+  LOG(INFO) << "Benchmarking " << EvaluationName(evaluation)
+            << " MVP transforms";
+  auto transform = evaluation == Evaluation::kEager ? TransformMvpEager
+                                                    : TransformMvpFused;
+  auto& out = evaluation == Evaluation::kEager ? eager : fused;
+  return RunBenchmark([&]() { transform(inputs, out); }, options);
+}
+
+std::string_view ScalingName(Scaling scaling) {
+  switch (scaling) {
+    case Scaling::kStrong:
+      return "strong";
+    case Scaling::kWeak:
+      return "weak";
     default:
-      return std::unexpected{BenchmarkError::kUnknownBackend};
+      return "unknown";
+  }
+}
+
+/**
+ * Returns the options for measuring a parallel benchmark.
+ *
+ * PerfCounters only count the calling thread, which does only part of the
+ * work, so counters are never collected for these.
+ */
+[[nodiscard]] static HarnessOptions ParallelHarnessOptions(
+    const HarnessOptions& options) {
+  HarnessOptions result = options;
+  result.collect_counters = false;
+  return result;
+}
+
+/**
+ * Checks the preconditions shared by the parallel benchmarks.
+ */
+[[nodiscard]] static std::expected<Kernels, BenchmarkError>
+FindParallelKernels(Backend backend, CpuVariant variant,
+                    const ParallelOptions& parallel) {
+  if (parallel.threads == 0) {
+    return std::unexpected{BenchmarkError::kInvalidThreadCount};
   }
+  return FindKernels(backend, variant);
+}
+
+/**
+ * Benchmarks a square matrix multiply on multiple threads.
+ *
+ * @tparam Size The number of rows and columns in each matrix.
+ * @param func The multiplication function to use.
+ * @param parallel Controls how the work is divided between threads.
+ * @param options Controls how the benchmark is measured.
+ * @return The statistics for a single iteration.
+ */
+template <size_t Size>
+[[nodiscard, clang::noinline]] BenchmarkStats BenchmarkParallelSquareMultiply(
+    SquareMultiplyColumnsKernel<Size> func, const ParallelOptions& parallel,
+    const HarnessOptions& options) {
+  struct Problem {
+    Matrix<Size, Size> lhs;
+    Matrix<Size, Size> rhs;
+    Matrix<Size, Size> result;
+  };
+  std::vector<std::unique_ptr<Problem>> problems;
+  for (size_t i = 0; i < parallel.problems(); i++) {
+    auto& problem = problems.emplace_back(std::make_unique<Problem>());
+    InitSquareOperands(problem->lhs, problem->rhs);
+  }
+
+  ParallelRunner runner(parallel.threading, parallel.threads);
+  auto body = [&]() {
+    runner.Run([&](size_t thread) {
+      if (problems.size() > 1) {
+        auto& problem = *problems[thread];
+        func(problem.lhs, problem.rhs, problem.result, 0, Size);
+        return;
+      }
+
+      auto& problem = *problems.front();
+      auto [first, last] =
+          Partition(Size, runner.threads(), thread, kMicroTileColumns);
+      if (first < last) {
+        func(problem.lhs, problem.rhs, problem.result, first, last);
+      }
+    });
+  };
+
+  return RunBenchmark(body, ParallelHarnessOptions(options));
+}
+
+[[nodiscard]] std::expected<BenchmarkStats, BenchmarkError>
+BenchmarkParallelSquareMatrixMultiplication(Backend backend, size_t size,
+                                            const ParallelOptions& parallel,
+                                            const HarnessOptions& options,
+                                            CpuVariant variant) {
+  if (std::ranges::find(kSquareMatrixSizes, size) == kSquareMatrixSizes.end()) {
+    return std::unexpected{BenchmarkError::kUnknownSize};
+  }
+
+  auto kernels = FindParallelKernels(backend, variant, parallel);
+  if (!kernels.has_value()) {
+    return std::unexpected{kernels.error()};
+  }
+
+  LOG(INFO) << "Benchmarking parallel " << BackendName(backend) << " with "
+            << CpuVariantName(variant) << " kernels, " << size << "x" << size
+            << ", " << parallel.threads << " threads, "
+            << ThreadingName(parallel.threading) << ", "
+            << ScalingName(parallel.scaling) << " scaling";
+  return WithSquareSize(size, [&](auto size_constant) {
+    constexpr size_t kSize = decltype(size_constant)::value;
+    return BenchmarkParallelSquareMultiply<kSize>(
+        kernels->square_multiply_columns_kernel<kSize>(), parallel, options);
+  });
+}
+
+[[nodiscard]] std::expected<BenchmarkStats, BenchmarkError>
+BenchmarkParallelTransformPoints(Backend backend, size_t batch_size,
+                                 const ParallelOptions& parallel,
+                                 const HarnessOptions& options,
+                                 CpuVariant variant) {
+  auto kernels = FindParallelKernels(backend, variant, parallel);
+  if (!kernels.has_value()) {
+    return std::unexpected{kernels.error()};
+  }
+
+  LOG(INFO) << "Benchmarking parallel batched " << BackendName(backend)
+            << " with " << CpuVariantName(variant) << " kernels, "
+            << batch_size << " points, " << parallel.threads << " threads, "
+            << ThreadingName(parallel.threading) << ", "
+            << ScalingName(parallel.scaling) << " scaling";
+
+  const TransformKernel func = kernels->transform_points;
+  Mat4<> translation = Translation();
+  std::vector<PointBuffer> inputs;
+  std::vector<PointBuffer> outputs;
+  for (size_t i = 0; i < parallel.problems(); i++) {
+    InitPoints(inputs.emplace_back(batch_size).view());
+    outputs.emplace_back(batch_size);
+  }
+
+  // Split strong scaling batches on a 64 byte boundary, so that no two
+  // threads write to the same cache line.
+  constexpr size_t kGranularity = 64 / sizeof(float);
+  ParallelRunner runner(parallel.threading, parallel.threads);
+  auto body = [&]() {
+    runner.Run([&](size_t thread) {
+      if (inputs.size() > 1) {
+        func(translation, inputs[thread].view(), outputs[thread].view());
+        return;
+      }
+
+      auto [begin, end] =
+          Partition(batch_size, runner.threads(), thread, kGranularity);
+      if (begin < end) {
+        func(translation, inputs.front().view().subspan(begin, end - begin),
+             outputs.front().view().subspan(begin, end - begin));
+      }
+    });
+  };
+
+  return RunBenchmark(body, ParallelHarnessOptions(options));
 }
 
 }  // namespace samples::vectorization
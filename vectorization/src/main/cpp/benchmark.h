@@ -16,9 +16,17 @@
 
 #pragma once
 
-#include <chrono>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
 #include <expected>
 #include <optional>
+#include <string_view>
+
+#include "cpu_variant.h"
+#include "harness.h"
+#include "parallel.h"
 
 namespace samples::vectorization {
 
@@ -29,7 +37,8 @@ enum class Backend : uint8_t {
   /// Auto-vectorization only.
   kAutoVectorization = 0,
 
-  /// C++ std::simd.
+  /// C++ std::simd. Until the NDK's std::simd is usable, this is a
+  /// compatible subset implemented in simd.h.
   kCxxSimd = 1,
 
   /// Clang's arch-generic vector types.
@@ -42,7 +51,19 @@ enum class Backend : uint8_t {
   kOpenMp = 4,
 };
 
-/// Errors returned by BenchmarkMatrixMultiplication.
+/// Every backend, in order.
+inline constexpr std::array<Backend, 5> kBackends = {
+    Backend::kAutoVectorization, Backend::kCxxSimd, Backend::kClangVector,
+    Backend::kClangMatrix,       Backend::kOpenMp,
+};
+
+/**
+ * Returns a short, stable name for the backend, suitable for machine readable
+ * output.
+ */
+[[nodiscard]] std::string_view BackendName(Backend backend);
+
+/// Errors returned by the benchmark functions.
 enum class BenchmarkError : int8_t {
   /// Indicates that the requested backend has not yet been implemented.
   kNotImplemented = -1,
@@ -50,18 +71,359 @@ enum class BenchmarkError : int8_t {
   kNotSupported = -2,
   /// Indicates that an unknown backend was requested.
   kUnknownBackend = -3,
+  /// Indicates that the requested problem size is not one that was built.
+  kUnknownSize = -4,
+  /// Indicates that a parallel benchmark was asked to use zero threads.
+  kInvalidThreadCount = -5,
+  /// Indicates that an unknown MatrixOperation was requested.
+  kUnknownOperation = -6,
+  /// Indicates that an unknown Precision was requested.
+  kUnknownPrecision = -7,
+  /// Indicates that an unknown Evaluation was requested.
+  kUnknownEvaluation = -8,
+};
+
+/**
+ * Benchmarks multiplying a Vec4 by a Mat4 with the given backend.
+ *
+ * @param backend The backend to benchmark.
+ * @param options Controls how the benchmark is measured.
+ * @param variant The instruction set to use. Returns kNotSupported if the
+ * device can't run it.
+ * @return The statistics for a single multiply, or an error code.
+ */
+[[nodiscard]] std::expected<BenchmarkStats, BenchmarkError>
+BenchmarkMatrixMultiplication(Backend backend,
+                              const HarnessOptions& options = {},
+                              CpuVariant variant = BestCpuVariant());
+
+/// The matrix sizes that the app benchmarks with
+/// BenchmarkSquareMatrixMultiplication. The larger sizes no longer fit in L1
+/// (at 64x64 each float operand is 16 KiB) or L2 (at 512x512, 1 MiB).
+inline constexpr std::array<size_t, 6> kSquareMatrixSizes = {
+    16, 32, 64, 128, 256, 512,
+};
+
+/**
+ * Benchmarks multiplying two square matrices with the given backend.
+ *
+ * Only the sizes in kSquareMatrixSizes are supported, since matrix sizes are
+ * compile time constants.
+ *
+ * @param backend The backend to benchmark.
+ * @param size The number of rows and columns in each matrix.
+ * @param options Controls how the benchmark is measured.
+ * @param variant The instruction set to use. Returns kNotSupported if the
+ * device can't run it.
+ * @return The statistics for a single multiply, or an error code.
+ */
+[[nodiscard]] std::expected<BenchmarkStats, BenchmarkError>
+BenchmarkSquareMatrixMultiplication(Backend backend, size_t size,
+                                    const HarnessOptions& options = {},
+                                    CpuVariant variant = BestCpuVariant());
+
+/// The number of floating point operations in a square matrix multiply.
+[[nodiscard]] constexpr double SquareMatrixMultiplyFlops(size_t size) {
+  // Each cell of the result is size multiplies and size adds.
+  return 2.0 * static_cast<double>(size) * static_cast<double>(size) *
+         static_cast<double>(size);
+}
+
+/**
+ * The number formats that square matrices can be multiplied in.
+ */
+enum class Precision : uint8_t {
+  /// 32-bit floats, accumulated in 32-bit floats.
+  kFloat32 = 0,
+
+  /// 16-bit floats (_Float16), accumulated in 16-bit floats. Only hardware
+  /// with half precision arithmetic (arm64 from Armv8.2 with FP16, or x86 with
+  /// AVX512-FP16) does this natively. Elsewhere Clang converts each operation
+  /// to and from float, which is much slower than kFloat32.
+  kFloat16 = 1,
+
+  /// 8-bit integers, accumulated in 32-bit integers. Each operand is quantized
+  /// from floats with a single scale for the whole matrix (a per-tensor
+  /// scale), and the result is converted back with the product of the scales.
+  kInt8 = 2,
+};
+
+/// Every Precision, in order.
+inline constexpr std::array<Precision, 3> kPrecisions = {
+    Precision::kFloat32,
+    Precision::kFloat16,
+    Precision::kInt8,
+};
+
+/**
+ * Returns a short, stable name for the precision, suitable for machine
+ * readable output.
+ */
+[[nodiscard]] std::string_view PrecisionName(Precision precision);
+
+/**
+ * The results of benchmarking a matrix multiply at a given Precision.
+ */
+struct PrecisionBenchmarkStats {
+  /// The statistics for a single multiply.
+  BenchmarkStats stats;
+
+  /// The largest absolute difference between a cell of the result (converted
+  /// back to float) and the same cell of the exact product, divided by the
+  /// largest magnitude in the exact product. This makes the errors of every
+  /// size comparable.
+  double max_error = 0;
+};
+
+/**
+ * Benchmarks multiplying two square matrices with the given backend and
+ * precision, and measures the accuracy of the result.
+ *
+ * The operands are the same float matrices for every precision. Converting
+ * them to the precision's format and converting the result back is not part
+ * of the measured time. Fails with a CHECK if the error is larger than
+ * expected for the precision.
+ *
+ * @param backend The backend to benchmark.
+ * @param size The number of rows and columns in each matrix. Must be one of
+ * kSquareMatrixSizes.
+ * @param precision The number format to multiply in.
+ * @param options Controls how the benchmark is measured.
+ * @param variant The instruction set to use. Returns kNotSupported if the
+ * device can't run it.
+ * @return The statistics for a single multiply and its error, or an error
+ * code.
+ */
+[[nodiscard]] std::expected<PrecisionBenchmarkStats, BenchmarkError>
+BenchmarkSquareMatrixMultiplication(Backend backend, size_t size,
+                                    Precision precision,
+                                    const HarnessOptions& options = {},
+                                    CpuVariant variant = BestCpuVariant());
+
+/// The batch sizes that the app benchmarks with BenchmarkTransformPoints.
+inline constexpr std::array<size_t, 3> kTransformBatchSizes = {
+    1'024,
+    65'536,
+    1'048'576,
+};
+
+/**
+ * Benchmarks transforming a batch of points with the given backend.
+ *
+ * Each iteration transforms every point in a batch of the given size by a
+ * Mat4.
+ *
+ * @param backend The backend to benchmark.
+ * @param batch_size The number of points in each batch.
+ * @param options Controls how the benchmark is measured.
+ * @param variant The instruction set to use. Returns kNotSupported if the
+ * device can't run it.
+ * @return The statistics for transforming a single batch, or an error code.
+ */
+[[nodiscard]] std::expected<BenchmarkStats, BenchmarkError>
+BenchmarkTransformPoints(Backend backend, size_t batch_size,
+                         const HarnessOptions& options = {},
+                         CpuVariant variant = BestCpuVariant());
+
+/**
+ * The single matrix operations other than multiplication that are
+ * benchmarked.
+ */
+enum class MatrixOperation : uint8_t {
+  kTranspose = 0,
+  kDeterminant = 1,
+  kInverse = 2,
 };
 
+/// Every MatrixOperation, in order.
+inline constexpr std::array<MatrixOperation, 3> kMatrixOperations = {
+    MatrixOperation::kTranspose,
+    MatrixOperation::kDeterminant,
+    MatrixOperation::kInverse,
+};
+
+/**
+ * Returns a short, stable name for the operation, suitable for machine
+ * readable output.
+ */
+[[nodiscard]] std::string_view MatrixOperationName(MatrixOperation operation);
+
+/// The matrix sizes supported by BenchmarkMatrixOperation.
+inline constexpr std::array<size_t, 2> kMatrixOperationSizes = {3, 4};
+
+/// The number of matrices processed by each iteration of
+/// BenchmarkMatrixOperation. A single 4x4 inverse takes only a few
+/// nanoseconds, so one per iteration would mostly measure the harness.
+inline constexpr size_t kMatrixOperationBatchSize = 256;
+
+/**
+ * Benchmarks transposing, inverting, or finding the determinant of small
+ * square matrices with the given backend.
+ *
+ * Each iteration applies the operation to kMatrixOperationBatchSize different
+ * matrices, one call at a time, as per-frame camera or skinning code would.
+ *
+ * @param backend The backend to benchmark.
+ * @param operation The operation to benchmark.
+ * @param size The number of rows and columns in each matrix. Must be one of
+ * kMatrixOperationSizes.
+ * @param options Controls how the benchmark is measured.
+ * @param variant The instruction set to use. Returns kNotSupported if the
+ * device can't run it.
+ * @return The statistics for a single batch, or an error code.
+ */
+[[nodiscard]] std::expected<BenchmarkStats, BenchmarkError>
+BenchmarkMatrixOperation(Backend backend, MatrixOperation operation,
+                         size_t size, const HarnessOptions& options = {},
+                         CpuVariant variant = BestCpuVariant());
+
+/**
+ * How BenchmarkMvpTransform evaluates each chain of products.
+ */
+enum class Evaluation : uint8_t {
+  /// With Matrix::operator*, left to right, storing each intermediate
+  /// product.
+  kEager = 0,
+
+  /// With the lazy expressions in matrix_expression.h, in the order that
+  /// needs the fewest multiplies, without storing intermediate products.
+  kFused = 1,
+};
+
+/// Every Evaluation, in order.
+inline constexpr std::array<Evaluation, 2> kEvaluations = {
+    Evaluation::kEager,
+    Evaluation::kFused,
+};
+
+/**
+ * Returns a short, stable name for the evaluation strategy, suitable for
+ * machine readable output.
+ */
+[[nodiscard]] std::string_view EvaluationName(Evaluation evaluation);
+
+/// The number of vertices transformed by each iteration of
+/// BenchmarkMvpTransform.
+inline constexpr size_t kMvpBatchSize = 256;
+
+/**
+ * Benchmarks transforming vertices by a model-view-projection chain,
+ * `projection * view * model * vertex`, where each vertex has its own model
+ * matrix, as instanced geometry would.
+ *
+ * Both strategies use Clang's matrix types, and are built for the baseline
+ * CpuVariant only, so the difference between them is only the order of
+ * evaluation and the intermediate stores.
+ *
+ * @param evaluation How to evaluate each chain.
+ * @param options Controls how the benchmark is measured.
+ * @return The statistics for transforming kMvpBatchSize vertices, or an error
+ * code.
+ */
+[[nodiscard]] std::expected<BenchmarkStats, BenchmarkError>
+BenchmarkMvpTransform(Evaluation evaluation,
+                      const HarnessOptions& options = {});
+
+/**
+ * How the problem size of a parallel benchmark changes with the number of
+ * threads.
+ */
+enum class Scaling : uint8_t {
+  /// One problem of the given size is split between the threads. Ideally the
+  /// time per iteration is inversely proportional to the number of threads.
+  kStrong = 0,
+
+  /// Each thread gets its own problem of the given size. Ideally the time per
+  /// iteration doesn't change with the number of threads.
+  kWeak = 1,
+};
+
+/// Every Scaling, in order.
+inline constexpr std::array<Scaling, 2> kScalings = {
+    Scaling::kStrong,
+    Scaling::kWeak,
+};
+
+/**
+ * Returns a short, stable name for the scaling mode, suitable for machine
+ * readable output.
+ */
+[[nodiscard]] std::string_view ScalingName(Scaling scaling);
+
+/**
+ * Controls how a parallel benchmark divides its work between threads.
+ */
+struct ParallelOptions {
+  /// How the threads are run.
+  Threading threading = Threading::kThreadPool;
+
+  /// Whether the problem is shared by the threads or repeated for each one.
+  Scaling scaling = Scaling::kStrong;
+
+  /// The number of threads, including the one that runs the benchmark.
+  uint32_t threads = 1;
+
+  /// The number of problems of the requested size solved by each iteration.
+  [[nodiscard]] constexpr size_t problems() const {
+    return scaling == Scaling::kWeak ? threads : 1;
+  }
+};
+
+/// The matrix size used by the app for
+/// BenchmarkParallelSquareMatrixMultiplication.
+inline constexpr size_t kParallelSquareMatrixSize = 512;
+
+/// The batch size used by the app for BenchmarkParallelTransformPoints. Each
+/// batch is 8 MiB of input and output, which is more than the L2 of any one
+/// core.
+inline constexpr size_t kParallelTransformBatchSize = 262'144;
+
+/**
+ * Benchmarks multiplying square matrices on multiple threads.
+ *
+ * With strong scaling, the columns of the result are split evenly between the
+ * threads. With weak scaling, each thread multiplies its own pair of matrices.
+ * Either way, every size uses BlockedMultiply's algorithm.
+ *
+ * PerfCounters would only count the calling thread's share of the work, so
+ * options.collect_counters is ignored.
+ *
+ * @param backend The backend to benchmark.
+ * @param size The number of rows and columns in each matrix. Must be one of
+ * kSquareMatrixSizes.
+ * @param parallel Controls how the work is divided between threads.
+ * @param options Controls how the benchmark is measured.
+ * @param variant The instruction set to use. Returns kNotSupported if the
+ * device can't run it.
+ * @return The statistics for a single iteration, which computes
+ * parallel.problems() products, or an error code.
+ */
+[[nodiscard]] std::expected<BenchmarkStats, BenchmarkError>
+BenchmarkParallelSquareMatrixMultiplication(
+    Backend backend, size_t size, const ParallelOptions& parallel,
+    const HarnessOptions& options = {}, CpuVariant variant = BestCpuVariant());
+
 /**
- * Benchmarks the given matrix multiply backend.
+ * Benchmarks transforming batches of points on multiple threads.
  *
- * The chosen backend will run a predetermined number of times and return the
- * average execution time.
+ * With strong scaling, the batch is split evenly between the threads. With
+ * weak scaling, each thread transforms its own batch. As with
+ * BenchmarkParallelSquareMatrixMultiplication, options.collect_counters is
+ * ignored.
  *
  * @param backend The backend to benchmark.
- * @return The average execution time, or an error code.
+ * @param batch_size The number of points in each batch.
+ * @param parallel Controls how the work is divided between threads.
+ * @param options Controls how the benchmark is measured.
+ * @param variant The instruction set to use. Returns kNotSupported if the
+ * device can't run it.
+ * @return The statistics for a single iteration, which transforms
+ * parallel.problems() batches, or an error code.
  */
-[[nodiscard]] std::expected<std::chrono::nanoseconds, BenchmarkError>
-BenchmarkMatrixMultiplication(Backend backend);
+[[nodiscard]] std::expected<BenchmarkStats, BenchmarkError>
+BenchmarkParallelTransformPoints(Backend backend, size_t batch_size,
+                                 const ParallelOptions& parallel,
+                                 const HarnessOptions& options = {},
+                                 CpuVariant variant = BestCpuVariant());
 
 }  // namespace samples::vectorization
@@ -0,0 +1,368 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Command line driver for the vectorization benchmarks. This is only built for
+// the host (see CMakeLists.txt), so the benchmarks can be run and tracked
+// without an Android device or JNI.
+//
+// Usage: vectorization_benchmark [--format=csv|json] [--output=PATH]
+//            [--trials=N] [--warmup=N] [--min-trial-ms=N] [--filter=TEXT]
+//            [--counters=0|1] [--variant=best|all|NAME] [--max-threads=N]
+//
+// Results are written to stdout (or PATH) in the format described by WriteCsv
+// or WriteJson in harness.h. Logs go to stderr. --filter runs only the
+// benchmarks whose "benchmark/backend/size/variant" name contains TEXT.
+// --counters=1 also records hardware performance counters where the kernel
+// allows it, except for the parallel benchmarks.
+// --variant chooses which CpuVariant of the kernels to run: the best one the
+// CPU supports (the default, and what the app uses), every supported one, or
+// the one with the given name (see CpuVariantName).
+// --max-threads=N also runs the parallel benchmarks with every Threading and
+// Scaling for 1 to N threads. Their names have "/threading/scaling/threads"
+// appended. They're skipped by default, since N should usually be the number
+// of cores of one type.
+// The names of the precision_square_multiply benchmarks have "/precision"
+// appended, and their records include the max_error of the result.
+// The mvp_eager and mvp_fused benchmarks are only built for the baseline
+// variant, so they're run once regardless of --variant.
+
+#include <base/logging.h>
+#include <stdlib.h>
+
+#include <expected>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "benchmark.h"
+#include "cpu_variant.h"
+#include "harness.h"
+#include "parallel.h"
+
+using namespace samples::vectorization;
+
+namespace {
+
+struct Options {
+  std::string format = "csv";
+  std::optional<std::string> output;
+  std::string filter;
+  std::vector<CpuVariant> variants = {BestCpuVariant()};
+  uint32_t max_threads = 0;
+  HarnessOptions harness;
+};
+
+[[noreturn]] void Usage(std::string_view error) {
+  std::cerr << error << "\n"
+            << "usage: vectorization_benchmark [--format=csv|json] "
+               "[--output=PATH] [--trials=N] [--warmup=N] [--min-trial-ms=N] "
+               "[--filter=TEXT] [--counters=0|1] "
+               "[--variant=best|all|NAME] [--max-threads=N]\n";
+  exit(EXIT_FAILURE);
+}
+
+uint32_t ParseCount(std::string_view flag, std::string_view value) {
+  char* end = nullptr;
+  std::string str(value);
+  unsigned long result = strtoul(str.c_str(), &end, 10);
+  if (str.empty() || *end != '\0') {
+    Usage(std::format("invalid value for {}: {}", flag, value));
+  }
+  return static_cast<uint32_t>(result);
+}
+
+std::vector<CpuVariant> ParseVariants(std::string_view value) {
+  if (value == "best") {
+    return {BestCpuVariant()};
+  }
+
+  std::vector<CpuVariant> variants;
+  for (CpuVariant variant : kCpuVariants) {
+    if (value == "all" ? IsSupported(variant)
+                       : value == CpuVariantName(variant)) {
+      variants.push_back(variant);
+    }
+  }
+  if (variants.empty()) {
+    Usage(std::format("unknown variant: {}", value));
+  }
+  if (!IsSupported(variants.front())) {
+    Usage(std::format("variant not supported by this CPU: {}", value));
+  }
+  return variants;
+}
+
+Options ParseOptions(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg = argv[i];
+    auto separator = arg.find('=');
+    if (!arg.starts_with("--") || separator == std::string_view::npos) {
+      Usage(std::format("unexpected argument: {}", arg));
+    }
+    std::string_view flag = arg.substr(0, separator);
+    std::string_view value = arg.substr(separator + 1);
+    if (flag == "--format") {
+      if (value != "csv" && value != "json") {
+        Usage(std::format("unknown format: {}", value));
+      }
+      options.format = value;
+    } else if (flag == "--output") {
+      options.output = value;
+    } else if (flag == "--filter") {
+      options.filter = value;
+    } else if (flag == "--trials") {
+      options.harness.trials = ParseCount(flag, value);
+      if (options.harness.trials == 0) {
+        Usage("--trials must be at least 1");
+      }
+    } else if (flag == "--warmup") {
+      options.harness.warmup_trials = ParseCount(flag, value);
+    } else if (flag == "--min-trial-ms") {
+      options.harness.min_trial_time =
+          std::chrono::milliseconds(ParseCount(flag, value));
+    } else if (flag == "--counters") {
+      if (value != "0" && value != "1") {
+        Usage(std::format("invalid value for {}: {}", flag, value));
+      }
+      options.harness.collect_counters = value == "1";
+    } else if (flag == "--variant") {
+      options.variants = ParseVariants(value);
+    } else if (flag == "--max-threads") {
+      options.max_threads = ParseCount(flag, value);
+    } else {
+      Usage(std::format("unknown flag: {}", flag));
+    }
+  }
+  return options;
+}
+
+void SetResult(BenchmarkRecord& record, const BenchmarkStats& stats) {
+  record.stats = stats;
+}
+
+void SetResult(BenchmarkRecord& record, const PrecisionBenchmarkStats& result) {
+  record.stats = result.stats;
+  record.max_error = result.max_error;
+}
+
+/**
+ * Runs a single benchmark unless it is excluded by the filter, and adds the
+ * result to records.
+ *
+ * @param benchmark Runs the benchmark, returning a std::expected of either
+ * BenchmarkStats or PrecisionBenchmarkStats.
+ */
+template <typename F>
+void Run(const Options& options, std::vector<BenchmarkRecord>& records,
+         BenchmarkRecord record, const F& benchmark) {
+  auto name = std::format("{}/{}/{}/{}", record.benchmark, record.backend,
+                          record.size, record.cpu_variant);
+  if (!record.threading.empty()) {
+    name += std::format("/{}/{}/{}", record.threading, record.scaling,
+                        record.threads);
+  }
+  if (!record.precision.empty()) {
+    name += std::format("/{}", record.precision);
+  }
+  if (name.find(options.filter) == std::string::npos) {
+    return;
+  }
+
+  auto result = benchmark();
+  if (!result.has_value()) {
+    LOG(WARNING) << name << " skipped: error "
+                 << static_cast<int>(result.error());
+    return;
+  }
+  SetResult(record, *result);
+  records.push_back(std::move(record));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ndksamples::base::InitLogging("vectorization_benchmark");
+  const Options options = ParseOptions(argc, argv);
+  const HarnessOptions& harness = options.harness;
+
+  std::vector<BenchmarkRecord> records;
+  for (Evaluation evaluation : kEvaluations) {
+    Run(options, records,
+        {.benchmark = std::format("mvp_{}", EvaluationName(evaluation)),
+         .backend = std::string(BackendName(Backend::kClangMatrix)),
+         .cpu_variant = std::string(CpuVariantName(CpuVariant::kBaseline)),
+         .size = kMvpBatchSize,
+         .work_per_iteration = static_cast<double>(kMvpBatchSize),
+         .work_unit = "vertex"},
+        [&]() { return BenchmarkMvpTransform(evaluation, harness); });
+  }
+
+  for (CpuVariant variant : options.variants) {
+    const auto variant_name = std::string(CpuVariantName(variant));
+    for (Backend backend : kBackends) {
+      Run(options, records,
+          {.benchmark = "multiply_vec4",
+           .backend = std::string(BackendName(backend)),
+           .cpu_variant = variant_name,
+           .size = 4,
+           .work_per_iteration = 1,
+           .work_unit = "call"},
+          [&]() {
+            return BenchmarkMatrixMultiplication(backend, harness, variant);
+          });
+    }
+
+    for (size_t size : kSquareMatrixSizes) {
+      for (Backend backend : kBackends) {
+        Run(options, records,
+            {.benchmark = "square_multiply",
+             .backend = std::string(BackendName(backend)),
+             .cpu_variant = variant_name,
+             .size = size,
+             .work_per_iteration = SquareMatrixMultiplyFlops(size),
+             .work_unit = "flop"},
+            [&]() {
+              return BenchmarkSquareMatrixMultiplication(backend, size, harness,
+                                                         variant);
+            });
+      }
+    }
+
+    for (Precision precision : kPrecisions) {
+      for (size_t size : kSquareMatrixSizes) {
+        for (Backend backend : kBackends) {
+          Run(options, records,
+              {.benchmark = "precision_square_multiply",
+               .backend = std::string(BackendName(backend)),
+               .cpu_variant = variant_name,
+               .size = size,
+               .work_per_iteration = SquareMatrixMultiplyFlops(size),
+               .work_unit = precision == Precision::kInt8 ? "op" : "flop",
+               .precision = std::string(PrecisionName(precision))},
+              [&]() {
+                return BenchmarkSquareMatrixMultiplication(
+                    backend, size, precision, harness, variant);
+              });
+        }
+      }
+    }
+
+    for (size_t batch_size : kTransformBatchSizes) {
+      for (Backend backend : kBackends) {
+        Run(options, records,
+            {.benchmark = "transform_points",
+             .backend = std::string(BackendName(backend)),
+             .cpu_variant = variant_name,
+             .size = batch_size,
+             .work_per_iteration = static_cast<double>(batch_size),
+             .work_unit = "vertex"},
+            [&]() {
+              return BenchmarkTransformPoints(backend, batch_size, harness,
+                                              variant);
+            });
+      }
+    }
+
+    for (MatrixOperation operation : kMatrixOperations) {
+      for (size_t size : kMatrixOperationSizes) {
+        for (Backend backend : kBackends) {
+          Run(options, records,
+              {.benchmark = std::string(MatrixOperationName(operation)),
+               .backend = std::string(BackendName(backend)),
+               .cpu_variant = variant_name,
+               .size = size,
+               .work_per_iteration = kMatrixOperationBatchSize,
+               .work_unit = "matrix"},
+              [&]() {
+                return BenchmarkMatrixOperation(backend, operation, size,
+                                                harness, variant);
+              });
+        }
+      }
+    }
+
+    for (Threading threading : kThreadings) {
+      for (Scaling scaling : kScalings) {
+        for (uint32_t threads = 1; threads <= options.max_threads; threads++) {
+          const ParallelOptions parallel{
+              .threading = threading, .scaling = scaling, .threads = threads};
+          const auto problems = static_cast<double>(parallel.problems());
+          for (Backend backend : kBackends) {
+            Run(options, records,
+                {.benchmark = "parallel_square_multiply",
+                 .backend = std::string(BackendName(backend)),
+                 .cpu_variant = variant_name,
+                 .size = kParallelSquareMatrixSize,
+                 .work_per_iteration =
+                     SquareMatrixMultiplyFlops(kParallelSquareMatrixSize) *
+                     problems,
+                 .work_unit = "flop",
+                 .threads = threads,
+                 .threading = std::string(ThreadingName(threading)),
+                 .scaling = std::string(ScalingName(scaling))},
+                [&]() {
+                  return BenchmarkParallelSquareMatrixMultiplication(
+                      backend, kParallelSquareMatrixSize, parallel, harness,
+                      variant);
+                });
+          }
+
+          for (Backend backend : kBackends) {
+            Run(options, records,
+                {.benchmark = "parallel_transform_points",
+                 .backend = std::string(BackendName(backend)),
+                 .cpu_variant = variant_name,
+                 .size = kParallelTransformBatchSize,
+                 .work_per_iteration =
+                     static_cast<double>(kParallelTransformBatchSize) *
+                     problems,
+                 .work_unit = "vertex",
+                 .threads = threads,
+                 .threading = std::string(ThreadingName(threading)),
+                 .scaling = std::string(ScalingName(scaling))},
+                [&]() {
+                  return BenchmarkParallelTransformPoints(
+                      backend, kParallelTransformBatchSize, parallel, harness,
+                      variant);
+                });
+          }
+        }
+      }
+    }
+  }
+
+  std::ofstream file;
+  if (options.output.has_value()) {
+    file.open(*options.output);
+    if (!file) {
+      PLOG(ERROR) << "could not open " << *options.output;
+      return EXIT_FAILURE;
+    }
+  }
+  std::ostream& stream = options.output.has_value() ? file : std::cout;
+
+  if (options.format == "json") {
+    WriteJson(stream, records);
+  } else {
+    WriteCsv(stream, records);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include <algorithm>
+
+namespace samples::vectorization {
+
+/// The number of rows of the result computed by each micro-kernel call.
+inline constexpr size_t kMicroTileRows = 8;
+
+/// The number of columns of the result computed by each micro-kernel call.
+inline constexpr size_t kMicroTileColumns = 4;
+
+/// How much of the shared dimension (the columns of the left operand) is
+/// processed by each pass over the result.
+inline constexpr size_t kBlockDepth = 128;
+
+/// The number of rows of the left operand in each cache block.
+inline constexpr size_t kBlockRows = 64;
+
+/// How much of the shared dimension a micro-kernel may load at once. See
+/// ClangMatrixMicroKernel.
+inline constexpr size_t kMicroKernelStep = 8;
+
+/**
+ * Whether a multiply of the given size is small enough for the simple
+ * implementations, which keep a whole column (or the whole matrix, for Clang
+ * matrices) in registers. That stops working, and gets very slow, once the
+ * matrix no longer fits in the register file.
+ *
+ * @tparam M The number of rows in the left operand and the result.
+ * @tparam N The number of columns in the left operand, and the rows in the
+ * right operand.
+ * @tparam P The number of columns in the right operand and the result.
+ */
+template <size_t M, size_t N, size_t P>
+inline constexpr bool kFitsInRegisters = M < 32 && N < 32 && P < 32;
+
+/**
+ * Whether a multiply of the given size should use BlockedMultiply.
+ *
+ * That's every multiply that doesn't fit in registers, except for thin ones
+ * that can't fill a single micro tile. Those gain nothing from blocking, and
+ * the micro-kernels can't be used for them at all: ClangMatrixMicroKernel
+ * loads kMicroTileRows x kMicroKernelStep slices of the left operand with a
+ * column stride of M, and kMicroKernelStep x kMicroTileColumns slices of the
+ * right operand with a column stride of N, and Clang rejects a stride smaller
+ * than the number of rows loaded.
+ *
+ * @tparam M The number of rows in the left operand and the result.
+ * @tparam N The number of columns in the left operand, and the rows in the
+ * right operand.
+ * @tparam P The number of columns in the right operand and the result.
+ */
+template <size_t M, size_t N, size_t P>
+inline constexpr bool kUseBlockedMultiply =
+    !kFitsInRegisters<M, N, P> && M >= kMicroTileRows &&
+    N >= kMicroKernelStep && P >= kMicroTileColumns;
+
+/**
+ * Computes the given number of leading columns of lhs * rhs with
+ * BlockedMultiply's algorithm.
+ *
+ * Since the matrices are column-major, any range of columns of the result
+ * depends only on the same columns of rhs, and both are contiguous. Passing
+ * `rhs + first * N` and `result + first * M` computes columns starting at
+ * first instead, which lets several threads share one multiply.
+ *
+ * @tparam T The type of each operand cell.
+ * @tparam M The number of rows in the left operand and the result.
+ * @tparam N The number of columns in the left operand, and the rows in the
+ * right operand.
+ * @tparam Acc The type of each result cell, which the products are
+ * accumulated in. See BlockedMultiply.
+ * @param lhs The M x N left operand.
+ * @param rhs The N x columns right operand.
+ * @param result The M x columns output. Must not overlap either operand.
+ * @param columns The number of columns to compute.
+ * @param micro_kernel The function that computes each tile. See
+ * BlockedMultiply.
+ */
+template <typename T, size_t M, size_t N, typename MicroKernel, typename Acc>
+[[clang::always_inline]] void BlockedMultiplyColumns(
+    const T* _Nonnull lhs, const T* _Nonnull rhs, Acc* _Nonnull result,
+    size_t columns, const MicroKernel& micro_kernel) {
+  std::fill_n(result, M * columns, Acc{});
+
+  for (size_t k_begin = 0; k_begin < N; k_begin += kBlockDepth) {
+    const size_t depth = std::min(kBlockDepth, N - k_begin);
+    for (size_t i_begin = 0; i_begin < M; i_begin += kBlockRows) {
+      const size_t i_end = std::min(i_begin + kBlockRows, M);
+      for (size_t j = 0; j < columns; j += kMicroTileColumns) {
+        const size_t tile_columns = std::min(kMicroTileColumns, columns - j);
+        for (size_t i = i_begin; i < i_end; i += kMicroTileRows) {
+          const size_t rows = std::min(kMicroTileRows, i_end - i);
+          const T* a = lhs + k_begin * M + i;
+          const T* b = rhs + j * N + k_begin;
+          Acc* c = result + j * M + i;
+
+          if (rows == kMicroTileRows && tile_columns == kMicroTileColumns) {
+            micro_kernel(a, b, c, depth);
+            continue;
+          }
+
+          for (size_t column = 0; column < tile_columns; column++) {
+            for (size_t row = 0; row < rows; row++) {
+              Acc sum = {};
+              for (size_t k = 0; k < depth; k++) {
+                sum += static_cast<Acc>(a[k * M + row]) *
+                       static_cast<Acc>(b[column * N + k]);
+              }
+              c[column * M + row] += sum;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Multiplies two column-major matrices using cache blocking and register
+ * blocking.
+ *
+ * The result is computed in kMicroTileRows x kMicroTileColumns tiles by
+ * micro_kernel, which should keep the whole tile in registers. The loops
+ * around it are ordered so that a kBlockRows x kBlockDepth block of lhs stays
+ * in cache while it is used for every tile in that block's rows, and each
+ * kBlockDepth x kMicroTileColumns sliver of rhs stays in L1 while it is used
+ * for every tile in the block. See
+ * https://en.wikipedia.org/wiki/Block_matrix#Multiplication for the math, and
+ * the BLIS papers for far more detail on the loop structure.
+ *
+ * Tiles on the right or bottom edge that are smaller than a full micro tile
+ * are computed with scalar code.
+ *
+ * Like the kernels of each backend, this is always inlined into its caller so
+ * that each CPU variant in kernels.cpp gets its own copy compiled for that
+ * variant's instruction set.
+ *
+ * The micro-kernel is called as `micro_kernel(a, b, c, depth)`, and must
+ * compute `C += A * B`, where A is the kMicroTileRows x depth matrix starting
+ * at a with a column stride of M, B is the depth x kMicroTileColumns matrix
+ * starting at b with a column stride of N, and C is the kMicroTileRows x
+ * kMicroTileColumns matrix starting at c with a column stride of M.
+ *
+ * The result may have a wider type than the operands, so that, for example,
+ * int8_t operands can be accumulated in int32_t without overflowing. Each
+ * product is computed in the result's type.
+ *
+ * @tparam T The type of each operand cell.
+ * @tparam M The number of rows in the left operand and the result.
+ * @tparam N The number of columns in the left operand, and the rows in the
+ * right operand.
+ * @tparam P The number of columns in the right operand and the result.
+ * @tparam Acc The type of each result cell.
+ * @param lhs The M x N left operand.
+ * @param rhs The N x P right operand.
+ * @param result The M x P output. Must not overlap either operand.
+ * @param micro_kernel The function that computes each tile.
+ */
+template <typename T, size_t M, size_t N, size_t P, typename MicroKernel,
+          typename Acc>
+[[clang::always_inline]] void BlockedMultiply(const T* _Nonnull lhs,
+                                              const T* _Nonnull rhs,
+                                              Acc* _Nonnull result,
+                                              const MicroKernel& micro_kernel) {
+  BlockedMultiplyColumns<T, M, N>(lhs, rhs, result, P, micro_kernel);
+}
+
+}  // namespace samples::vectorization
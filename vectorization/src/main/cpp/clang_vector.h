@@ -18,10 +18,114 @@
 
 #include <stdint.h>
 
+#include "blocked_multiply.h"
 #include "matrix.h"
 
 namespace samples::vectorization {
 
+/**
+ * Computes C += A * B for one tile of BlockedMultiply using Clang vectors.
+ *
+ * See BlockedMultiply for the meaning of each argument.
+ *
+ * @tparam T The type of each operand cell.
+ * @tparam M The column stride of a and c.
+ * @tparam N The column stride of b.
+ * @tparam Acc The type of each result cell.
+ */
+template <typename T, size_t M, size_t N, typename Acc = T>
+[[clang::always_inline]] void ClangVectorMicroKernel(const T* _Nonnull a,
+                                                     const T* _Nonnull b,
+                                                     Acc* _Nonnull c,
+                                                     size_t depth) {
+  // This is the same algorithm as the small matrix case below, but applied to a
+  // tile of the result that is narrow enough for each column to fit in a
+  // vector, and with all of the tile's columns kept in registers for the whole
+  // pass over depth. The tile's columns are not aligned, so they're loaded and
+  // stored with memcpy. If the result is wider than the operands, each column
+  // of a is widened with a single vector conversion after it's loaded.
+  typedef T Vec __attribute__((__vector_size__(kMicroTileRows * sizeof(T))));
+  typedef Acc AccVec
+      __attribute__((__vector_size__(kMicroTileRows * sizeof(Acc))));
+  AccVec accumulator[kMicroTileColumns];
+  for (auto column = 0U; column < kMicroTileColumns; column++) {
+    __builtin_memcpy(&accumulator[column], c + column * M, sizeof(AccVec));
+  }
+  for (size_t k = 0; k < depth; k++) {
+    Vec a_column;
+    __builtin_memcpy(&a_column, a + k * M, sizeof(Vec));
+    const AccVec wide_a_column = __builtin_convertvector(a_column, AccVec);
+    for (auto column = 0U; column < kMicroTileColumns; column++) {
+      accumulator[column] +=
+          wide_a_column * static_cast<Acc>(b[column * N + k]);
+    }
+  }
+  for (auto column = 0U; column < kMicroTileColumns; column++) {
+    __builtin_memcpy(c + column * M, &accumulator[column], sizeof(AccVec));
+  }
+}
+
+/**
+ * Multiplies two compatible matrices, writing the result to an existing
+ * matrix.
+ *
+ * @tparam T The type of each operand cell.
+ * @tparam Acc The type of each result cell, which may be wider than T. See
+ * BlockedMultiply.
+ * @tparam M The number of rows in the left operand and the result.
+ * @tparam N The number of columns in the left operand, and the rows in the
+ * right operand.
+ * @tparam P The number of columns in the right operand and the result.
+ * @param lhs The left operand.
+ * @param rhs The right operand.
+ * @param result The destination for lhs * rhs. Must not be either operand.
+ */
+template <typename T, typename Acc, size_t M, size_t N, size_t P>
+[[clang::always_inline]] void MultiplyWithClangVectors(
+    const Matrix<M, N, T>& lhs, const Matrix<N, P, T>& rhs,
+    Matrix<M, P, Acc>& result) {
+  if constexpr (kUseBlockedMultiply<M, N, P>) {
+    // Columns this large don't fit in a vector register, so the algorithm
+    // below is tiled to fit the vector size.
+    BlockedMultiply<T, M, N, P>(lhs.data(), rhs.data(), result.data(),
+                                ClangVectorMicroKernel<T, M, N, Acc>);
+  } else {
+    // The rearrangement of the matrix multiplication algorithm here allows us
+    // to avoid reducing vectors to scalar stores. Instead we compute the
+    // partial result for each (result) column as a vector, accumulate partial
+    // results there, and then store the resulting row with a single vector
+    // store.
+    //
+    // This only works if your columns (or rows, if you restructure this and
+    // the data to work in row-major order) fit within your vector registers.
+    // Larger matrices use BlockedMultiply, which tiles the algorithm to fit
+    // the vector size.
+    //
+    // See https://mbernste.github.io/posts/matrix_vector_mult/ for a more
+    // thorough explanation.
+    //
+    // A Matrix is only aligned for T, not for a whole column, so the columns
+    // are loaded and stored with memcpy.
+    typedef T Vec __attribute__((__vector_size__(M * sizeof(T))));
+    typedef Acc AccVec __attribute__((__vector_size__(M * sizeof(Acc))));
+    for (auto result_column_index = 0U; result_column_index < P;
+         result_column_index++) {
+      AccVec result_column = {};
+      for (auto lhs_column_index = 0U; lhs_column_index < N;
+           lhs_column_index++) {
+        Vec lhs_column;
+        __builtin_memcpy(&lhs_column, lhs.column(lhs_column_index).data(),
+                         sizeof(Vec));
+        result_column += __builtin_convertvector(lhs_column, AccVec) *
+                         static_cast<Acc>(
+                             rhs[lhs_column_index, result_column_index]);
+      }
+      __builtin_memcpy(result.column(result_column_index).data(),
+                       &result_column, sizeof(AccVec));
+    }
+  }
+}
+
 /**
  * Multiplies two compatible matrices and returns the result.
  *
@@ -37,32 +141,252 @@ namespace samples::vectorization {
 template <typename T, size_t M, size_t N, size_t P>
 Matrix<M, P, T> MultiplyWithClangVectors(const Matrix<M, N, T>& lhs,
                                          const Matrix<N, P, T>& rhs) {
-  // The rearrangement of the matrix multiplication algorithm here allows us to
-  // avoid reducing vectors to scalar stores. Instead we compute the partial
-  // result for each (result) column as a vector, accumulate partial results
-  // there, and then store the resulting row with a single vector store.
-  //
-  // This implementation only works if your columns (or rows, if you restructure
-  // this and the data to work in row-major order) fit within your vector
-  // registers. If you have larger data, you can tile the algorithm to fit the
-  // vector size.
-  //
-  // See https://mbernste.github.io/posts/matrix_vector_mult/ for a more
-  // thorough explanation.
-  typedef T Vec __attribute__((__vector_size__(M * sizeof(T))));
   Matrix<M, P, T> result;
-  for (auto result_column_index = 0U; result_column_index < P;
-       result_column_index++) {
-    Vec result_column = {};
-    for (auto lhs_column_index = 0U; lhs_column_index < N; lhs_column_index++) {
-      auto c = lhs.column(lhs_column_index);
-      Vec lhs_column = *reinterpret_cast<const Vec*>(c.data());
-      result_column += lhs_column * rhs[lhs_column_index, result_column_index];
+  MultiplyWithClangVectors(lhs, rhs, result);
+  return result;
+}
+
+/**
+ * Transforms each point in a batch by a matrix, writing the results to out.
+ *
+ * @tparam T The type of each matrix cell.
+ * @param m The transform to apply.
+ * @param in The points to transform.
+ * @param out The destination for the transformed points. Must be the same size
+ * as in. May be the same buffers as in.
+ */
+template <typename T>
+[[clang::always_inline]] void TransformPointsWithClangVectors(
+    const Mat4<T>& m, PointSpan<const T> in, PointSpan<T> out) {
+  DCHECK(in.IsValid());
+  DCHECK(out.IsValid());
+  DCHECK_EQ(in.size(), out.size());
+
+  // Because the points are stored as a structure of arrays, each vector holds
+  // the same component of kLanes consecutive points, and each output component
+  // is a plain multiply-add of four input vectors by a broadcast matrix cell.
+  // There's no need for any shuffles or horizontal operations.
+  //
+  // The vector is two 128-bit registers wide to give the CPU two independent
+  // dependency chains to work on. The spans have no alignment guarantees, so
+  // the vectors are loaded and stored with memcpy, which Clang lowers to
+  // unaligned vector loads and stores.
+  constexpr size_t kLanes = 32 / sizeof(T);
+  typedef T Vec __attribute__((__vector_size__(kLanes * sizeof(T))));
+
+  auto load = [](const T* _Nonnull p) {
+    Vec v;
+    __builtin_memcpy(&v, p, sizeof(v));
+    return v;
+  };
+  auto store = [](T* _Nonnull p, Vec v) { __builtin_memcpy(p, &v, sizeof(v)); };
+
+  // As in TransformPointsWithAutoVectorization, copy m so Clang knows the
+  // stores to out can't modify it.
+  const Mat4<T> local_m = m;
+
+  // Computes one component of the output. Used for both vectors and scalars.
+  auto transform_row = [&](size_t row, auto x, auto y, auto z, auto w) {
+    return local_m[row, 0] * x + local_m[row, 1] * y + local_m[row, 2] * z +
+           local_m[row, 3] * w;
+  };
+
+  size_t i = 0;
+  for (; i + kLanes <= in.size(); i += kLanes) {
+    const Vec x = load(&in.x[i]);
+    const Vec y = load(&in.y[i]);
+    const Vec z = load(&in.z[i]);
+    const Vec w = load(&in.w[i]);
+    store(&out.x[i], transform_row(0, x, y, z, w));
+    store(&out.y[i], transform_row(1, x, y, z, w));
+    store(&out.z[i], transform_row(2, x, y, z, w));
+    store(&out.w[i], transform_row(3, x, y, z, w));
+  }
+
+  // Scalar loop for whatever doesn't fill a whole vector.
+  for (; i < in.size(); i++) {
+    const T x = in.x[i];
+    const T y = in.y[i];
+    const T z = in.z[i];
+    const T w = in.w[i];
+    out.x[i] = transform_row(0, x, y, z, w);
+    out.y[i] = transform_row(1, x, y, z, w);
+    out.z[i] = transform_row(2, x, y, z, w);
+    out.w[i] = transform_row(3, x, y, z, w);
+  }
+}
+
+/**
+ * Loads the columns of a 3x3 or 4x4 matrix into four Clang vectors of four
+ * lanes each. The extra row and column of a 3x3 matrix are zero.
+ */
+template <typename Vec, typename T, size_t N>
+[[clang::always_inline]] void LoadClangVectorColumns(const Matrix<N, N, T>& m,
+                                                     Vec (&columns)[4]) {
+  for (auto column = 0U; column < 4; column++) {
+    columns[column] = Vec{};
+    if (column < N) {
+      __builtin_memcpy(&columns[column], m.column(column).data(),
+                       N * sizeof(T));
     }
-    *reinterpret_cast<Vec*>(result.column(result_column_index).data()) =
-        result_column;
   }
-  return result;
+}
+
+/**
+ * Stores the first N lanes of the first N vectors to the columns of m.
+ */
+template <typename Vec, typename T, size_t N>
+[[clang::always_inline]] void StoreClangVectorColumns(const Vec (&columns)[4],
+                                                      Matrix<N, N, T>& m) {
+  for (auto column = 0U; column < N; column++) {
+    __builtin_memcpy(m.column(column).data(), &columns[column], N * sizeof(T));
+  }
+}
+
+/**
+ * Transposes a 4x4 matrix held in four vectors, in place.
+ */
+template <typename Vec>
+[[clang::always_inline]] void TransposeClangVectors(Vec (&v)[4]) {
+  // Interleave pairs of columns, then pairs of pairs. This is the same
+  // sequence of shuffles as _MM_TRANSPOSE4_PS, or zip1/zip2 on Neon.
+  const Vec t0 = __builtin_shufflevector(v[0], v[1], 0, 4, 1, 5);
+  const Vec t1 = __builtin_shufflevector(v[0], v[1], 2, 6, 3, 7);
+  const Vec t2 = __builtin_shufflevector(v[2], v[3], 0, 4, 1, 5);
+  const Vec t3 = __builtin_shufflevector(v[2], v[3], 2, 6, 3, 7);
+  v[0] = __builtin_shufflevector(t0, t2, 0, 1, 4, 5);
+  v[1] = __builtin_shufflevector(t0, t2, 2, 3, 6, 7);
+  v[2] = __builtin_shufflevector(t1, t3, 0, 1, 4, 5);
+  v[3] = __builtin_shufflevector(t1, t3, 2, 3, 6, 7);
+}
+
+/**
+ * Returns the cross product of the first three lanes of a and b. The fourth
+ * lane of the result is meaningless.
+ */
+template <typename Vec>
+[[clang::always_inline]] Vec ClangVectorCross(Vec a, Vec b) {
+  // a * b.yzx - a.yzx * b is the cross product rotated to zxy, so only three
+  // shuffles are needed rather than four.
+  const Vec a_yzx = __builtin_shufflevector(a, a, 1, 2, 0, 3);
+  const Vec b_yzx = __builtin_shufflevector(b, b, 1, 2, 0, 3);
+  const Vec zxy = a * b_yzx - a_yzx * b;
+  return __builtin_shufflevector(zxy, zxy, 1, 2, 0, 3);
+}
+
+/**
+ * Returns the dot product of the first three lanes of a and b.
+ */
+template <typename Vec>
+[[clang::always_inline]] auto ClangVectorDot(Vec a, Vec b) {
+  const Vec product = a * b;
+  return product[0] + product[1] + product[2];
+}
+
+/**
+ * Transposes a 3x3 or 4x4 matrix using Clang vectors.
+ *
+ * @tparam T The type of each matrix cell.
+ * @tparam N The number of rows and columns in m.
+ * @param m The matrix to transpose.
+ * @param result The destination for the transpose of m. Must not be m.
+ */
+template <typename T, size_t N>
+  requires(N == 3 || N == 4)
+[[clang::always_inline]] void TransposeWithClangVectors(
+    const Matrix<N, N, T>& m, Matrix<N, N, T>& result) {
+  typedef T Vec __attribute__((__vector_size__(4 * sizeof(T))));
+  Vec columns[4];
+  LoadClangVectorColumns(m, columns);
+  TransposeClangVectors(columns);
+  StoreClangVectorColumns(columns, result);
+}
+
+/**
+ * Computes the determinant of a 3x3 or 4x4 matrix using Clang vectors.
+ *
+ * See InverseWithClangMatrices for the algorithm.
+ *
+ * @tparam T The type of each matrix cell.
+ * @tparam N The number of rows and columns in m.
+ * @param m The matrix.
+ * @return The determinant of m.
+ */
+template <typename T, size_t N>
+  requires(N == 3 || N == 4)
+[[clang::always_inline]] T DeterminantWithClangVectors(
+    const Matrix<N, N, T>& m) {
+  typedef T Vec __attribute__((__vector_size__(4 * sizeof(T))));
+  Vec c[4];
+  LoadClangVectorColumns(m, c);
+  if constexpr (N == 3) {
+    return ClangVectorDot(c[0], ClangVectorCross(c[1], c[2]));
+  } else {
+    // The fourth lane of each column is the fourth row, (x, y, z, w).
+    const Vec s = ClangVectorCross(c[0], c[1]);
+    const Vec t = ClangVectorCross(c[2], c[3]);
+    const Vec u = c[0] * c[1][3] - c[1] * c[0][3];
+    const Vec v = c[2] * c[3][3] - c[3] * c[2][3];
+    return ClangVectorDot(s, v) + ClangVectorDot(t, u);
+  }
+}
+
+/**
+ * Inverts a 3x3 or 4x4 matrix using Clang vectors.
+ *
+ * See InverseWithClangMatrices for the algorithm. Each 3D vector is held in
+ * the first three lanes of a four lane vector, and the rows of the inverse are
+ * transposed into columns with shuffles at the end.
+ *
+ * @tparam T The type of each matrix cell.
+ * @tparam N The number of rows and columns in m.
+ * @param m The matrix to invert. Must be invertible; otherwise the result is
+ * infinite or NaN.
+ * @param result The destination for the inverse of m. Must not be m.
+ */
+template <typename T, size_t N>
+  requires(N == 3 || N == 4)
+[[clang::always_inline]] void InverseWithClangVectors(const Matrix<N, N, T>& m,
+                                                      Matrix<N, N, T>& result) {
+  typedef T Vec __attribute__((__vector_size__(4 * sizeof(T))));
+  Vec c[4];
+  LoadClangVectorColumns(m, c);
+
+  Vec rows[4];
+  if constexpr (N == 3) {
+    rows[0] = ClangVectorCross(c[1], c[2]);
+    const T inv_det = 1 / ClangVectorDot(c[0], rows[0]);
+    rows[0] *= inv_det;
+    rows[1] = ClangVectorCross(c[2], c[0]) * inv_det;
+    rows[2] = ClangVectorCross(c[0], c[1]) * inv_det;
+    rows[3] = Vec{};
+  } else {
+    const T x = c[0][3];
+    const T y = c[1][3];
+    const T z = c[2][3];
+    const T w = c[3][3];
+
+    Vec s = ClangVectorCross(c[0], c[1]);
+    Vec t = ClangVectorCross(c[2], c[3]);
+    Vec u = c[0] * y - c[1] * x;
+    Vec v = c[2] * w - c[3] * z;
+    const T inv_det = 1 / (ClangVectorDot(s, v) + ClangVectorDot(t, u));
+    s *= inv_det;
+    t *= inv_det;
+    u *= inv_det;
+    v *= inv_det;
+
+    rows[0] = ClangVectorCross(c[1], v) + t * y;
+    rows[1] = ClangVectorCross(v, c[0]) - t * x;
+    rows[2] = ClangVectorCross(c[3], u) + s * w;
+    rows[3] = ClangVectorCross(u, c[2]) - s * z;
+    rows[0][3] = -ClangVectorDot(c[1], t);
+    rows[1][3] = ClangVectorDot(c[0], t);
+    rows[2][3] = -ClangVectorDot(c[3], s);
+    rows[3][3] = ClangVectorDot(c[2], s);
+  }
+  TransposeClangVectors(rows);
+  StoreClangVectorColumns(rows, result);
 }
 
 }  // namespace samples::vectorization
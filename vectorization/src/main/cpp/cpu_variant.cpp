@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpu_variant.h"
+
+#if defined(__aarch64__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+namespace samples::vectorization {
+
+std::string_view CpuVariantName(CpuVariant variant) {
+  switch (variant) {
+    case CpuVariant::kBaseline:
+      return "baseline";
+    case CpuVariant::kAvx2:
+      return "avx2";
+    case CpuVariant::kAvx512:
+      return "avx512";
+    case CpuVariant::kSve2:
+      return "sve2";
+    case CpuVariant::kArmv82:
+      return "armv8_2";
+    default:
+      return "unknown";
+  }
+}
+
+bool IsSupported(CpuVariant variant) {
+  switch (variant) {
+    case CpuVariant::kBaseline:
+      return true;
+#if defined(__x86_64__) || defined(__i386__)
+    // These also check that the OS saves the wider registers on context
+    // switches, not just that the CPU has the instructions.
+    case CpuVariant::kAvx2:
+      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case CpuVariant::kAvx512:
+      return __builtin_cpu_supports("avx512f") &&
+             __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+#if defined(__aarch64__)
+    // FP16 arithmetic and the dot product instructions are both optional in
+    // ARMv8.2, so check for each of them.
+    case CpuVariant::kArmv82:
+      return (getauxval(AT_HWCAP) & HWCAP_ASIMDHP) != 0 &&
+             (getauxval(AT_HWCAP) & HWCAP_ASIMDDP) != 0;
+    case CpuVariant::kSve2:
+      return (getauxval(AT_HWCAP2) & HWCAP2_SVE2) != 0 &&
+             IsSupported(CpuVariant::kArmv82);
+#endif
+    default:
+      // Not built for this architecture.
+      return false;
+  }
+}
+
+CpuVariant BestCpuVariant() {
+  static const CpuVariant best = [] {
+    CpuVariant result = CpuVariant::kBaseline;
+    for (CpuVariant variant : kCpuVariants) {
+      if (IsSupported(variant)) {
+        result = variant;
+      }
+    }
+    return result;
+  }();
+  return best;
+}
+
+}  // namespace samples::vectorization
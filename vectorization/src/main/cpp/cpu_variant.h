@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <array>
+#include <string_view>
+
+namespace samples::vectorization {
+
+/**
+ * The instruction set levels that the kernels are compiled for.
+ *
+ * The app is built for the baseline of each ABI (ARMv8.0 with Neon for arm64,
+ * SSE4.2 for x86_64), so without help the compiler can't use any newer
+ * instructions. kernels.cpp compiles an extra copy of every kernel for each of
+ * the other variants that apply to the target architecture, and the best one
+ * that the CPU supports is chosen at runtime.
+ */
+enum class CpuVariant : uint8_t {
+  /// The ABI's baseline instruction set. Always supported.
+  kBaseline = 0,
+
+  /// x86 with AVX2 and FMA.
+  kAvx2 = 1,
+
+  /// x86 with AVX-512F (and AVX2 and FMA).
+  kAvx512 = 2,
+
+  /// arm64 with SVE2 (ARMv9), and everything in kArmv82.
+  kSve2 = 3,
+
+  /// arm64 with ARMv8.2 and its FP16 and dot product extensions.
+  kArmv82 = 4,
+};
+
+/// Every variant, in order of preference from worst to best.
+inline constexpr std::array<CpuVariant, 5> kCpuVariants = {
+    CpuVariant::kBaseline, CpuVariant::kAvx2,  CpuVariant::kAvx512,
+    CpuVariant::kArmv82,   CpuVariant::kSve2,
+};
+
+/**
+ * Returns a short, stable name for the variant, suitable for machine readable
+ * output.
+ */
+[[nodiscard]] std::string_view CpuVariantName(CpuVariant variant);
+
+/**
+ * Returns whether the kernels were compiled for the variant and the CPU can
+ * run them.
+ */
+[[nodiscard]] bool IsSupported(CpuVariant variant);
+
+/**
+ * Returns the best variant that IsSupported. The CPU is only inspected the
+ * first time this is called.
+ */
+[[nodiscard]] CpuVariant BestCpuVariant();
+
+}  // namespace samples::vectorization
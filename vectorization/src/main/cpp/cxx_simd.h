@@ -0,0 +1,357 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "blocked_multiply.h"
+#include "matrix.h"
+#include "simd.h"
+
+namespace samples::vectorization {
+
+/**
+ * Computes C += A * B for one tile of BlockedMultiply using simd.h.
+ *
+ * See BlockedMultiply for the meaning of each argument.
+ *
+ * @tparam T The type of each operand cell.
+ * @tparam M The column stride of a and c.
+ * @tparam N The column stride of b.
+ * @tparam Acc The type of each result cell.
+ */
+template <typename T, size_t M, size_t N, typename Acc = T>
+[[clang::always_inline]] void CxxSimdMicroKernel(const T* _Nonnull a,
+                                                 const T* _Nonnull b,
+                                                 Acc* _Nonnull c,
+                                                 size_t depth) {
+  // The same algorithm as ClangVectorMicroKernel. Each column of the tile is a
+  // single simd value, and all of them stay in registers for the whole depth.
+  using Column = simd::fixed_size_simd<T, kMicroTileRows>;
+  using AccColumn = simd::fixed_size_simd<Acc, kMicroTileRows>;
+  AccColumn accumulator[kMicroTileColumns];
+  for (auto column = 0U; column < kMicroTileColumns; column++) {
+    accumulator[column].copy_from(c + column * M, simd::element_aligned);
+  }
+  for (size_t k = 0; k < depth; k++) {
+    const AccColumn a_column(Column(a + k * M, simd::element_aligned));
+    for (auto column = 0U; column < kMicroTileColumns; column++) {
+      accumulator[column] += a_column * static_cast<Acc>(b[column * N + k]);
+    }
+  }
+  for (auto column = 0U; column < kMicroTileColumns; column++) {
+    accumulator[column].copy_to(c + column * M, simd::element_aligned);
+  }
+}
+
+/**
+ * Multiplies two compatible matrices, writing the result to an existing
+ * matrix.
+ *
+ * @tparam T The type of each operand cell.
+ * @tparam Acc The type of each result cell, which may be wider than T. See
+ * BlockedMultiply.
+ * @tparam M The number of rows in the left operand and the result.
+ * @tparam N The number of columns in the left operand, and the rows in the
+ * right operand.
+ * @tparam P The number of columns in the right operand and the result.
+ * @param lhs The left operand.
+ * @param rhs The right operand.
+ * @param result The destination for lhs * rhs. Must not be either operand.
+ */
+template <typename T, typename Acc, size_t M, size_t N, size_t P>
+[[clang::always_inline]] void MultiplyWithCxxSimd(const Matrix<M, N, T>& lhs,
+                                                  const Matrix<N, P, T>& rhs,
+                                                  Matrix<M, P, Acc>& result) {
+  if constexpr (kUseBlockedMultiply<M, N, P>) {
+    BlockedMultiply<T, M, N, P>(lhs.data(), rhs.data(), result.data(),
+                                CxxSimdMicroKernel<T, M, N, Acc>);
+  } else {
+    // The same algorithm as MultiplyWithClangVectors: each column of the
+    // result is accumulated in a single simd value.
+    using Column = simd::fixed_size_simd<T, M>;
+    using AccColumn = simd::fixed_size_simd<Acc, M>;
+    for (auto result_column_index = 0U; result_column_index < P;
+         result_column_index++) {
+      AccColumn result_column;
+      for (auto lhs_column_index = 0U; lhs_column_index < N;
+           lhs_column_index++) {
+        const AccColumn lhs_column(Column(lhs.column(lhs_column_index).data(),
+                                          simd::element_aligned));
+        result_column += lhs_column * static_cast<Acc>(
+                                          rhs[lhs_column_index,
+                                              result_column_index]);
+      }
+      result_column.copy_to(result.column(result_column_index).data(),
+                            simd::element_aligned);
+    }
+  }
+}
+
+/**
+ * Multiplies two compatible matrices and returns the result.
+ *
+ * @tparam T The type of each matrix cell.
+ * @tparam M The number of rows in the left operand and the result.
+ * @tparam N The number of columns in the left operand, and the rows in the
+ * right operand.
+ * @tparam P The number of columns in the right operand and the result.
+ * @param lhs The left operand.
+ * @param rhs The right operand.
+ * @return The result of lhs * rhs.
+ */
+template <typename T, size_t M, size_t N, size_t P>
+Matrix<M, P, T> MultiplyWithCxxSimd(const Matrix<M, N, T>& lhs,
+                                    const Matrix<N, P, T>& rhs) {
+  Matrix<M, P, T> result;
+  MultiplyWithCxxSimd(lhs, rhs, result);
+  return result;
+}
+
+/**
+ * Transforms each point in a batch by a matrix, writing the results to out.
+ *
+ * @tparam T The type of each matrix cell.
+ * @param m The transform to apply.
+ * @param in The points to transform.
+ * @param out The destination for the transformed points. Must be the same size
+ * as in. May be the same buffers as in.
+ */
+template <typename T>
+[[clang::always_inline]] void TransformPointsWithCxxSimd(const Mat4<T>& m,
+                                                         PointSpan<const T> in,
+                                                         PointSpan<T> out) {
+  DCHECK(in.IsValid());
+  DCHECK(out.IsValid());
+  DCHECK_EQ(in.size(), out.size());
+
+  // See TransformPointsWithClangVectors for an explanation of the algorithm
+  // and the vector width.
+  using Vec = simd::fixed_size_simd<T, 32 / sizeof(T)>;
+
+  const Mat4<T> local_m = m;
+
+  // Computes one component of the output. Used for both vectors and scalars.
+  auto transform_row = [&](size_t row, const auto& x, const auto& y,
+                           const auto& z, const auto& w) {
+    return local_m[row, 0] * x + local_m[row, 1] * y + local_m[row, 2] * z +
+           local_m[row, 3] * w;
+  };
+
+  size_t i = 0;
+  for (; i + Vec::size() <= in.size(); i += Vec::size()) {
+    const Vec x(&in.x[i], simd::element_aligned);
+    const Vec y(&in.y[i], simd::element_aligned);
+    const Vec z(&in.z[i], simd::element_aligned);
+    const Vec w(&in.w[i], simd::element_aligned);
+    transform_row(0, x, y, z, w).copy_to(&out.x[i], simd::element_aligned);
+    transform_row(1, x, y, z, w).copy_to(&out.y[i], simd::element_aligned);
+    transform_row(2, x, y, z, w).copy_to(&out.z[i], simd::element_aligned);
+    transform_row(3, x, y, z, w).copy_to(&out.w[i], simd::element_aligned);
+  }
+
+  // Scalar loop for whatever doesn't fill a whole vector.
+  for (; i < in.size(); i++) {
+    const T x = in.x[i];
+    const T y = in.y[i];
+    const T z = in.z[i];
+    const T w = in.w[i];
+    out.x[i] = transform_row(0, x, y, z, w);
+    out.y[i] = transform_row(1, x, y, z, w);
+    out.z[i] = transform_row(2, x, y, z, w);
+    out.w[i] = transform_row(3, x, y, z, w);
+  }
+}
+
+/**
+ * Loads column j of a 3x3 or 4x4 matrix into a four element simd. The extra
+ * row of a 3x3 matrix is zero.
+ */
+template <typename T, size_t N>
+[[clang::always_inline]] simd::fixed_size_simd<T, 4> LoadCxxSimdColumn(
+    const Matrix<N, N, T>& m, size_t j) {
+  if constexpr (N == 4) {
+    return {m.column(j).data(), simd::element_aligned};
+  } else {
+    return simd::fixed_size_simd<T, 4>(
+        [&](auto i) { return i < N ? m[i, j] : T{}; });
+  }
+}
+
+/**
+ * Stores the first N elements of v to column j of m.
+ */
+template <typename T, size_t N>
+[[clang::always_inline]] void StoreCxxSimdColumn(
+    const simd::fixed_size_simd<T, 4>& v, Matrix<N, N, T>& m, size_t j) {
+  if constexpr (N == 4) {
+    v.copy_to(m.column(j).data(), simd::element_aligned);
+  } else {
+    for (auto i = 0U; i < N; i++) {
+      m[i, j] = v[i];
+    }
+  }
+}
+
+/**
+ * Transposes a 4x4 matrix held in four simd values, in place.
+ */
+template <typename T>
+[[clang::always_inline]] void TransposeCxxSimd(
+    simd::fixed_size_simd<T, 4> (&v)[4]) {
+  const simd::fixed_size_simd<T, 4> copy[] = {v[0], v[1], v[2], v[3]};
+  for (auto j = 0U; j < 4; j++) {
+    v[j] = simd::fixed_size_simd<T, 4>([&](auto i) { return copy[i][j]; });
+  }
+}
+
+/**
+ * Returns the cross product of the first three elements of a and b. The
+ * fourth element of the result is meaningless.
+ */
+template <typename T>
+[[clang::always_inline]] simd::fixed_size_simd<T, 4> CxxSimdCross(
+    const simd::fixed_size_simd<T, 4>& a,
+    const simd::fixed_size_simd<T, 4>& b) {
+  // See ClangVectorCross.
+  using Vec = simd::fixed_size_simd<T, 4>;
+  auto yzx = [](const Vec& v) {
+    return Vec([&](auto i) { return v[i == 3 ? 3 : (i + 1) % 3]; });
+  };
+  return yzx(a * yzx(b) - yzx(a) * b);
+}
+
+/**
+ * Returns the dot product of the first three elements of a and b.
+ */
+template <typename T>
+[[clang::always_inline]] T CxxSimdDot(const simd::fixed_size_simd<T, 4>& a,
+                                      const simd::fixed_size_simd<T, 4>& b) {
+  const auto product = a * b;
+  return product[0] + product[1] + product[2];
+}
+
+/**
+ * Transposes a 3x3 or 4x4 matrix using simd.h.
+ *
+ * @tparam T The type of each matrix cell.
+ * @tparam N The number of rows and columns in m.
+ * @param m The matrix to transpose.
+ * @param result The destination for the transpose of m. Must not be m.
+ */
+template <typename T, size_t N>
+  requires(N == 3 || N == 4)
+[[clang::always_inline]] void TransposeWithCxxSimd(const Matrix<N, N, T>& m,
+                                                   Matrix<N, N, T>& result) {
+  simd::fixed_size_simd<T, 4> columns[4];
+  for (auto j = 0U; j < N; j++) {
+    columns[j] = LoadCxxSimdColumn(m, j);
+  }
+  TransposeCxxSimd(columns);
+  for (auto j = 0U; j < N; j++) {
+    StoreCxxSimdColumn(columns[j], result, j);
+  }
+}
+
+/**
+ * Computes the determinant of a 3x3 or 4x4 matrix using simd.h.
+ *
+ * See InverseWithClangMatrices for the algorithm.
+ *
+ * @tparam T The type of each matrix cell.
+ * @tparam N The number of rows and columns in m.
+ * @param m The matrix.
+ * @return The determinant of m.
+ */
+template <typename T, size_t N>
+  requires(N == 3 || N == 4)
+[[clang::always_inline]] T DeterminantWithCxxSimd(const Matrix<N, N, T>& m) {
+  const auto a = LoadCxxSimdColumn(m, 0);
+  const auto b = LoadCxxSimdColumn(m, 1);
+  const auto c = LoadCxxSimdColumn(m, 2);
+  if constexpr (N == 3) {
+    return CxxSimdDot(a, CxxSimdCross(b, c));
+  } else {
+    const auto d = LoadCxxSimdColumn(m, 3);
+    const auto s = CxxSimdCross(a, b);
+    const auto t = CxxSimdCross(c, d);
+    const auto u = a * b[3] - b * a[3];
+    const auto v = c * d[3] - d * c[3];
+    return CxxSimdDot(s, v) + CxxSimdDot(t, u);
+  }
+}
+
+/**
+ * Inverts a 3x3 or 4x4 matrix using simd.h.
+ *
+ * This is the same algorithm as InverseWithClangVectors. std::simd has no
+ * shuffles, so those are written with the generator constructor.
+ *
+ * @tparam T The type of each matrix cell.
+ * @tparam N The number of rows and columns in m.
+ * @param m The matrix to invert. Must be invertible; otherwise the result is
+ * infinite or NaN.
+ * @param result The destination for the inverse of m. Must not be m.
+ */
+template <typename T, size_t N>
+  requires(N == 3 || N == 4)
+[[clang::always_inline]] void InverseWithCxxSimd(const Matrix<N, N, T>& m,
+                                                 Matrix<N, N, T>& result) {
+  using Vec = simd::fixed_size_simd<T, 4>;
+  const Vec a = LoadCxxSimdColumn(m, 0);
+  const Vec b = LoadCxxSimdColumn(m, 1);
+  const Vec c = LoadCxxSimdColumn(m, 2);
+
+  Vec rows[4];
+  if constexpr (N == 3) {
+    const Vec r0 = CxxSimdCross(b, c);
+    const T inv_det = 1 / CxxSimdDot(a, r0);
+    rows[0] = r0 * inv_det;
+    rows[1] = CxxSimdCross(c, a) * inv_det;
+    rows[2] = CxxSimdCross(a, b) * inv_det;
+  } else {
+    const Vec d = LoadCxxSimdColumn(m, 3);
+    const T x = a[3];
+    const T y = b[3];
+    const T z = c[3];
+    const T w = d[3];
+
+    Vec s = CxxSimdCross(a, b);
+    Vec t = CxxSimdCross(c, d);
+    Vec u = a * y - b * x;
+    Vec v = c * w - d * z;
+    const T inv_det = 1 / (CxxSimdDot(s, v) + CxxSimdDot(t, u));
+    s *= inv_det;
+    t *= inv_det;
+    u *= inv_det;
+    v *= inv_det;
+
+    auto with_w = [](const Vec& xyz, T w) {
+      return Vec([&](auto i) { return i == 3 ? w : xyz[i]; });
+    };
+    rows[0] = with_w(CxxSimdCross(b, v) + t * y, -CxxSimdDot(b, t));
+    rows[1] = with_w(CxxSimdCross(v, a) - t * x, CxxSimdDot(a, t));
+    rows[2] = with_w(CxxSimdCross(d, u) + s * w, -CxxSimdDot(d, s));
+    rows[3] = with_w(CxxSimdCross(u, c) - s * z, CxxSimdDot(c, s));
+  }
+  TransposeCxxSimd(rows);
+  for (auto j = 0U; j < N; j++) {
+    StoreCxxSimdColumn(rows[j], result, j);
+  }
+}
+
+}  // namespace samples::vectorization
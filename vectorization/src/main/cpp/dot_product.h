@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "matrix.h"
+
+namespace samples::vectorization {
+
+#if defined(__aarch64__)
+
+/// The number of rows of the result computed by each step of
+/// MultiplyWithDotProduct: two vectors of four int32 lanes.
+inline constexpr size_t kDotProductTileRows = 8;
+
+/// The number of columns of the result computed by each step of
+/// MultiplyWithDotProduct: one for each lane of a packed rhs vector.
+inline constexpr size_t kDotProductTileColumns = 4;
+
+/// The number of consecutive int8 values that SDOT sums into each lane.
+inline constexpr size_t kDotProductDepth = 4;
+
+/**
+ * Copies an int8 matrix into the layout that MultiplyWithDotProduct needs.
+ *
+ * SDOT multiplies four consecutive bytes of one operand by four consecutive
+ * bytes of the other, and adds the sum to one int32 lane. For a matrix
+ * multiply, the four bytes of each lane have to be four consecutive values of
+ * the shared dimension. In column-major storage those are adjacent in the
+ * right operand but a whole column apart in the left. So both operands are
+ * packed to hold, for each group of kDotProductDepth values of the shared
+ * dimension, each row (or column) of the group in turn.
+ *
+ * @param lines The number of rows (or columns), rounded up to a whole tile.
+ * @param depth The size of the shared dimension.
+ * @param valid_lines The number of rows (or columns) that exist. The rest are
+ * zero, as are the values past depth in the last group, so that every tile is
+ * full and the padding adds nothing to the result.
+ * @param get_cell Returns the cell for the given row (or column) and index in
+ * the shared dimension.
+ */
+template <typename GetCell>
+[[clang::always_inline]] std::vector<int8_t> PackForDotProduct(
+    size_t lines, size_t depth, size_t valid_lines, GetCell get_cell) {
+  const size_t groups = (depth + kDotProductDepth - 1) / kDotProductDepth;
+  std::vector<int8_t> packed(groups * lines * kDotProductDepth);
+  for (size_t group = 0; group < groups; group++) {
+    for (size_t line = 0; line < valid_lines; line++) {
+      for (size_t i = 0; i < kDotProductDepth; i++) {
+        const size_t k = group * kDotProductDepth + i;
+        if (k < depth) {
+          packed[(group * lines + line) * kDotProductDepth + i] =
+              get_cell(line, k);
+        }
+      }
+    }
+  }
+  return packed;
+}
+
+/**
+ * Multiplies two int8 matrices with the ARMv8.2 dot product instructions,
+ * accumulating in int32.
+ *
+ * None of the backends can express a widening dot product, so without this
+ * every one of them converts each operand to int32 and multiplies in int32:
+ * four multiply-accumulates per 128-bit instruction, no better than float.
+ * SDOT does sixteen, which is where int8 gets its speed on CPUs that have it.
+ *
+ * After packing (see PackForDotProduct), each kDotProductTileRows x
+ * kDotProductTileColumns tile of the result is eight vectors of four int32
+ * lanes. For each group of four values of the shared dimension, one 16 byte
+ * load of the packed rhs holds that group for all four columns, and each of
+ * the two loads of the packed lhs holds it for four rows. SDOT by lane then
+ * multiplies each lhs vector by one column's four bytes. The tiles at the
+ * edges are padded with zeros and computed the same way.
+ *
+ * This must only be inlined into functions compiled for dotprod. See
+ * CpuVariant::kArmv82.
+ *
+ * @tparam M The number of rows in the left operand and the result.
+ * @tparam N The number of columns in the left operand, and the rows in the
+ * right operand.
+ * @tparam P The number of columns in the right operand and the result.
+ * @param lhs The left operand.
+ * @param rhs The right operand.
+ * @param result The destination for lhs * rhs.
+ */
+template <size_t M, size_t N, size_t P>
+[[gnu::target("dotprod"), clang::always_inline]] void MultiplyWithDotProduct(
+    const Matrix<M, N, int8_t>& lhs, const Matrix<N, P, int8_t>& rhs,
+    Matrix<M, P, int32_t>& result) {
+  constexpr size_t kRows =
+      (M + kDotProductTileRows - 1) / kDotProductTileRows * kDotProductTileRows;
+  constexpr size_t kColumns = (P + kDotProductTileColumns - 1) /
+                              kDotProductTileColumns * kDotProductTileColumns;
+  constexpr size_t kGroups = (N + kDotProductDepth - 1) / kDotProductDepth;
+  const std::vector<int8_t> packed_lhs = PackForDotProduct(
+      kRows, N, M, [&](size_t row, size_t k) { return lhs[row, k]; });
+  const std::vector<int8_t> packed_rhs = PackForDotProduct(
+      kColumns, N, P, [&](size_t column, size_t k) { return rhs[k, column]; });
+
+  for (size_t column = 0; column < kColumns; column += kDotProductTileColumns) {
+    for (size_t row = 0; row < kRows; row += kDotProductTileRows) {
+      int32x4_t top[kDotProductTileColumns] = {};
+      int32x4_t bottom[kDotProductTileColumns] = {};
+      for (size_t group = 0; group < kGroups; group++) {
+        const int8_t* a =
+            &packed_lhs[(group * kRows + row) * kDotProductDepth];
+        const int8_t* b =
+            &packed_rhs[(group * kColumns + column) * kDotProductDepth];
+        const int8x16_t a_top = vld1q_s8(a);
+        const int8x16_t a_bottom = vld1q_s8(a + 16);
+        const int8x16_t b_columns = vld1q_s8(b);
+        top[0] = vdotq_laneq_s32(top[0], a_top, b_columns, 0);
+        top[1] = vdotq_laneq_s32(top[1], a_top, b_columns, 1);
+        top[2] = vdotq_laneq_s32(top[2], a_top, b_columns, 2);
+        top[3] = vdotq_laneq_s32(top[3], a_top, b_columns, 3);
+        bottom[0] = vdotq_laneq_s32(bottom[0], a_bottom, b_columns, 0);
+        bottom[1] = vdotq_laneq_s32(bottom[1], a_bottom, b_columns, 1);
+        bottom[2] = vdotq_laneq_s32(bottom[2], a_bottom, b_columns, 2);
+        bottom[3] = vdotq_laneq_s32(bottom[3], a_bottom, b_columns, 3);
+      }
+
+      for (size_t i = 0; i < kDotProductTileColumns && column + i < P; i++) {
+        if (row + kDotProductTileRows <= M) {
+          vst1q_s32(&result[row, column + i], top[i]);
+          vst1q_s32(&result[row + 4, column + i], bottom[i]);
+          continue;
+        }
+        int32_t cells[kDotProductTileRows];
+        vst1q_s32(cells, top[i]);
+        vst1q_s32(cells + 4, bottom[i]);
+        for (size_t j = 0; row + j < M; j++) {
+          result[row + j, column + i] = cells[j];
+        }
+      }
+    }
+  }
+}
+
+#endif  // defined(__aarch64__)
+
+}  // namespace samples::vectorization
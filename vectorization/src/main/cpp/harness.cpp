@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "harness.h"
+
+#include <base/logging.h>
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <numeric>
+#include <string_view>
+#include <vector>
+
+namespace samples::vectorization {
+
+namespace {
+
+/**
+ * Runs body the given number of times.
+ *
+ * @return The duration of a single iteration in nanoseconds.
+ */
+[[clang::noinline]] double RunTrial(const std::function<void()>& body,
+                                    uint64_t iterations) {
+  auto begin = std::chrono::steady_clock::now();
+
+  // Prevent Clang from optimizing the harness differently for each benchmark.
+#pragma clang loop unroll(disable)
+  for (uint64_t i = 0; i < iterations; i++) {
+    body();
+  }
+
+  auto end = std::chrono::steady_clock::now();
+  std::chrono::duration<double, std::nano> elapsed = end - begin;
+  return elapsed.count() / static_cast<double>(iterations);
+}
+
+/**
+ * Finds the number of iterations needed for a trial to take at least
+ * min_trial_time.
+ */
+uint64_t CalibrateIterations(const std::function<void()>& body,
+                             std::chrono::nanoseconds min_trial_time) {
+  const double min_ns = static_cast<double>(min_trial_time.count());
+  uint64_t iterations = 1;
+  while (true) {
+    const double per_iteration_ns = RunTrial(body, iterations);
+    const double trial_ns = per_iteration_ns * static_cast<double>(iterations);
+    if (trial_ns >= min_ns) {
+      return iterations;
+    }
+
+    // Overshoot the estimate a little so we usually don't need another round,
+    // but never grow by more than 100x at a time in case the first iterations
+    // were unrepresentatively fast.
+    const double estimate =
+        per_iteration_ns > 0 ? min_ns * 1.2 / per_iteration_ns
+                             : static_cast<double>(iterations) * 100;
+    iterations = std::clamp(static_cast<uint64_t>(estimate), iterations * 2,
+                            iterations * 100);
+  }
+}
+
+/**
+ * Returns the given percentile of a sorted, non-empty list of samples,
+ * interpolating between the closest samples.
+ */
+double Percentile(std::span<const double> sorted, double percentile) {
+  const double position =
+      percentile / 100.0 * static_cast<double>(sorted.size() - 1);
+  const size_t lower = static_cast<size_t>(position);
+  const size_t upper = std::min(lower + 1, sorted.size() - 1);
+  const double fraction = position - static_cast<double>(lower);
+  return sorted[lower] + (sorted[upper] - sorted[lower]) * fraction;
+}
+
+std::string FormatDouble(double value) { return std::format("{:.3f}", value); }
+
+// Formats an optional counter value, using missing for counters that weren't
+// available.
+std::string FormatCounter(const std::optional<CounterValues>& counters,
+                          std::optional<double> CounterValues::* counter,
+                          std::string_view missing) {
+  if (!counters.has_value() || !((*counters).*counter).has_value()) {
+    return std::string(missing);
+  }
+  return FormatDouble(*((*counters).*counter));
+}
+
+std::string FormatIpc(const std::optional<CounterValues>& counters,
+                      std::string_view missing) {
+  if (!counters.has_value() || !counters->ipc().has_value()) {
+    return std::string(missing);
+  }
+  return FormatDouble(*counters->ipc());
+}
+
+// Formats an error, which is usually much smaller than FormatDouble can show.
+std::string FormatError(std::optional<double> error, std::string_view missing) {
+  if (!error.has_value()) {
+    return std::string(missing);
+  }
+  return std::format("{:.3e}", *error);
+}
+
+std::string EscapeJson(std::string_view value) {
+  std::string escaped;
+  escaped.reserve(value.size());
+  for (char c : value) {
+    switch (c) {
+      case '"':
+        escaped += "\\\"";
+        break;
+      case '\\':
+        escaped += "\\\\";
+        break;
+      case '\n':
+        escaped += "\\n";
+        break;
+      default:
+        escaped += c;
+    }
+  }
+  return escaped;
+}
+
+}  // namespace
+
+BenchmarkStats RunBenchmark(const std::function<void()>& body,
+                            const HarnessOptions& options) {
+  CHECK_GT(options.trials, 0U);
+
+  BenchmarkStats stats;
+  stats.iterations_per_trial =
+      CalibrateIterations(body, options.min_trial_time);
+
+  for (auto i = 0U; i < options.warmup_trials; i++) {
+    (void)RunTrial(body, stats.iterations_per_trial);
+  }
+
+  std::optional<PerfCounters> perf_counters;
+  if (options.collect_counters) {
+    perf_counters.emplace();
+    if (!perf_counters->available()) {
+      LOG(INFO) << "No hardware counters available; measuring time only";
+      perf_counters.reset();
+    }
+  }
+
+  std::vector<double> samples;
+  samples.reserve(options.trials);
+  for (auto i = 0U; i < options.trials; i++) {
+    if (perf_counters.has_value()) perf_counters->Start();
+    samples.push_back(RunTrial(body, stats.iterations_per_trial));
+    if (perf_counters.has_value()) perf_counters->Stop();
+  }
+  std::sort(samples.begin(), samples.end());
+
+  if (perf_counters.has_value()) {
+    stats.counters = perf_counters->Read() /
+                     static_cast<double>(options.trials *
+                                         stats.iterations_per_trial);
+  }
+
+  const double q1 = Percentile(samples, 25);
+  const double q3 = Percentile(samples, 75);
+  const double upper_fence = q3 + 1.5 * (q3 - q1);
+  auto first_outlier = std::upper_bound(samples.begin(), samples.end(),
+                                        upper_fence);
+  stats.outliers = static_cast<uint32_t>(samples.end() - first_outlier);
+  samples.erase(first_outlier, samples.end());
+  stats.trials = static_cast<uint32_t>(samples.size());
+
+  const double count = static_cast<double>(samples.size());
+  stats.min_ns = samples.front();
+  stats.max_ns = samples.back();
+  stats.median_ns = Percentile(samples, 50);
+  stats.p90_ns = Percentile(samples, 90);
+  stats.p99_ns = Percentile(samples, 99);
+  stats.mean_ns = std::accumulate(samples.begin(), samples.end(), 0.0) / count;
+
+  double sum_of_squares = 0;
+  for (double sample : samples) {
+    sum_of_squares += (sample - stats.mean_ns) * (sample - stats.mean_ns);
+  }
+  stats.stddev_ns =
+      samples.size() > 1 ? std::sqrt(sum_of_squares / (count - 1)) : 0;
+  return stats;
+}
+
+void WriteCsv(std::ostream& stream, std::span<const BenchmarkRecord> records) {
+  stream << "benchmark,backend,size,iterations_per_trial,trials,outliers,"
+            "min_ns,median_ns,mean_ns,p90_ns,p99_ns,max_ns,stddev_ns,"
+            "work_per_iteration,work_unit,throughput_per_s,"
+            "cycles_per_iteration,instructions_per_iteration,ipc,"
+            "l1d_misses_per_iteration,branch_misses_per_iteration,"
+            "cpu_variant,threads,threading,scaling,precision,max_error\n";
+  for (const auto& record : records) {
+    const auto& stats = record.stats;
+    stream << record.benchmark << ',' << record.backend << ',' << record.size
+           << ',' << stats.iterations_per_trial << ',' << stats.trials << ','
+           << stats.outliers << ',' << FormatDouble(stats.min_ns) << ','
+           << FormatDouble(stats.median_ns) << ','
+           << FormatDouble(stats.mean_ns) << ',' << FormatDouble(stats.p90_ns)
+           << ',' << FormatDouble(stats.p99_ns) << ','
+           << FormatDouble(stats.max_ns) << ','
+           << FormatDouble(stats.stddev_ns) << ','
+           << FormatDouble(record.work_per_iteration) << ','
+           << record.work_unit << ','
+           << FormatDouble(record.throughput_per_second()) << ','
+           << FormatCounter(stats.counters, &CounterValues::cycles, "") << ','
+           << FormatCounter(stats.counters, &CounterValues::instructions, "")
+           << ',' << FormatIpc(stats.counters, "") << ','
+           << FormatCounter(stats.counters, &CounterValues::l1d_misses, "")
+           << ','
+           << FormatCounter(stats.counters, &CounterValues::branch_misses, "")
+           << ',' << record.cpu_variant << ',' << record.threads << ','
+           << record.threading << ',' << record.scaling << ','
+           << record.precision << ',' << FormatError(record.max_error, "")
+           << '\n';
+  }
+}
+
+void WriteJson(std::ostream& stream, std::span<const BenchmarkRecord> records) {
+  stream << "{\n  \"schema_version\": 1,\n  \"results\": [";
+  for (size_t i = 0; i < records.size(); i++) {
+    const auto& record = records[i];
+    const auto& stats = record.stats;
+    stream << (i == 0 ? "\n" : ",\n") << "    {"
+           << "\"benchmark\": \"" << EscapeJson(record.benchmark) << "\", "
+           << "\"backend\": \"" << EscapeJson(record.backend) << "\", "
+           << "\"size\": " << record.size << ", "
+           << "\"iterations_per_trial\": " << stats.iterations_per_trial
+           << ", "
+           << "\"trials\": " << stats.trials << ", "
+           << "\"outliers\": " << stats.outliers << ", "
+           << "\"min_ns\": " << FormatDouble(stats.min_ns) << ", "
+           << "\"median_ns\": " << FormatDouble(stats.median_ns) << ", "
+           << "\"mean_ns\": " << FormatDouble(stats.mean_ns) << ", "
+           << "\"p90_ns\": " << FormatDouble(stats.p90_ns) << ", "
+           << "\"p99_ns\": " << FormatDouble(stats.p99_ns) << ", "
+           << "\"max_ns\": " << FormatDouble(stats.max_ns) << ", "
+           << "\"stddev_ns\": " << FormatDouble(stats.stddev_ns) << ", "
+           << "\"work_per_iteration\": "
+           << FormatDouble(record.work_per_iteration) << ", "
+           << "\"work_unit\": \"" << EscapeJson(record.work_unit) << "\", "
+           << "\"throughput_per_s\": "
+           << FormatDouble(record.throughput_per_second()) << ", "
+           << "\"cycles_per_iteration\": "
+           << FormatCounter(stats.counters, &CounterValues::cycles, "null")
+           << ", "
+           << "\"instructions_per_iteration\": "
+           << FormatCounter(stats.counters, &CounterValues::instructions,
+                            "null")
+           << ", "
+           << "\"ipc\": " << FormatIpc(stats.counters, "null") << ", "
+           << "\"l1d_misses_per_iteration\": "
+           << FormatCounter(stats.counters, &CounterValues::l1d_misses, "null")
+           << ", "
+           << "\"branch_misses_per_iteration\": "
+           << FormatCounter(stats.counters, &CounterValues::branch_misses,
+                            "null")
+           << ", "
+           << "\"cpu_variant\": \"" << EscapeJson(record.cpu_variant) << "\", "
+           << "\"threads\": " << record.threads << ", "
+           << "\"threading\": \"" << EscapeJson(record.threading) << "\", "
+           << "\"scaling\": \"" << EscapeJson(record.scaling) << "\", "
+           << "\"precision\": \"" << EscapeJson(record.precision) << "\", "
+           << "\"max_error\": " << FormatError(record.max_error, "null")
+           << "}";
+  }
+  stream << "\n  ]\n}\n";
+}
+
+}  // namespace samples::vectorization
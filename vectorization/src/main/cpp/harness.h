@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+
+#include "perf_counters.h"
+
+namespace samples::vectorization {
+
+/**
+ * Controls how RunBenchmark measures a benchmark.
+ */
+struct HarnessOptions {
+  /// The number of untimed trials to run before measuring.
+  uint32_t warmup_trials = 2;
+
+  /// The number of timed trials.
+  uint32_t trials = 20;
+
+  /// The minimum duration of each trial. The number of iterations in each
+  /// trial is chosen so that a trial takes at least this long, which keeps
+  /// timer resolution and overhead from dominating the measurement of very
+  /// fast operations.
+  std::chrono::nanoseconds min_trial_time = std::chrono::milliseconds(10);
+
+  /// Whether to also count hardware events (see PerfCounters) during the
+  /// timed trials. If no counters are available, only time is measured.
+  bool collect_counters = false;
+};
+
+/**
+ * The summary statistics of a benchmark run.
+ *
+ * All times are the duration of a single iteration in nanoseconds. Each timed
+ * trial contributes one sample: the trial's duration divided by its number of
+ * iterations.
+ */
+struct BenchmarkStats {
+  /// The number of times the benchmark body was run in each trial.
+  uint64_t iterations_per_trial = 0;
+
+  /// The number of trials used to compute the statistics below.
+  uint32_t trials = 0;
+
+  /// The number of trials that were rejected as outliers.
+  uint32_t outliers = 0;
+
+  double min_ns = 0;
+  double median_ns = 0;
+  double mean_ns = 0;
+  double p90_ns = 0;
+  double p99_ns = 0;
+  double max_ns = 0;
+  double stddev_ns = 0;
+
+  /// Hardware event counts for a single iteration, averaged over every timed
+  /// trial (including outliers). Only present if HarnessOptions requested
+  /// counters and at least one counter was available.
+  std::optional<CounterValues> counters;
+};
+
+/**
+ * Measures the duration of a benchmark body.
+ *
+ * The number of iterations per trial is calibrated first, then warmup trials
+ * are run and discarded, then the timed trials are run.
+ *
+ * Trials slower than the upper Tukey fence (Q3 + 1.5 * IQR) are rejected as
+ * outliers before computing statistics. Those are almost always caused by
+ * something other than the code being measured: preemption, interrupts, or
+ * migration to a slower core. Nothing is rejected on the low side, since
+ * nothing can make the code run faster than it's able to.
+ *
+ * Percentiles are interpolated between samples, so with the default number of
+ * trials p99 is very close to the (non-outlier) maximum.
+ *
+ * @param body The code to benchmark.
+ * @param options Controls the number and duration of trials.
+ * @return The statistics for a single iteration of body.
+ */
+[[nodiscard]] BenchmarkStats RunBenchmark(const std::function<void()>& body,
+                                          const HarnessOptions& options = {});
+
+/**
+ * A single result as written by WriteCsv or WriteJson.
+ */
+struct BenchmarkRecord {
+  /// The name of the benchmark, for example "square_multiply".
+  std::string benchmark;
+
+  /// The name of the backend that was benchmarked.
+  std::string backend;
+
+  /// The name of the CpuVariant that was benchmarked.
+  std::string cpu_variant;
+
+  /// The problem size. What this means depends on the benchmark.
+  size_t size = 0;
+
+  /// The timing statistics.
+  BenchmarkStats stats;
+
+  /// The amount of work done by each iteration, used to compute throughput.
+  double work_per_iteration = 1;
+
+  /// The unit of work_per_iteration, for example "flop" or "vertex".
+  std::string work_unit = "call";
+
+  /// The number of threads that ran the benchmark.
+  uint32_t threads = 1;
+
+  /// The name of the Threading used by a parallel benchmark, or empty.
+  std::string threading;
+
+  /// The name of the Scaling used by a parallel benchmark, or empty.
+  std::string scaling;
+
+  /// The name of the Precision of a reduced precision benchmark, or empty.
+  std::string precision;
+
+  /// The error of the benchmarked computation's result, for benchmarks that
+  /// measure it. See PrecisionBenchmarkStats::max_error.
+  std::optional<double> max_error;
+
+  /// The throughput based on the median time, in work units per second.
+  [[nodiscard]] double throughput_per_second() const {
+    return work_per_iteration / stats.median_ns * 1e9;
+  }
+};
+
+/**
+ * Writes results as CSV, with a header row.
+ *
+ * The columns are, in order: benchmark, backend, size, iterations_per_trial,
+ * trials, outliers, min_ns, median_ns, mean_ns, p90_ns, p99_ns, max_ns,
+ * stddev_ns, work_per_iteration, work_unit, throughput_per_s,
+ * cycles_per_iteration, instructions_per_iteration, ipc,
+ * l1d_misses_per_iteration, branch_misses_per_iteration, cpu_variant, threads,
+ * threading, scaling, precision, max_error. Counter columns and max_error are
+ * empty if the value wasn't available. New columns will only ever be added at
+ * the end.
+ *
+ * @param stream The stream to write to.
+ * @param records The results to write.
+ */
+void WriteCsv(std::ostream& stream, std::span<const BenchmarkRecord> records);
+
+/**
+ * Writes results as JSON.
+ *
+ * The output is an object with a "schema_version" field (currently 1) and a
+ * "results" array. Each result is an object with the same fields as the
+ * columns written by WriteCsv. Unavailable counters and max_error are null.
+ *
+ * @param stream The stream to write to.
+ * @param records The results to write.
+ */
+void WriteJson(std::ostream& stream, std::span<const BenchmarkRecord> records);
+
+}  // namespace samples::vectorization
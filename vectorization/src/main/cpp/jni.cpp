@@ -24,13 +24,147 @@
 
 using samples::vectorization::Backend;
 using samples::vectorization::BenchmarkMatrixMultiplication;
+using samples::vectorization::BenchmarkMatrixOperation;
+using samples::vectorization::BenchmarkMvpTransform;
+using samples::vectorization::BenchmarkParallelSquareMatrixMultiplication;
+using samples::vectorization::BenchmarkParallelTransformPoints;
+using samples::vectorization::BenchmarkSquareMatrixMultiplication;
+using samples::vectorization::BenchmarkTransformPoints;
+using samples::vectorization::BestCpuVariant;
+using samples::vectorization::CpuVariantName;
+using samples::vectorization::Evaluation;
+using samples::vectorization::kMatrixOperationBatchSize;
+using samples::vectorization::kMvpBatchSize;
+using samples::vectorization::MatrixOperation;
+using samples::vectorization::ParallelOptions;
+using samples::vectorization::Precision;
+using samples::vectorization::Scaling;
+using samples::vectorization::SquareMatrixMultiplyFlops;
+using samples::vectorization::Threading;
 
 static jlong BenchmarkMatrixMultiplyJni(JNIEnv* _Nonnull /* env */,
                                         jobject _Nonnull /* this */,
                                         jint backend) {
   auto result = BenchmarkMatrixMultiplication(static_cast<Backend>(backend));
   if (result.has_value()) {
-    return result->count();
+    return static_cast<jlong>(result->median_ns);
+  }
+  return static_cast<jlong>(result.error());
+}
+
+static jdouble BenchmarkSquareMatrixMultiplyJni(JNIEnv* _Nonnull /* env */,
+                                               jobject _Nonnull /* this */,
+                                               jint backend, jint size) {
+  auto result = BenchmarkSquareMatrixMultiplication(
+      static_cast<Backend>(backend), static_cast<size_t>(size));
+  if (result.has_value()) {
+    // FLOP per nanosecond is GFLOP/s.
+    return SquareMatrixMultiplyFlops(static_cast<size_t>(size)) /
+           result->median_ns;
+  }
+  return static_cast<jdouble>(result.error());
+}
+
+static jdoubleArray BenchmarkPrecisionSquareMatrixMultiplyJni(
+    JNIEnv* _Nonnull env, jobject _Nonnull /* this */, jint backend, jint size,
+    jint precision) {
+  auto result = BenchmarkSquareMatrixMultiplication(
+      static_cast<Backend>(backend), static_cast<size_t>(size),
+      static_cast<Precision>(precision));
+  // Either {GOP/s, max error} or {error code}.
+  jdouble values[2];
+  jsize length;
+  if (result.has_value()) {
+    values[0] = SquareMatrixMultiplyFlops(static_cast<size_t>(size)) /
+                result->stats.median_ns;
+    values[1] = result->max_error;
+    length = 2;
+  } else {
+    values[0] = static_cast<jdouble>(result.error());
+    length = 1;
+  }
+
+  jdoubleArray array = env->NewDoubleArray(length);
+  if (array == nullptr) {
+    return nullptr;
+  }
+  env->SetDoubleArrayRegion(array, 0, length, values);
+  return array;
+}
+
+static jlong BenchmarkTransformPointsJni(JNIEnv* _Nonnull /* env */,
+                                         jobject _Nonnull /* this */,
+                                         jint backend, jint batch_size) {
+  auto result = BenchmarkTransformPoints(static_cast<Backend>(backend),
+                                         static_cast<size_t>(batch_size));
+  if (result.has_value()) {
+    return static_cast<jlong>(static_cast<double>(batch_size) /
+                              result->median_ns * 1e9);
+  }
+  return static_cast<jlong>(result.error());
+}
+
+static jdouble BenchmarkMatrixOperationJni(JNIEnv* _Nonnull /* env */,
+                                           jobject _Nonnull /* this */,
+                                           jint backend, jint operation,
+                                           jint size) {
+  auto result = BenchmarkMatrixOperation(
+      static_cast<Backend>(backend), static_cast<MatrixOperation>(operation),
+      static_cast<size_t>(size));
+  if (result.has_value()) {
+    // Nanoseconds per matrix. Too short to round to whole nanoseconds.
+    return result->median_ns / static_cast<double>(kMatrixOperationBatchSize);
+  }
+  return static_cast<jdouble>(result.error());
+}
+
+static jdouble BenchmarkMvpTransformJni(JNIEnv* _Nonnull /* env */,
+                                        jobject _Nonnull /* this */,
+                                        jint evaluation) {
+  auto result = BenchmarkMvpTransform(static_cast<Evaluation>(evaluation));
+  if (result.has_value()) {
+    // Nanoseconds per vertex.
+    return result->median_ns / static_cast<double>(kMvpBatchSize);
+  }
+  return static_cast<jdouble>(result.error());
+}
+
+static ParallelOptions MakeParallelOptions(jint threading, jint scaling,
+                                           jint threads) {
+  return {
+      .threading = static_cast<Threading>(threading),
+      .scaling = static_cast<Scaling>(scaling),
+      // A negative count becomes huge rather than zero, so reject it here.
+      .threads = threads < 0 ? 0 : static_cast<uint32_t>(threads),
+  };
+}
+
+static jdouble BenchmarkParallelSquareMatrixMultiplyJni(
+    JNIEnv* _Nonnull /* env */, jobject _Nonnull /* this */, jint backend,
+    jint size, jint threading, jint scaling, jint threads) {
+  const auto parallel = MakeParallelOptions(threading, scaling, threads);
+  auto result = BenchmarkParallelSquareMatrixMultiplication(
+      static_cast<Backend>(backend), static_cast<size_t>(size), parallel);
+  if (result.has_value()) {
+    // FLOP per nanosecond is GFLOP/s.
+    return SquareMatrixMultiplyFlops(static_cast<size_t>(size)) *
+           static_cast<double>(parallel.problems()) / result->median_ns;
+  }
+  return static_cast<jdouble>(result.error());
+}
+
+static jlong BenchmarkParallelTransformPointsJni(JNIEnv* _Nonnull /* env */,
+                                                 jobject _Nonnull /* this */,
+                                                 jint backend, jint batch_size,
+                                                 jint threading, jint scaling,
+                                                 jint threads) {
+  const auto parallel = MakeParallelOptions(threading, scaling, threads);
+  auto result = BenchmarkParallelTransformPoints(
+      static_cast<Backend>(backend), static_cast<size_t>(batch_size), parallel);
+  if (result.has_value()) {
+    return static_cast<jlong>(static_cast<double>(batch_size) *
+                              static_cast<double>(parallel.problems()) /
+                              result->median_ns * 1e9);
   }
   return static_cast<jlong>(result.error());
 }
@@ -48,9 +182,25 @@ JNIEXPORT jint JNI_OnLoad(JavaVM* _Nonnull vm,
   static const JNINativeMethod methods[] = {
       {"benchmarkMatrixMultiply", "(I)J",
        reinterpret_cast<void*>(BenchmarkMatrixMultiplyJni)},
+      {"benchmarkSquareMatrixMultiply", "(II)D",
+       reinterpret_cast<void*>(BenchmarkSquareMatrixMultiplyJni)},
+      {"benchmarkPrecisionSquareMatrixMultiply", "(III)[D",
+       reinterpret_cast<void*>(BenchmarkPrecisionSquareMatrixMultiplyJni)},
+      {"benchmarkTransformPoints", "(II)J",
+       reinterpret_cast<void*>(BenchmarkTransformPointsJni)},
+      {"benchmarkMatrixOperation", "(III)D",
+       reinterpret_cast<void*>(BenchmarkMatrixOperationJni)},
+      {"benchmarkMvpTransform", "(I)D",
+       reinterpret_cast<void*>(BenchmarkMvpTransformJni)},
+      {"benchmarkParallelSquareMatrixMultiply", "(IIIII)D",
+       reinterpret_cast<void*>(BenchmarkParallelSquareMatrixMultiplyJni)},
+      {"benchmarkParallelTransformPoints", "(IIIII)J",
+       reinterpret_cast<void*>(BenchmarkParallelTransformPointsJni)},
   };
   int rc = env->RegisterNatives(c, methods, arraysize(methods));
   if (rc != JNI_OK) return rc;
 
+  LOG(INFO) << "Using " << CpuVariantName(BestCpuVariant()) << " kernels";
+
   return JNI_VERSION_1_6;
 }
\ No newline at end of file
@@ -0,0 +1,229 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "kernels.h"
+
+#include "auto_vectorization.h"
+#include "blocked_multiply.h"
+#include "clang_vector.h"
+#include "cxx_simd.h"
+#include "dot_product.h"
+#include "matrix.h"
+#include "omp_simd.h"
+
+namespace samples::vectorization {
+
+namespace {
+
+/**
+ * Multiplies two matrices with the given backend, accumulating in the type of
+ * the result.
+ */
+template <Backend backend, typename T, typename Acc, size_t M, size_t N,
+          size_t P>
+[[clang::always_inline]] void Multiply(const Matrix<M, N, T>& lhs,
+                                       const Matrix<N, P, T>& rhs,
+                                       Matrix<M, P, Acc>& result) {
+  if constexpr (backend == Backend::kAutoVectorization) {
+    MultiplyWithAutoVectorization(lhs, rhs, result);
+  } else if constexpr (backend == Backend::kCxxSimd) {
+    MultiplyWithCxxSimd(lhs, rhs, result);
+  } else if constexpr (backend == Backend::kClangVector) {
+    MultiplyWithClangVectors(lhs, rhs, result);
+  } else if constexpr (backend == Backend::kClangMatrix) {
+    MultiplyWithClangMatrices(lhs, rhs, result);
+  } else {
+    static_assert(backend == Backend::kOpenMp);
+    MultiplyWithOpenMP(lhs, rhs, result);
+  }
+}
+
+/**
+ * Computes columns [first, last) of lhs * rhs with the given backend's
+ * micro-kernel.
+ */
+template <Backend backend, size_t Size>
+[[clang::always_inline]] void MultiplyColumns(const Matrix<Size, Size>& lhs,
+                                              const Matrix<Size, Size>& rhs,
+                                              Matrix<Size, Size>& result,
+                                              size_t first, size_t last) {
+  const float* b = rhs.data() + first * Size;
+  float* c = result.data() + first * Size;
+  const size_t columns = last - first;
+  if constexpr (backend == Backend::kAutoVectorization) {
+    BlockedMultiplyColumns<float, Size, Size>(
+        lhs.data(), b, c, columns,
+        AutoVectorizationMicroKernel<float, Size, Size>);
+  } else if constexpr (backend == Backend::kCxxSimd) {
+    BlockedMultiplyColumns<float, Size, Size>(
+        lhs.data(), b, c, columns, CxxSimdMicroKernel<float, Size, Size>);
+  } else if constexpr (backend == Backend::kClangVector) {
+    BlockedMultiplyColumns<float, Size, Size>(
+        lhs.data(), b, c, columns, ClangVectorMicroKernel<float, Size, Size>);
+  } else if constexpr (backend == Backend::kClangMatrix) {
+    BlockedMultiplyColumns<float, Size, Size>(
+        lhs.data(), b, c, columns, ClangMatrixMicroKernel<float, Size, Size>);
+  } else {
+    static_assert(backend == Backend::kOpenMp);
+    BlockedMultiplyColumns<float, Size, Size>(
+        lhs.data(), b, c, columns, OpenMPMicroKernel<float, Size, Size>);
+  }
+}
+
+/**
+ * Transforms a batch of points with the given backend.
+ */
+template <Backend backend>
+[[clang::always_inline]] void Transform(const Mat4<>& m,
+                                        PointSpan<const float> in,
+                                        PointSpan<float> out) {
+  if constexpr (backend == Backend::kAutoVectorization) {
+    TransformPointsWithAutoVectorization(m, in, out);
+  } else if constexpr (backend == Backend::kCxxSimd) {
+    TransformPointsWithCxxSimd(m, in, out);
+  } else if constexpr (backend == Backend::kClangVector) {
+    TransformPointsWithClangVectors(m, in, out);
+  } else if constexpr (backend == Backend::kClangMatrix) {
+    TransformPoints(m, in, out);
+  } else {
+    static_assert(backend == Backend::kOpenMp);
+    TransformPointsWithOpenMP(m, in, out);
+  }
+}
+
+/**
+ * Transposes a small square matrix with the given backend.
+ */
+template <Backend backend, size_t N>
+[[clang::always_inline]] void Transpose(const Matrix<N, N>& m,
+                                        Matrix<N, N>& result) {
+  if constexpr (backend == Backend::kAutoVectorization) {
+    TransposeWithAutoVectorization(m, result);
+  } else if constexpr (backend == Backend::kCxxSimd) {
+    TransposeWithCxxSimd(m, result);
+  } else if constexpr (backend == Backend::kClangVector) {
+    TransposeWithClangVectors(m, result);
+  } else if constexpr (backend == Backend::kClangMatrix) {
+    TransposeWithClangMatrices(m, result);
+  } else {
+    static_assert(backend == Backend::kOpenMp);
+    TransposeWithOpenMP(m, result);
+  }
+}
+
+/**
+ * Computes the determinant of a small square matrix with the given backend.
+ */
+template <Backend backend, size_t N>
+[[clang::always_inline]] float Determinant(const Matrix<N, N>& m) {
+  if constexpr (backend == Backend::kAutoVectorization) {
+    return DeterminantWithAutoVectorization(m);
+  } else if constexpr (backend == Backend::kCxxSimd) {
+    return DeterminantWithCxxSimd(m);
+  } else if constexpr (backend == Backend::kClangVector) {
+    return DeterminantWithClangVectors(m);
+  } else if constexpr (backend == Backend::kClangMatrix) {
+    return DeterminantWithClangMatrices(m);
+  } else {
+    static_assert(backend == Backend::kOpenMp);
+    return DeterminantWithOpenMP(m);
+  }
+}
+
+/**
+ * Inverts a small square matrix with the given backend.
+ */
+template <Backend backend, size_t N>
+[[clang::always_inline]] void Inverse(const Matrix<N, N>& m,
+                                      Matrix<N, N>& result) {
+  if constexpr (backend == Backend::kAutoVectorization) {
+    InverseWithAutoVectorization(m, result);
+  } else if constexpr (backend == Backend::kCxxSimd) {
+    InverseWithCxxSimd(m, result);
+  } else if constexpr (backend == Backend::kClangVector) {
+    InverseWithClangVectors(m, result);
+  } else if constexpr (backend == Backend::kClangMatrix) {
+    InverseWithClangMatrices(m, result);
+  } else {
+    static_assert(backend == Backend::kOpenMp);
+    InverseWithOpenMP(m, result);
+  }
+}
+
+namespace baseline {
+#define KERNEL_ATTRIBUTES
+#include "kernels.inc"
+#undef KERNEL_ATTRIBUTES
+}  // namespace baseline
+
+#if defined(__x86_64__) || defined(__i386__)
+namespace avx2 {
+#define KERNEL_ATTRIBUTES [[gnu::target("avx2,fma")]]
+#include "kernels.inc"
+#undef KERNEL_ATTRIBUTES
+}  // namespace avx2
+
+namespace avx512 {
+#define KERNEL_ATTRIBUTES [[gnu::target("avx512f,avx2,fma")]]
+#include "kernels.inc"
+#undef KERNEL_ATTRIBUTES
+}  // namespace avx512
+#endif
+
+#if defined(__aarch64__)
+namespace armv8_2 {
+#define KERNEL_ATTRIBUTES [[gnu::target("arch=armv8.2-a+fp16+dotprod")]]
+#define KERNEL_HAS_DOT_PRODUCT
+#include "kernels.inc"
+#undef KERNEL_HAS_DOT_PRODUCT
+#undef KERNEL_ATTRIBUTES
+}  // namespace armv8_2
+
+// Every SVE2 CPU also has everything in ARMv8.2, which the Neon code uses far
+// more than anything in SVE2, so build on top of that rather than the baseline.
+namespace sve2 {
+#define KERNEL_ATTRIBUTES [[gnu::target("arch=armv8.2-a+fp16+dotprod+sve2")]]
+#define KERNEL_HAS_DOT_PRODUCT
+#include "kernels.inc"
+#undef KERNEL_HAS_DOT_PRODUCT
+#undef KERNEL_ATTRIBUTES
+}  // namespace sve2
+#endif
+
+}  // namespace
+
+std::optional<Kernels> GetKernels(Backend backend, CpuVariant variant) {
+  switch (variant) {
+    case CpuVariant::kBaseline:
+      return baseline::GetKernels(backend);
+#if defined(__x86_64__) || defined(__i386__)
+    case CpuVariant::kAvx2:
+      return avx2::GetKernels(backend);
+    case CpuVariant::kAvx512:
+      return avx512::GetKernels(backend);
+#endif
+#if defined(__aarch64__)
+    case CpuVariant::kArmv82:
+      return armv8_2::GetKernels(backend);
+    case CpuVariant::kSve2:
+      return sve2::GetKernels(backend);
+#endif
+    default:
+      return std::nullopt;
+  }
+}
+
+}  // namespace samples::vectorization
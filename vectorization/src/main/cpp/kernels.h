@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <optional>
+#include <tuple>
+
+#include "benchmark.h"
+#include "cpu_variant.h"
+#include "matrix.h"
+
+namespace samples::vectorization {
+
+/// Multiplies a Vec4 by a Mat4.
+using Vec4MultiplyKernel = Vec4<> (*)(const Mat4<>&, const Vec4<>&);
+
+/**
+ * The types used to store and multiply matrices of each Precision.
+ */
+template <Precision precision>
+struct PrecisionTraits;
+
+template <>
+struct PrecisionTraits<Precision::kFloat32> {
+  /// The type of each operand cell.
+  using Cell = float;
+
+  /// The type of each result cell, which the products are accumulated in.
+  using Accumulator = float;
+};
+
+template <>
+struct PrecisionTraits<Precision::kFloat16> {
+  using Cell = _Float16;
+  using Accumulator = _Float16;
+};
+
+template <>
+struct PrecisionTraits<Precision::kInt8> {
+  using Cell = int8_t;
+  using Accumulator = int32_t;
+};
+
+/// Multiplies two Size x Size matrices, writing the result to the third.
+template <size_t Size, Precision precision = Precision::kFloat32>
+using SquareMultiplyKernel = void (*)(
+    const Matrix<Size, Size, typename PrecisionTraits<precision>::Cell>&,
+    const Matrix<Size, Size, typename PrecisionTraits<precision>::Cell>&,
+    Matrix<Size, Size, typename PrecisionTraits<precision>::Accumulator>&);
+
+/// A SquareMultiplyKernel for each of kSquareMatrixSizes.
+template <Precision precision>
+using SquareMultiplyKernels = std::tuple<
+    SquareMultiplyKernel<16, precision>, SquareMultiplyKernel<32, precision>,
+    SquareMultiplyKernel<64, precision>, SquareMultiplyKernel<128, precision>,
+    SquareMultiplyKernel<256, precision>, SquareMultiplyKernel<512, precision>>;
+
+/// Computes columns [first, last) of the product of two Size x Size matrices,
+/// writing them to the same columns of the third.
+template <size_t Size>
+using SquareMultiplyColumnsKernel = void (*)(const Matrix<Size, Size>&,
+                                             const Matrix<Size, Size>&,
+                                             Matrix<Size, Size>&, size_t first,
+                                             size_t last);
+
+/// Transposes a Size x Size matrix, writing the result to the second.
+template <size_t Size>
+using TransposeKernel = void (*)(const Matrix<Size, Size>&,
+                                 Matrix<Size, Size>&);
+
+/// Returns the determinant of a Size x Size matrix.
+template <size_t Size>
+using DeterminantKernel = float (*)(const Matrix<Size, Size>&);
+
+/// Inverts a Size x Size matrix, writing the result to the second.
+template <size_t Size>
+using InverseKernel = void (*)(const Matrix<Size, Size>&, Matrix<Size, Size>&);
+
+/// Transforms a batch of points by a Mat4.
+using TransformKernel = void (*)(const Mat4<>&, PointSpan<const float>,
+                                 PointSpan<float>);
+
+/**
+ * The benchmarked operations of one backend, compiled for one CpuVariant.
+ */
+struct Kernels {
+  Vec4MultiplyKernel multiply_vec4;
+
+  // Keep in sync with kSquareMatrixSizes.
+  SquareMultiplyKernels<Precision::kFloat32> square_multiply;
+  SquareMultiplyKernels<Precision::kFloat16> square_multiply_f16;
+  SquareMultiplyKernels<Precision::kInt8> square_multiply_i8;
+
+  // Keep in sync with kSquareMatrixSizes. These always use BlockedMultiply's
+  // algorithm, regardless of size.
+  std::tuple<SquareMultiplyColumnsKernel<16>, SquareMultiplyColumnsKernel<32>,
+             SquareMultiplyColumnsKernel<64>, SquareMultiplyColumnsKernel<128>,
+             SquareMultiplyColumnsKernel<256>, SquareMultiplyColumnsKernel<512>>
+      square_multiply_columns;
+
+  TransformKernel transform_points;
+
+  // Keep in sync with kMatrixOperationSizes.
+  std::tuple<TransposeKernel<3>, TransposeKernel<4>> transpose;
+  std::tuple<DeterminantKernel<3>, DeterminantKernel<4>> determinant;
+  std::tuple<InverseKernel<3>, InverseKernel<4>> inverse;
+
+  /// Returns the square_multiply kernel for the given size and precision.
+  template <size_t Size, Precision precision = Precision::kFloat32>
+  [[nodiscard]] SquareMultiplyKernel<Size, precision> square_multiply_kernel()
+      const {
+    using Kernel = SquareMultiplyKernel<Size, precision>;
+    if constexpr (precision == Precision::kFloat32) {
+      return std::get<Kernel>(square_multiply);
+    } else if constexpr (precision == Precision::kFloat16) {
+      return std::get<Kernel>(square_multiply_f16);
+    } else {
+      static_assert(precision == Precision::kInt8);
+      return std::get<Kernel>(square_multiply_i8);
+    }
+  }
+
+  /// Returns the square_multiply_columns kernel for the given size.
+  template <size_t Size>
+  [[nodiscard]] SquareMultiplyColumnsKernel<Size>
+  square_multiply_columns_kernel() const {
+    return std::get<SquareMultiplyColumnsKernel<Size>>(
+        square_multiply_columns);
+  }
+
+  /// Returns the transpose kernel for the given size.
+  template <size_t Size>
+  [[nodiscard]] TransposeKernel<Size> transpose_kernel() const {
+    return std::get<TransposeKernel<Size>>(transpose);
+  }
+
+  /// Returns the determinant kernel for the given size.
+  template <size_t Size>
+  [[nodiscard]] DeterminantKernel<Size> determinant_kernel() const {
+    return std::get<DeterminantKernel<Size>>(determinant);
+  }
+
+  /// Returns the inverse kernel for the given size.
+  template <size_t Size>
+  [[nodiscard]] InverseKernel<Size> inverse_kernel() const {
+    return std::get<InverseKernel<Size>>(inverse);
+  }
+};
+
+/**
+ * Returns the kernels of a backend compiled for a CPU variant.
+ *
+ * Function multiversioning (target_clones) would pick a variant
+ * automatically, but it doesn't work with templates and wouldn't let the
+ * benchmarks choose a variant explicitly. Instead, kernels.cpp stamps out a
+ * copy of each kernel per variant with the target attribute, and this picks
+ * from those. Every backend's kernels are always_inline, so each copy really
+ * is compiled for its variant rather than calling a shared baseline
+ * implementation.
+ *
+ * This doesn't check whether the CPU supports the variant. See IsSupported.
+ *
+ * @param backend The backend to get kernels for.
+ * @param variant The instruction set the kernels should be compiled for.
+ * @return The kernels, or std::nullopt if the backend has no implementation
+ * or the variant isn't built for this architecture.
+ */
+[[nodiscard]] std::optional<Kernels> GetKernels(Backend backend,
+                                                CpuVariant variant);
+
+}  // namespace samples::vectorization
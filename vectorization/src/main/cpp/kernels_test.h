@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <tuple>
+
+#include "benchmark.h"
+#include "cpu_variant.h"
+#include "gtest/gtest.h"
+#include "kernels.h"
+
+namespace samples::vectorization {
+
+/**
+ * A test of the kernels of every backend and CpuVariant.
+ *
+ * Instantiate a test suite with this as its fixture using
+ * INSTANTIATE_KERNELS_TEST_SUITE. Combinations that weren't built or that the
+ * CPU can't run are skipped.
+ */
+class KernelsTest
+    : public testing::TestWithParam<std::tuple<Backend, CpuVariant>> {
+ protected:
+  void SetUp() override {
+    const auto [backend, variant] = GetParam();
+    if (!IsSupported(variant)) {
+      GTEST_SKIP() << CpuVariantName(variant) << " is not supported";
+    }
+    kernels_ = GetKernels(backend, variant);
+    if (!kernels_.has_value()) {
+      GTEST_SKIP() << BackendName(backend) << " has no "
+                   << CpuVariantName(variant) << " kernels";
+    }
+  }
+
+  /// The kernels under test. Only valid once SetUp has succeeded.
+  const Kernels& kernels() const { return *kernels_; }
+
+ private:
+  std::optional<Kernels> kernels_;
+};
+
+/// Names each KernelsTest instance after its backend and variant.
+inline std::string KernelsTestName(
+    const testing::TestParamInfo<KernelsTest::ParamType>& info) {
+  const auto [backend, variant] = info.param;
+  return std::string(BackendName(backend)) + "_" +
+         std::string(CpuVariantName(variant));
+}
+
+}  // namespace samples::vectorization
+
+/// Runs every test in the KernelsTest suite `suite` with every backend and
+/// CpuVariant.
+#define INSTANTIATE_KERNELS_TEST_SUITE(suite)                                 \
+  INSTANTIATE_TEST_SUITE_P(                                                   \
+      AllKernels, suite,                                                      \
+      testing::Combine(testing::ValuesIn(::samples::vectorization::kBackends), \
+                       testing::ValuesIn(                                     \
+                           ::samples::vectorization::kCpuVariants)),          \
+      ::samples::vectorization::KernelsTestName)
@@ -18,11 +18,15 @@
 
 #include <base/logging.h>
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <iostream>
 #include <ostream>
 #include <span>
+#include <type_traits>
+
+#include "blocked_multiply.h"
 
 namespace samples::vectorization {
 
@@ -120,14 +124,42 @@ class Matrix {
       const Matrix<OtherRows, OtherColumns, T>& rhs) const
     requires(OtherRows == Columns)
   {
-    auto m_lhs =
-        __builtin_matrix_column_major_load(data(), Rows, Columns, Rows);
-    auto m_rhs = __builtin_matrix_column_major_load(rhs.data(), OtherRows,
-                                                    OtherColumns, OtherRows);
-    auto m_result = m_lhs * m_rhs;
-
     Matrix<Rows, OtherColumns, T> result;
-    __builtin_matrix_column_major_store(m_result, result.data(), Rows);
+    MultiplyWithClangMatrices(*this, rhs, result);
+    return result;
+  }
+
+  /**
+   * Returns the transpose of this matrix.
+   */
+  Matrix<Columns, Rows, T> Transpose() const {
+    Matrix<Columns, Rows, T> result;
+    TransposeWithClangMatrices(*this, result);
+    return result;
+  }
+
+  /**
+   * Returns the determinant of this matrix.
+   *
+   * Only 3x3 and 4x4 matrices are supported.
+   */
+  T Determinant() const
+    requires(Rows == Columns && (Rows == 3 || Rows == 4))
+  {
+    return DeterminantWithClangMatrices(*this);
+  }
+
+  /**
+   * Returns the inverse of this matrix.
+   *
+   * Only 3x3 and 4x4 matrices are supported. The matrix must be invertible;
+   * otherwise the result is infinite or NaN.
+   */
+  Matrix<Rows, Columns, T> Inverse() const
+    requires(Rows == Columns && (Rows == 3 || Rows == 4))
+  {
+    Matrix<Rows, Columns, T> result;
+    InverseWithClangMatrices(*this, result);
     return result;
   }
 
@@ -140,10 +172,350 @@ class Matrix {
 template <size_t Rows, size_t Columns, typename T>
 Matrix(T (&&)[Rows][Columns]) -> Matrix<Rows, Columns, T>;
 
+template <typename T = float>
+using Mat3 = Matrix<3, 3, T>;
+
 template <typename T = float>
 using Mat4 = Matrix<4, 4, T>;
 
 template <typename T = float>
 using Vec4 = Matrix<4, 1, T>;
 
+/// A Rows x Columns Clang matrix of T.
+template <typename T, size_t Rows, size_t Columns>
+using ClangMatrix = T __attribute__((matrix_type(Rows, Columns)));
+
+/**
+ * Computes C += A * B for one tile of BlockedMultiply using Clang matrices.
+ *
+ * See BlockedMultiply for the meaning of each argument.
+ *
+ * @tparam T The type of each operand cell.
+ * @tparam M The column stride of a and c.
+ * @tparam N The column stride of b.
+ * @tparam Acc The type of each result cell.
+ */
+template <typename T, size_t M, size_t N, typename Acc = T>
+[[clang::always_inline]] void ClangMatrixMicroKernel(const T* _Nonnull a,
+                                                     const T* _Nonnull b,
+                                                     Acc* _Nonnull c,
+                                                     size_t depth) {
+  // The load and store builtins take a stride, so they can operate directly on
+  // a tile of a larger matrix. The products are done in kStep deep slices to
+  // keep each operand small enough to stay in registers. Matrices can only be
+  // multiplied if their element types match, so a wider result needs the
+  // operands to be converted first.
+  constexpr size_t kStep = kMicroKernelStep;
+  auto accumulator = __builtin_matrix_column_major_load(c, kMicroTileRows,
+                                                        kMicroTileColumns, M);
+  size_t k = 0;
+  for (; k + kStep <= depth; k += kStep) {
+    auto a_slice =
+        __builtin_matrix_column_major_load(a + k * M, kMicroTileRows, kStep, M);
+    auto b_slice = __builtin_matrix_column_major_load(b + k, kStep,
+                                                      kMicroTileColumns, N);
+    accumulator +=
+        static_cast<ClangMatrix<Acc, kMicroTileRows, kStep>>(a_slice) *
+        static_cast<ClangMatrix<Acc, kStep, kMicroTileColumns>>(b_slice);
+  }
+  for (; k < depth; k++) {
+    auto a_column =
+        __builtin_matrix_column_major_load(a + k * M, kMicroTileRows, 1, M);
+    auto b_row =
+        __builtin_matrix_column_major_load(b + k, 1, kMicroTileColumns, N);
+    accumulator += static_cast<ClangMatrix<Acc, kMicroTileRows, 1>>(a_column) *
+                   static_cast<ClangMatrix<Acc, 1, kMicroTileColumns>>(b_row);
+  }
+  __builtin_matrix_column_major_store(accumulator, c, M);
+}
+
+/**
+ * Multiplies two compatible matrices using Clang's matrix types.
+ *
+ * This is the implementation of Matrix::operator*. This overload writes to an
+ * existing matrix rather than returning a new one, which is useful for
+ * matrices that are too large to be put on the stack.
+ *
+ * @tparam T The type of each operand cell.
+ * @tparam Acc The type of each result cell, which may be wider than T. See
+ * BlockedMultiply.
+ * @tparam M The number of rows in the left operand and the result.
+ * @tparam N The number of columns in the left operand, and the rows in the
+ * right operand.
+ * @tparam P The number of columns in the right operand and the result.
+ * @param lhs The left operand.
+ * @param rhs The right operand.
+ * @param result The destination for lhs * rhs. Must not be either operand.
+ */
+template <typename T, typename Acc, size_t M, size_t N, size_t P>
+[[clang::always_inline]] void MultiplyWithClangMatrices(
+    const Matrix<M, N, T>& lhs, const Matrix<N, P, T>& rhs,
+    Matrix<M, P, Acc>& result) {
+  if constexpr (kUseBlockedMultiply<M, N, P>) {
+    // Clang fully unrolls matrix operations, so multiplying the whole matrix
+    // at once would generate an enormous amount of code (and spill most of
+    // it) for anything but small matrices.
+    BlockedMultiply<T, M, N, P>(lhs.data(), rhs.data(), result.data(),
+                                ClangMatrixMicroKernel<T, M, N, Acc>);
+  } else {
+    auto m_lhs = __builtin_matrix_column_major_load(lhs.data(), M, N, M);
+    auto m_rhs = __builtin_matrix_column_major_load(rhs.data(), N, P, N);
+    auto m_result = static_cast<ClangMatrix<Acc, M, N>>(m_lhs) *
+                    static_cast<ClangMatrix<Acc, N, P>>(m_rhs);
+    __builtin_matrix_column_major_store(m_result, result.data(), M);
+  }
+}
+
+/**
+ * Transposes a matrix using Clang's matrix types.
+ *
+ * This is the implementation of Matrix::Transpose.
+ *
+ * @tparam T The type of each matrix cell.
+ * @tparam M The number of rows in m.
+ * @tparam N The number of columns in m.
+ * @param m The matrix to transpose.
+ * @param result The destination for the transpose of m. Must not be m.
+ */
+template <typename T, size_t M, size_t N>
+[[clang::always_inline]] void TransposeWithClangMatrices(
+    const Matrix<M, N, T>& m, Matrix<N, M, T>& result) {
+  auto matrix = __builtin_matrix_column_major_load(m.data(), M, N, M);
+  __builtin_matrix_column_major_store(__builtin_matrix_transpose(matrix),
+                                      result.data(), N);
+}
+
+/// A 3D vector as a Clang matrix.
+template <typename T>
+using ClangMatrixVec3 = T __attribute__((matrix_type(3, 1)));
+
+/**
+ * Returns the dot product of two 3D vectors stored as Clang matrices.
+ */
+template <typename T>
+[[clang::always_inline]] T ClangMatrixDot(ClangMatrixVec3<T> a,
+                                          ClangMatrixVec3<T> b) {
+  return (__builtin_matrix_transpose(a) * b)[0][0];
+}
+
+/**
+ * Returns the cross product of two 3D vectors stored as Clang matrices.
+ *
+ * Clang's matrix types can't be shuffled, so this is written as a matrix
+ * product instead: a x b is [a]x * b, where [a]x is the skew-symmetric matrix
+ * of a.
+ */
+template <typename T>
+[[clang::always_inline]] ClangMatrixVec3<T> ClangMatrixCross(
+    ClangMatrixVec3<T> a, ClangMatrixVec3<T> b) {
+  const T skew[] = {
+      0,        a[2][0],  -a[1][0],  // Column 0.
+      -a[2][0], 0,        a[0][0],   // Column 1.
+      a[1][0],  -a[0][0], 0,         // Column 2.
+  };
+  return __builtin_matrix_column_major_load(skew, 3, 3, 3) * b;
+}
+
+/**
+ * Computes the determinant of a 3x3 or 4x4 matrix using Clang's matrix types.
+ *
+ * This is the implementation of Matrix::Determinant. See
+ * InverseWithClangMatrices for the algorithm.
+ *
+ * @tparam T The type of each matrix cell.
+ * @tparam N The number of rows and columns in m.
+ * @param m The matrix.
+ * @return The determinant of m.
+ */
+template <typename T, size_t N>
+  requires(N == 3 || N == 4)
+[[clang::always_inline]] T DeterminantWithClangMatrices(
+    const Matrix<N, N, T>& m) {
+  auto a = __builtin_matrix_column_major_load(m.data(), 3, 1, N);
+  auto b = __builtin_matrix_column_major_load(m.data() + N, 3, 1, N);
+  auto c = __builtin_matrix_column_major_load(m.data() + 2 * N, 3, 1, N);
+  if constexpr (N == 3) {
+    return ClangMatrixDot<T>(a, ClangMatrixCross<T>(b, c));
+  } else {
+    auto d = __builtin_matrix_column_major_load(m.data() + 3 * N, 3, 1, N);
+    auto s = ClangMatrixCross<T>(a, b);
+    auto t = ClangMatrixCross<T>(c, d);
+    auto u = a * m[3, 1] - b * m[3, 0];
+    auto v = c * m[3, 3] - d * m[3, 2];
+    return ClangMatrixDot<T>(s, v) + ClangMatrixDot<T>(t, u);
+  }
+}
+
+/**
+ * Inverts a 3x3 or 4x4 matrix using Clang's matrix types.
+ *
+ * This is the implementation of Matrix::Inverse. Every backend uses the same
+ * algorithm, which works on 3D vectors so that it suits SIMD. For a 3x3 matrix
+ * with columns a, b, and c, the rows of the inverse are b x c, c x a, and
+ * a x b, divided by the determinant a . (b x c). A 4x4 matrix is treated as
+ * four 3D columns a, b, c, and d plus a fourth row (x, y, z, w), which
+ * reduces the inverse to a handful of cross and dot products. See Eric
+ * Lengyel's Foundations of Game Engine Development, Volume 1, section 1.7.5.
+ *
+ * Clang's matrix types have no shuffles or element-wise products, so the
+ * cross products here are matrix products. Compare with the other backends.
+ *
+ * @tparam T The type of each matrix cell.
+ * @tparam N The number of rows and columns in m.
+ * @param m The matrix to invert. Must be invertible; otherwise the result is
+ * infinite or NaN.
+ * @param result The destination for the inverse of m. Must not be m.
+ */
+template <typename T, size_t N>
+  requires(N == 3 || N == 4)
+[[clang::always_inline]] void InverseWithClangMatrices(
+    const Matrix<N, N, T>& m, Matrix<N, N, T>& result) {
+  auto a = __builtin_matrix_column_major_load(m.data(), 3, 1, N);
+  auto b = __builtin_matrix_column_major_load(m.data() + N, 3, 1, N);
+  auto c = __builtin_matrix_column_major_load(m.data() + 2 * N, 3, 1, N);
+
+  // Storing the transpose of a 3x1 matrix with a stride of N writes it to the
+  // first three cells of a row of the result.
+  auto store_row = [&](size_t row, ClangMatrixVec3<T> value) {
+    __builtin_matrix_column_major_store(__builtin_matrix_transpose(value),
+                                        result.data() + row, N);
+  };
+
+  if constexpr (N == 3) {
+    auto r0 = ClangMatrixCross<T>(b, c);
+    const T inv_det = 1 / ClangMatrixDot<T>(a, r0);
+    store_row(0, r0 * inv_det);
+    store_row(1, ClangMatrixCross<T>(c, a) * inv_det);
+    store_row(2, ClangMatrixCross<T>(a, b) * inv_det);
+  } else {
+    auto d = __builtin_matrix_column_major_load(m.data() + 3 * N, 3, 1, N);
+    const T x = m[3, 0];
+    const T y = m[3, 1];
+    const T z = m[3, 2];
+    const T w = m[3, 3];
+
+    auto s = ClangMatrixCross<T>(a, b);
+    auto t = ClangMatrixCross<T>(c, d);
+    auto u = a * y - b * x;
+    auto v = c * w - d * z;
+    const T inv_det =
+        1 / (ClangMatrixDot<T>(s, v) + ClangMatrixDot<T>(t, u));
+    s = s * inv_det;
+    t = t * inv_det;
+    u = u * inv_det;
+    v = v * inv_det;
+
+    store_row(0, ClangMatrixCross<T>(b, v) + t * y);
+    store_row(1, ClangMatrixCross<T>(v, a) - t * x);
+    store_row(2, ClangMatrixCross<T>(d, u) + s * w);
+    store_row(3, ClangMatrixCross<T>(u, c) - s * z);
+    result[0, 3] = -ClangMatrixDot<T>(b, t);
+    result[1, 3] = ClangMatrixDot<T>(a, t);
+    result[2, 3] = -ClangMatrixDot<T>(d, s);
+    result[3, 3] = ClangMatrixDot<T>(c, s);
+  }
+}
+
+/**
+ * A batch of 4D points stored as a structure of arrays (SoA).
+ *
+ * Each span holds a single component for every point in the batch, so the
+ * point at index i is `{x[i], y[i], z[i], w[i]}`. All four spans must be the
+ * same length.
+ *
+ * Vertex data is usually stored as an array of structures (each vertex's
+ * components next to each other), but that layout needs shuffles to get
+ * anything useful into a vector register. With SoA, a single vector load gives
+ * us the same component for several consecutive points.
+ *
+ * @tparam T The type of each component. Use a const type for input batches.
+ */
+template <typename T = float>
+struct PointSpan {
+  std::span<T> x;
+  std::span<T> y;
+  std::span<T> z;
+  std::span<T> w;
+
+  [[nodiscard, clang::always_inline]] constexpr size_t size() const {
+    return x.size();
+  }
+
+  [[nodiscard]] constexpr bool IsValid() const {
+    return y.size() == x.size() && z.size() == x.size() &&
+           w.size() == x.size();
+  }
+
+  /// Returns the count points starting at offset.
+  [[nodiscard]] constexpr PointSpan subspan(size_t offset, size_t count) const {
+    return {x.subspan(offset, count), y.subspan(offset, count),
+            z.subspan(offset, count), w.subspan(offset, count)};
+  }
+
+  // Allows passing a mutable batch where a read-only batch is expected.
+  constexpr operator PointSpan<const T>() const
+    requires(!std::is_const_v<T>)
+  {
+    return {x, y, z, w};
+  }
+};
+
+/**
+ * Transforms each point in a batch by a matrix, writing the results to out.
+ *
+ * This is the Clang matrix implementation, and like Matrix::operator* it is
+ * the default.
+ *
+ * The points are processed in blocks. Each block is loaded as a kBlock x 4
+ * matrix P where each row is a point, so the transformed block is
+ * (M * P^T)^T = P * M^T. That avoids transposing the (much larger) point data.
+ * The final partial block is zero padded.
+ *
+ * @tparam T The type of each matrix cell.
+ * @param m The transform to apply.
+ * @param in The points to transform.
+ * @param out The destination for the transformed points. Must be the same size
+ * as in. May be the same buffers as in.
+ */
+template <typename T>
+[[clang::always_inline]] void TransformPoints(const Mat4<T>& m,
+                                              PointSpan<const T> in,
+                                              PointSpan<T> out) {
+  DCHECK(in.IsValid());
+  DCHECK(out.IsValid());
+  DCHECK_EQ(in.size(), out.size());
+
+  constexpr size_t kBlock = 8;
+  auto m_transposed = __builtin_matrix_transpose(
+      __builtin_matrix_column_major_load(m.data(), 4, 4, 4));
+
+  auto transform_block = [&](size_t first, size_t count) {
+    // Column major storage for the block means each column is one component,
+    // so loading the block is just four copies. For full blocks count is a
+    // constant after inlining and Clang turns these into vector loads and
+    // stores.
+    T block[kBlock * 4] = {};
+    std::copy_n(&in.x[first], count, &block[0 * kBlock]);
+    std::copy_n(&in.y[first], count, &block[1 * kBlock]);
+    std::copy_n(&in.z[first], count, &block[2 * kBlock]);
+    std::copy_n(&in.w[first], count, &block[3 * kBlock]);
+
+    auto points = __builtin_matrix_column_major_load(block, kBlock, 4, kBlock);
+    __builtin_matrix_column_major_store(points * m_transposed, block, kBlock);
+
+    std::copy_n(&block[0 * kBlock], count, &out.x[first]);
+    std::copy_n(&block[1 * kBlock], count, &out.y[first]);
+    std::copy_n(&block[2 * kBlock], count, &out.z[first]);
+    std::copy_n(&block[3 * kBlock], count, &out.w[first]);
+  };
+
+  const size_t full_blocks_end = in.size() - in.size() % kBlock;
+  for (size_t i = 0; i < full_blocks_end; i += kBlock) {
+    transform_block(i, kBlock);
+  }
+  if (full_blocks_end != in.size()) {
+    transform_block(full_blocks_end, in.size() - full_blocks_end);
+  }
+}
+
 }  // namespace samples::vectorization
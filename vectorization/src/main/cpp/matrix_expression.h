@@ -0,0 +1,291 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <concepts>
+#include <tuple>
+#include <type_traits>
+
+#include "blocked_multiply.h"
+#include "matrix.h"
+
+/**
+ * Lazily evaluated sums and products of small matrices.
+ *
+ * Matrix::operator* evaluates eagerly, so `proj * view * model * v` computes
+ * (and stores) two 4x4 products before the one matrix-vector product that was
+ * actually wanted. Wrapping each operand in Lazy instead builds an expression
+ * that records the chain, and Evaluate then multiplies it in the order that
+ * needs the fewest multiplies. For that example, that's right to left, as
+ * three matrix-vector products: 48 multiplies rather than 144. The whole
+ * expression is evaluated as Clang matrix values, so nothing is stored to
+ * memory except the final result.
+ *
+ * Since the whole expression is kept in registers, this is only for matrices
+ * small enough for kFitsInRegisters.
+ *
+ * ```
+ * Vec4<> clip = Evaluate(Lazy(proj) * Lazy(view) * Lazy(model) * Lazy(v));
+ * ```
+ *
+ * An expression refers to its operands rather than copying them, so it must be
+ * evaluated before any of them are destroyed.
+ */
+namespace samples::vectorization {
+
+/**
+ * A lazily evaluated matrix.
+ *
+ * Has the dimensions of the result as kRows and kColumns, its cell type as
+ * value_type, and an Evaluate member that returns the result as a Clang
+ * matrix.
+ */
+template <typename E>
+concept MatrixExpression = requires(const E& e) {
+  { E::kRows } -> std::convertible_to<size_t>;
+  { E::kColumns } -> std::convertible_to<size_t>;
+  typename E::value_type;
+  {
+    e.Evaluate()
+  } -> std::same_as<
+      ClangMatrix<typename E::value_type, E::kRows, E::kColumns>>;
+};
+
+/**
+ * A reference to an existing Matrix, as a leaf of an expression. See Lazy.
+ */
+template <size_t Rows, size_t Columns, typename T>
+class LazyMatrix {
+ public:
+  static constexpr size_t kRows = Rows;
+  static constexpr size_t kColumns = Columns;
+  using value_type = T;
+
+  explicit LazyMatrix(const Matrix<Rows, Columns, T>& m) : m_(m) {}
+
+  [[nodiscard, clang::always_inline]] ClangMatrix<T, Rows, Columns> Evaluate()
+      const {
+    return __builtin_matrix_column_major_load(m_.data(), Rows, Columns, Rows);
+  }
+
+ private:
+  const Matrix<Rows, Columns, T>& m_;
+};
+
+/**
+ * Wraps a Matrix so that operators applied to it build an expression rather
+ * than computing a result.
+ */
+template <size_t Rows, size_t Columns, typename T>
+[[nodiscard]] LazyMatrix<Rows, Columns, T> Lazy(
+    const Matrix<Rows, Columns, T>& m) {
+  static_assert(kFitsInRegisters<Rows, Columns, 1>,
+                "Lazy evaluation keeps the whole matrix in registers");
+  return LazyMatrix<Rows, Columns, T>(m);
+}
+
+/**
+ * The sum of two expressions with the same dimensions.
+ */
+template <MatrixExpression L, MatrixExpression R>
+class LazySum {
+ public:
+  static constexpr size_t kRows = L::kRows;
+  static constexpr size_t kColumns = L::kColumns;
+  using value_type = L::value_type;
+
+  LazySum(const L& lhs, const R& rhs) : lhs_(lhs), rhs_(rhs) {}
+
+  [[nodiscard, clang::always_inline]] ClangMatrix<value_type, kRows, kColumns>
+  Evaluate() const {
+    return lhs_.Evaluate() + rhs_.Evaluate();
+  }
+
+ private:
+  // Nodes are copied into the expressions that use them, but leaves hold
+  // references, so copying a whole expression is cheap.
+  L lhs_;
+  R rhs_;
+};
+
+template <MatrixExpression L, MatrixExpression R>
+class LazyProduct;
+
+/// Whether E is a LazyProduct.
+template <typename E>
+inline constexpr bool kIsLazyProduct = false;
+
+template <MatrixExpression L, MatrixExpression R>
+inline constexpr bool kIsLazyProduct<LazyProduct<L, R>> = true;
+
+/**
+ * Returns the factors of a chain of products, in order, as a tuple of
+ * references. Anything other than a product is a single factor.
+ */
+template <MatrixExpression E>
+[[clang::always_inline]] auto Factors(const E& e) {
+  if constexpr (kIsLazyProduct<E>) {
+    return std::tuple_cat(Factors(e.lhs()), Factors(e.rhs()));
+  } else {
+    return std::tuple<const E&>(e);
+  }
+}
+
+/**
+ * The order to multiply a chain of Count matrices in.
+ *
+ * split[i][j] is the index of the last factor in the left operand of the
+ * final multiply of factors i through j.
+ */
+template <size_t Count>
+struct ChainOrder {
+  std::array<std::array<size_t, Count>, Count> split = {};
+};
+
+/**
+ * Finds the order to multiply a chain of matrices in that needs the fewest
+ * scalar multiplies, with the textbook dynamic programming algorithm (see
+ * https://en.wikipedia.org/wiki/Matrix_chain_multiplication). This runs at
+ * compile time, since every dimension is known then.
+ *
+ * @param dimensions Factor i has dimensions[i] rows and dimensions[i + 1]
+ * columns.
+ */
+template <size_t Count>
+consteval ChainOrder<Count> FindChainOrder(
+    const std::array<size_t, Count + 1>& dimensions) {
+  ChainOrder<Count> order;
+  std::array<std::array<size_t, Count>, Count> cost = {};
+  for (size_t length = 2; length <= Count; length++) {
+    for (size_t i = 0; i + length <= Count; i++) {
+      const size_t j = i + length - 1;
+      cost[i][j] = SIZE_MAX;
+      for (size_t k = i; k < j; k++) {
+        const size_t candidate = cost[i][k] + cost[k + 1][j] +
+                                 dimensions[i] * dimensions[k + 1] *
+                                     dimensions[j + 1];
+        if (candidate < cost[i][j]) {
+          cost[i][j] = candidate;
+          order.split[i][j] = k;
+        }
+      }
+    }
+  }
+  return order;
+}
+
+/**
+ * The product of two expressions. The whole chain that this is the root of is
+ * evaluated in the cheapest order, regardless of how it was written.
+ */
+template <MatrixExpression L, MatrixExpression R>
+class LazyProduct {
+ public:
+  static constexpr size_t kRows = L::kRows;
+  static constexpr size_t kColumns = R::kColumns;
+  using value_type = L::value_type;
+
+  LazyProduct(const L& lhs, const R& rhs) : lhs_(lhs), rhs_(rhs) {}
+
+  [[nodiscard]] const L& lhs() const { return lhs_; }
+  [[nodiscard]] const R& rhs() const { return rhs_; }
+
+  [[nodiscard, clang::always_inline]] ClangMatrix<value_type, kRows, kColumns>
+  Evaluate() const {
+    const auto factors = Factors(*this);
+    constexpr size_t kCount = std::tuple_size_v<decltype(factors)>;
+    return EvaluateChain<0, kCount - 1>(factors);
+  }
+
+ private:
+  /// The dimensions of each factor in a tuple returned by Factors, in the
+  /// form expected by FindChainOrder.
+  template <typename... F>
+  static consteval std::array<size_t, sizeof...(F) + 1> Dimensions(
+      std::type_identity<std::tuple<const F&...>>) {
+    using First = std::tuple_element_t<0, std::tuple<F...>>;
+    return {First::kRows, F::kColumns...};
+  }
+
+  /// Multiplies factors I through J in the cheapest order.
+  template <size_t I, size_t J, typename Tuple>
+  [[clang::always_inline]] static auto EvaluateChain(const Tuple& factors) {
+    if constexpr (I == J) {
+      return std::get<I>(factors).Evaluate();
+    } else {
+      constexpr auto kOrder = FindChainOrder<std::tuple_size_v<Tuple>>(
+          Dimensions(std::type_identity<Tuple>()));
+      constexpr size_t kSplit = kOrder.split[I][J];
+      return EvaluateChain<I, kSplit>(factors) *
+             EvaluateChain<kSplit + 1, J>(factors);
+    }
+  }
+
+  L lhs_;
+  R rhs_;
+};
+
+/**
+ * Returns an expression for lhs * rhs.
+ */
+template <MatrixExpression L, MatrixExpression R>
+  requires(L::kColumns == R::kRows &&
+           std::is_same_v<typename L::value_type, typename R::value_type>)
+[[nodiscard]] LazyProduct<L, R> operator*(const L& lhs, const R& rhs) {
+  return LazyProduct<L, R>(lhs, rhs);
+}
+
+/**
+ * Returns an expression for lhs + rhs.
+ */
+template <MatrixExpression L, MatrixExpression R>
+  requires(L::kRows == R::kRows && L::kColumns == R::kColumns &&
+           std::is_same_v<typename L::value_type, typename R::value_type>)
+[[nodiscard]] LazySum<L, R> operator+(const L& lhs, const R& rhs) {
+  return LazySum<L, R>(lhs, rhs);
+}
+
+/**
+ * Evaluates an expression, writing the result to an existing matrix.
+ *
+ * @param e The expression to evaluate.
+ * @param result The destination for the result. May be one of the operands of
+ * e.
+ */
+template <MatrixExpression E>
+[[clang::always_inline]] void Evaluate(
+    const E& e, Matrix<E::kRows, E::kColumns, typename E::value_type>& result) {
+  __builtin_matrix_column_major_store(e.Evaluate(), result.data(), E::kRows);
+}
+
+/**
+ * Evaluates an expression and returns the result.
+ */
+template <MatrixExpression E>
+[[nodiscard, clang::always_inline]] Matrix<E::kRows, E::kColumns,
+                                           typename E::value_type>
+Evaluate(const E& e) {
+  Matrix<E::kRows, E::kColumns, typename E::value_type> result;
+  Evaluate(e, result);
+  return result;
+}
+
+}  // namespace samples::vectorization
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "matrix_expression.h"
+
+#include <stddef.h>
+
+#include "gtest/gtest.h"
+#include "matrix.h"
+#include "operands.h"
+
+namespace samples::vectorization {
+namespace {
+
+// proj * view * model * v is cheapest right to left, so the last multiply is
+// proj by everything else.
+static_assert(FindChainOrder<4>({4, 4, 4, 4, 1}).split[0][3] == 0);
+// And a row vector times a chain is cheapest left to right.
+static_assert(FindChainOrder<3>({1, 4, 4, 4}).split[0][2] == 1);
+
+/// Fills a matrix with small integers, so that every order of evaluation gives
+/// exactly the same result.
+template <size_t Rows, size_t Columns>
+void InitOperand(Matrix<Rows, Columns>& m, size_t seed) {
+  for (auto row = 0U; row < Rows; row++) {
+    for (auto column = 0U; column < Columns; column++) {
+      m[row, column] =
+          static_cast<float>((row * 5 + column * 3 + seed) % 7) - 3.0f;
+    }
+  }
+}
+
+// BenchmarkMvpTransform's inputs, which must give the same result for both
+// Evaluations.
+TEST(MatrixExpressionTest, MvpTransform) {
+  const MvpInputs inputs = MakeMvpInputs();
+  for (size_t i = 0; i < kMvpBatchSize; i++) {
+    const Vec4<> eager =
+        inputs.projection * inputs.view * inputs.models[i] * inputs.vertices[i];
+    const Vec4<> fused =
+        Evaluate(Lazy(inputs.projection) * Lazy(inputs.view) *
+                 Lazy(inputs.models[i]) * Lazy(inputs.vertices[i]));
+    ASSERT_EQ(eager, fused) << "vertex " << i;
+  }
+}
+
+// A chain whose cheapest order is neither left to right nor right to left:
+// b * c first, since that's a 1x1 matrix.
+TEST(MatrixExpressionTest, MixedChain) {
+  static_assert(FindChainOrder<4>({4, 1, 4, 1, 4}).split[1][3] == 2);
+  Matrix<4, 1> a;
+  Matrix<1, 4> b;
+  Matrix<4, 1> c;
+  Matrix<1, 4> d;
+  InitOperand(a, 0);
+  InitOperand(b, 1);
+  InitOperand(c, 2);
+  InitOperand(d, 3);
+
+  const Matrix<4, 4> expected = a * b * c * d;
+  const Matrix<4, 4> actual = Evaluate(Lazy(a) * Lazy(b) * Lazy(c) * Lazy(d));
+
+  EXPECT_EQ(actual, expected);
+}
+
+TEST(MatrixExpressionTest, SumOfProducts) {
+  Mat4<> a;
+  Mat4<> b;
+  Mat4<> c;
+  Vec4<> v;
+  InitOperand(a, 0);
+  InitOperand(b, 1);
+  InitOperand(c, 2);
+  InitOperand(v, 3);
+
+  const Vec4<> ab = a * b * v;
+  const Vec4<> cv = c * v;
+  Vec4<> expected;
+  for (size_t row = 0; row < 4; row++) {
+    expected[row, 0] = ab[row, 0] + cv[row, 0];
+  }
+  Vec4<> actual;
+  Evaluate(Lazy(a) * Lazy(b) * Lazy(v) + Lazy(c) * Lazy(v), actual);
+
+  EXPECT_EQ(actual, expected);
+}
+
+}  // namespace
+}  // namespace samples::vectorization
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "kernels.h"
+#include "kernels_test.h"
+#include "matrix.h"
+#include "operands.h"
+
+namespace samples::vectorization {
+namespace {
+
+using MatrixOperationTest = KernelsTest;
+
+/**
+ * Computes the determinant of m in double precision with Gaussian
+ * elimination, as a reference for the float implementations.
+ */
+template <size_t Size>
+double ReferenceDeterminant(const Matrix<Size, Size>& m) {
+  double cells[Size][Size];
+  for (auto row = 0U; row < Size; row++) {
+    for (auto column = 0U; column < Size; column++) {
+      cells[row][column] = m[row, column];
+    }
+  }
+
+  double determinant = 1;
+  for (auto pivot = 0U; pivot < Size; pivot++) {
+    auto best = pivot;
+    for (auto row = pivot + 1; row < Size; row++) {
+      if (std::abs(cells[row][pivot]) > std::abs(cells[best][pivot])) {
+        best = row;
+      }
+    }
+    if (best != pivot) {
+      std::swap(cells[best], cells[pivot]);
+      determinant = -determinant;
+    }
+    determinant *= cells[pivot][pivot];
+    for (auto row = pivot + 1; row < Size; row++) {
+      const double factor = cells[row][pivot] / cells[pivot][pivot];
+      for (auto column = pivot; column < Size; column++) {
+        cells[row][column] -= factor * cells[pivot][column];
+      }
+    }
+  }
+  return determinant;
+}
+
+template <size_t Size>
+void ExpectTransposes(TransposeKernel<Size> transpose) {
+  SCOPED_TRACE(Size);
+  const auto inputs = MakeOperationInputs<Size>();
+  for (const auto& input : inputs) {
+    Matrix<Size, Size> output;
+    transpose(input, output);
+    for (auto row = 0U; row < Size; row++) {
+      for (auto column = 0U; column < Size; column++) {
+        ASSERT_EQ((output[column, row]), (input[row, column]))
+            << "for matrix " << input;
+      }
+    }
+  }
+}
+
+template <size_t Size>
+void ExpectDeterminants(DeterminantKernel<Size> determinant) {
+  SCOPED_TRACE(Size);
+  const auto inputs = MakeOperationInputs<Size>();
+  for (const auto& input : inputs) {
+    const double expected = ReferenceDeterminant(input);
+    ASSERT_LE(std::abs(determinant(input) - expected),
+              std::abs(expected) * 1e-5)
+        << "for matrix " << input;
+  }
+}
+
+template <size_t Size>
+void ExpectInverses(InverseKernel<Size> inverse) {
+  SCOPED_TRACE(Size);
+  const auto inputs = MakeOperationInputs<Size>();
+  for (const auto& input : inputs) {
+    Matrix<Size, Size> output;
+    inverse(input, output);
+    // The product of a matrix and its inverse should be the identity.
+    for (auto row = 0U; row < Size; row++) {
+      for (auto column = 0U; column < Size; column++) {
+        double cell = 0;
+        for (auto k = 0U; k < Size; k++) {
+          cell += static_cast<double>(input[row, k]) *
+                  static_cast<double>(output[k, column]);
+        }
+        const double expected = row == column ? 1 : 0;
+        ASSERT_LE(std::abs(cell - expected), 1e-5)
+            << "for matrix " << input << " with inverse " << output;
+      }
+    }
+  }
+}
+
+// Keep these in sync with kMatrixOperationSizes.
+
+TEST_P(MatrixOperationTest, Transpose) {
+  ExpectTransposes<3>(kernels().transpose_kernel<3>());
+  ExpectTransposes<4>(kernels().transpose_kernel<4>());
+}
+
+TEST_P(MatrixOperationTest, Determinant) {
+  ExpectDeterminants<3>(kernels().determinant_kernel<3>());
+  ExpectDeterminants<4>(kernels().determinant_kernel<4>());
+}
+
+TEST_P(MatrixOperationTest, Inverse) {
+  ExpectInverses<3>(kernels().inverse_kernel<3>());
+  ExpectInverses<4>(kernels().inverse_kernel<4>());
+}
+
+INSTANTIATE_KERNELS_TEST_SUITE(MatrixOperationTest);
+
+}  // namespace
+}  // namespace samples::vectorization
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+
+#include <memory>
+#include <string_view>
+
+#include "auto_vectorization.h"
+#include "blocked_multiply.h"
+#include "clang_vector.h"
+#include "cxx_simd.h"
+#include "gtest/gtest.h"
+#include "kernels.h"
+#include "kernels_test.h"
+#include "matrix.h"
+#include "omp_simd.h"
+#include "operands.h"
+
+namespace samples::vectorization {
+namespace {
+
+// Thin multiplies can't fill a micro tile, so they must keep the simple
+// implementations. ClangMatrixMicroKernel doesn't compile for them.
+static_assert(!kUseBlockedMultiply<4, 4, 64>);
+static_assert(!kUseBlockedMultiply<64, 4, 64>);
+static_assert(!kUseBlockedMultiply<64, 64, 2>);
+static_assert(kUseBlockedMultiply<64, 64, 64>);
+static_assert(kUseBlockedMultiply<33, 9, 6>);
+
+/// Fills a matrix with small integers, so that every product is exact
+/// regardless of the order of operations used by the implementation.
+template <size_t Rows, size_t Columns>
+void InitOperand(Matrix<Rows, Columns>& m, size_t seed) {
+  for (auto row = 0U; row < Rows; row++) {
+    for (auto column = 0U; column < Columns; column++) {
+      m[row, column] =
+          static_cast<float>((row * 7 + column * 3 + seed) % 5) - 2.0f;
+    }
+  }
+}
+
+/**
+ * Checks every backend's multiply of an M x N matrix by an N x P matrix
+ * against ReferenceMultiply.
+ *
+ * This calls each backend's implementation directly, rather than through
+ * Kernels, so that it can use sizes that the benchmarks don't.
+ */
+template <size_t M, size_t N, size_t P>
+void ExpectMultiplies() {
+  SCOPED_TRACE(testing::Message() << M << "x" << N << " * " << N << "x" << P);
+  auto lhs = std::make_unique<Matrix<M, N>>();
+  auto rhs = std::make_unique<Matrix<N, P>>();
+  auto expected = std::make_unique<Matrix<M, P>>();
+  InitOperand(*lhs, 0);
+  InitOperand(*rhs, 1);
+  ReferenceMultiply(*lhs, *rhs, *expected);
+
+  auto check = [&](std::string_view backend, auto multiply) {
+    auto result = std::make_unique<Matrix<M, P>>();
+    multiply(*lhs, *rhs, *result);
+    // Not EXPECT_EQ, which would print both matrices in full.
+    EXPECT_TRUE(*result == *expected) << backend;
+  };
+  check("auto_vectorization", [](const auto& l, const auto& r, auto& out) {
+    MultiplyWithAutoVectorization(l, r, out);
+  });
+  check("cxx_simd", [](const auto& l, const auto& r, auto& out) {
+    MultiplyWithCxxSimd(l, r, out);
+  });
+  check("clang_vector", [](const auto& l, const auto& r, auto& out) {
+    MultiplyWithClangVectors(l, r, out);
+  });
+  check("clang_matrix", [](const auto& l, const auto& r, auto& out) {
+    MultiplyWithClangMatrices(l, r, out);
+  });
+  check("openmp", [](const auto& l, const auto& r, auto& out) {
+    MultiplyWithOpenMP(l, r, out);
+  });
+}
+
+// Mostly a compile test: shapes with one large dimension, like Mat4 *
+// Matrix<4, 64>, once chose BlockedMultiply and stopped compiling.
+TEST(MultiplyTest, ThinShapes) {
+  ExpectMultiplies<4, 4, 64>();
+  ExpectMultiplies<64, 4, 64>();
+}
+
+// Sizes that aren't a multiple of the micro tile, kMicroKernelStep, or the
+// cache blocks, so that BlockedMultiply's edges are all exercised.
+TEST(MultiplyTest, PartialTiles) {
+  ExpectMultiplies<33, 9, 6>();
+  ExpectMultiplies<70, 130, 37>();
+}
+
+using SquareMultiplyTest = KernelsTest;
+
+template <size_t Size>
+void ExpectSquareMultiply(const Kernels& kernels) {
+  SCOPED_TRACE(Size);
+  auto lhs = std::make_unique<Matrix<Size, Size>>();
+  auto rhs = std::make_unique<Matrix<Size, Size>>();
+  auto expected = std::make_unique<Matrix<Size, Size>>();
+  auto result = std::make_unique<Matrix<Size, Size>>();
+  InitSquareOperands(*lhs, *rhs);
+  ReferenceMultiply(*lhs, *rhs, *expected);
+
+  kernels.square_multiply_kernel<Size>()(*lhs, *rhs, *result);
+
+  EXPECT_TRUE(*result == *expected);
+}
+
+// The multiplies that the benchmarks run.
+TEST_P(SquareMultiplyTest, BenchmarkSizes) {
+  // Keep in sync with kSquareMatrixSizes.
+  ExpectSquareMultiply<16>(kernels());
+  ExpectSquareMultiply<32>(kernels());
+  ExpectSquareMultiply<64>(kernels());
+  ExpectSquareMultiply<128>(kernels());
+  ExpectSquareMultiply<256>(kernels());
+  ExpectSquareMultiply<512>(kernels());
+}
+
+INSTANTIATE_KERNELS_TEST_SUITE(SquareMultiplyTest);
+
+}  // namespace
+}  // namespace samples::vectorization
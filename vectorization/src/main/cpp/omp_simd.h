@@ -18,10 +18,91 @@
 
 #include <stdint.h>
 
+#include <array>
+
+#include "blocked_multiply.h"
 #include "matrix.h"
 
 namespace samples::vectorization {
 
+/**
+ * Computes C += A * B for one tile of BlockedMultiply using OpenMP SIMD.
+ *
+ * See BlockedMultiply for the meaning of each argument.
+ *
+ * @tparam T The type of each operand cell.
+ * @tparam M The column stride of a and c.
+ * @tparam N The column stride of b.
+ * @tparam Acc The type of each result cell.
+ */
+template <typename T, size_t M, size_t N, typename Acc = T>
+[[clang::always_inline]] void OpenMPMicroKernel(const T* _Nonnull a,
+                                                const T* _Nonnull b,
+                                                Acc* _Nonnull c, size_t depth) {
+  Acc accumulator[kMicroTileColumns][kMicroTileRows];
+  for (auto column = 0U; column < kMicroTileColumns; column++) {
+#pragma omp simd
+    for (auto row = 0U; row < kMicroTileRows; row++) {
+      accumulator[column][row] = c[column * M + row];
+    }
+  }
+  for (size_t k = 0; k < depth; k++) {
+    for (auto column = 0U; column < kMicroTileColumns; column++) {
+      const Acc scalar = b[column * N + k];
+#pragma omp simd
+      for (auto row = 0U; row < kMicroTileRows; row++) {
+        accumulator[column][row] += static_cast<Acc>(a[k * M + row]) * scalar;
+      }
+    }
+  }
+  for (auto column = 0U; column < kMicroTileColumns; column++) {
+#pragma omp simd
+    for (auto row = 0U; row < kMicroTileRows; row++) {
+      c[column * M + row] = accumulator[column][row];
+    }
+  }
+}
+
+/**
+ * Multiplies two compatible matrices, writing the result to an existing
+ * matrix.
+ *
+ * @tparam T The type of each operand cell.
+ * @tparam Acc The type of each result cell, which may be wider than T. See
+ * BlockedMultiply.
+ * @tparam M The number of rows in the left operand and the result.
+ * @tparam N The number of columns in the left operand, and the rows in the
+ * right operand.
+ * @tparam P The number of columns in the right operand and the result.
+ * @param lhs The left operand.
+ * @param rhs The right operand.
+ * @param result The destination for lhs * rhs. Must not be either operand.
+ */
+template <typename T, typename Acc, size_t M, size_t N, size_t P>
+[[clang::always_inline]] void MultiplyWithOpenMP(const Matrix<M, N, T>& lhs,
+                                                 const Matrix<N, P, T>& rhs,
+                                                 Matrix<M, P, Acc>& result) {
+  if constexpr (kUseBlockedMultiply<M, N, P>) {
+    BlockedMultiply<T, M, N, P>(lhs.data(), rhs.data(), result.data(),
+                                OpenMPMicroKernel<T, M, N, Acc>);
+  } else {
+    result = Matrix<M, P, Acc>();
+#pragma omp simd
+    for (auto result_column_index = 0U; result_column_index < P;
+         result_column_index++) {
+      for (auto lhs_column_index = 0U; lhs_column_index < N;
+           lhs_column_index++) {
+        auto lhs_column = lhs.column(lhs_column_index);
+        const Acc scalar = rhs[lhs_column_index, result_column_index];
+        for (auto row = 0U; row < lhs_column.size(); row++) {
+          result[row, result_column_index] +=
+              static_cast<Acc>(lhs_column[row]) * scalar;
+        }
+      }
+    }
+  }
+}
+
 /**
  * Multiplies two compatible matrices and returns the result.
  *
@@ -38,18 +119,226 @@ template <typename T, size_t M, size_t N, size_t P>
 Matrix<M, P, T> MultiplyWithOpenMP(const Matrix<M, N, T>& lhs,
                                    const Matrix<N, P, T>& rhs) {
   Matrix<M, P, T> result;
+  MultiplyWithOpenMP(lhs, rhs, result);
+  return result;
+}
+
+/**
+ * Transforms each point in a batch by a matrix, writing the results to out.
+ *
+ * @tparam T The type of each matrix cell.
+ * @param m The transform to apply.
+ * @param in The points to transform.
+ * @param out The destination for the transformed points. Must be the same size
+ * as in. May be the same buffers as in.
+ */
+template <typename T>
+[[clang::always_inline]] void TransformPointsWithOpenMP(const Mat4<T>& m,
+                                                        PointSpan<const T> in,
+                                                        PointSpan<T> out) {
+  DCHECK(in.IsValid());
+  DCHECK(out.IsValid());
+  DCHECK_EQ(in.size(), out.size());
+
+  const Mat4<T> local_m = m;
+  const T* _Nonnull in_x = in.x.data();
+  const T* _Nonnull in_y = in.y.data();
+  const T* _Nonnull in_z = in.z.data();
+  const T* _Nonnull in_w = in.w.data();
+  T* _Nonnull out_x = out.x.data();
+  T* _Nonnull out_y = out.y.data();
+  T* _Nonnull out_z = out.z.data();
+  T* _Nonnull out_w = out.w.data();
+
+  // Unlike the other implementations, the simd directive tells Clang to
+  // vectorize the loop without first proving that the outputs don't overlap the
+  // inputs. That's still correct for the in-place case because each iteration
+  // reads everything it needs before it writes.
 #pragma omp simd
-  for (auto result_column_index = 0U; result_column_index < P;
-       result_column_index++) {
-    for (auto lhs_column_index = 0U; lhs_column_index < N; lhs_column_index++) {
-      auto lhs_column = lhs.column(lhs_column_index);
-      const T& scalar = rhs[lhs_column_index, result_column_index];
-      for (auto row = 0U; row < lhs_column.size(); row++) {
-        result[row, result_column_index] += lhs_column[row] * scalar;
-      }
-    }
+  for (size_t i = 0; i < in.size(); i++) {
+    const T x = in_x[i];
+    const T y = in_y[i];
+    const T z = in_z[i];
+    const T w = in_w[i];
+    out_x[i] = local_m[0, 0] * x + local_m[0, 1] * y + local_m[0, 2] * z +
+               local_m[0, 3] * w;
+    out_y[i] = local_m[1, 0] * x + local_m[1, 1] * y + local_m[1, 2] * z +
+               local_m[1, 3] * w;
+    out_z[i] = local_m[2, 0] * x + local_m[2, 1] * y + local_m[2, 2] * z +
+               local_m[2, 3] * w;
+    out_w[i] = local_m[3, 0] * x + local_m[3, 1] * y + local_m[3, 2] * z +
+               local_m[3, 3] * w;
+  }
+}
+
+/**
+ * Returns the first three cells of column j of m.
+ */
+template <typename T, size_t N>
+[[clang::always_inline]] std::array<T, 3> OpenMPColumn(const Matrix<N, N, T>& m,
+                                                       size_t j) {
+  std::array<T, 3> result;
+#pragma omp simd
+  for (auto i = 0U; i < 3; i++) {
+    result[i] = m[i, j];
   }
   return result;
 }
 
+/**
+ * Returns the cross product of two 3D vectors.
+ */
+template <typename T>
+[[clang::always_inline]] std::array<T, 3> OpenMPCross(
+    const std::array<T, 3>& a, const std::array<T, 3>& b) {
+  std::array<T, 3> result;
+#pragma omp simd
+  for (auto i = 0U; i < 3; i++) {
+    const auto j = (i + 1) % 3;
+    const auto k = (i + 2) % 3;
+    result[i] = a[j] * b[k] - a[k] * b[j];
+  }
+  return result;
+}
+
+/**
+ * Returns the dot product of two 3D vectors.
+ */
+template <typename T>
+[[clang::always_inline]] T OpenMPDot(const std::array<T, 3>& a,
+                                     const std::array<T, 3>& b) {
+  T sum = {};
+#pragma omp simd reduction(+ : sum)
+  for (auto i = 0U; i < 3; i++) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+/**
+ * Transposes a 3x3 or 4x4 matrix using OpenMP SIMD.
+ *
+ * @tparam T The type of each matrix cell.
+ * @tparam N The number of rows and columns in m.
+ * @param m The matrix to transpose.
+ * @param result The destination for the transpose of m. Must not be m.
+ */
+template <typename T, size_t N>
+  requires(N == 3 || N == 4)
+[[clang::always_inline]] void TransposeWithOpenMP(
+    const Matrix<N, N, T>& m, Matrix<N, N, T>& result) {
+  for (auto row = 0U; row < N; row++) {
+#pragma omp simd
+    for (auto column = 0U; column < N; column++) {
+      result[column, row] = m[row, column];
+    }
+  }
+}
+
+/**
+ * Computes the determinant of a 3x3 or 4x4 matrix using OpenMP SIMD.
+ *
+ * See InverseWithClangMatrices for the algorithm.
+ *
+ * @tparam T The type of each matrix cell.
+ * @tparam N The number of rows and columns in m.
+ * @param m The matrix.
+ * @return The determinant of m.
+ */
+template <typename T, size_t N>
+  requires(N == 3 || N == 4)
+[[clang::always_inline]] T DeterminantWithOpenMP(const Matrix<N, N, T>& m) {
+  const auto a = OpenMPColumn(m, 0);
+  const auto b = OpenMPColumn(m, 1);
+  const auto c = OpenMPColumn(m, 2);
+  if constexpr (N == 3) {
+    return OpenMPDot(a, OpenMPCross(b, c));
+  } else {
+    const auto d = OpenMPColumn(m, 3);
+    std::array<T, 3> u;
+    std::array<T, 3> v;
+#pragma omp simd
+    for (auto i = 0U; i < 3; i++) {
+      u[i] = a[i] * m[3, 1] - b[i] * m[3, 0];
+      v[i] = c[i] * m[3, 3] - d[i] * m[3, 2];
+    }
+    return OpenMPDot(OpenMPCross(a, b), v) +
+           OpenMPDot(OpenMPCross(c, d), u);
+  }
+}
+
+/**
+ * Inverts a 3x3 or 4x4 matrix using OpenMP SIMD.
+ *
+ * See InverseWithClangMatrices for the algorithm.
+ * This is the same code as InverseWithAutoVectorization, with each loop
+ * annotated.
+ *
+ * @tparam T The type of each matrix cell.
+ * @tparam N The number of rows and columns in m.
+ * @param m The matrix to invert. Must be invertible; otherwise the result is
+ * infinite or NaN.
+ * @param result The destination for the inverse of m. Must not be m.
+ */
+template <typename T, size_t N>
+  requires(N == 3 || N == 4)
+[[clang::always_inline]] void InverseWithOpenMP(
+    const Matrix<N, N, T>& m, Matrix<N, N, T>& result) {
+  const auto a = OpenMPColumn(m, 0);
+  const auto b = OpenMPColumn(m, 1);
+  const auto c = OpenMPColumn(m, 2);
+  if constexpr (N == 3) {
+    const auto bc = OpenMPCross(b, c);
+    const auto ca = OpenMPCross(c, a);
+    const auto ab = OpenMPCross(a, b);
+    const T inv_det = 1 / OpenMPDot(a, bc);
+#pragma omp simd
+    for (auto i = 0U; i < 3; i++) {
+      result[0, i] = bc[i] * inv_det;
+      result[1, i] = ca[i] * inv_det;
+      result[2, i] = ab[i] * inv_det;
+    }
+  } else {
+    const auto d = OpenMPColumn(m, 3);
+    const T x = m[3, 0];
+    const T y = m[3, 1];
+    const T z = m[3, 2];
+    const T w = m[3, 3];
+
+    auto s = OpenMPCross(a, b);
+    auto t = OpenMPCross(c, d);
+    std::array<T, 3> u;
+    std::array<T, 3> v;
+#pragma omp simd
+    for (auto i = 0U; i < 3; i++) {
+      u[i] = a[i] * y - b[i] * x;
+      v[i] = c[i] * w - d[i] * z;
+    }
+    const T inv_det = 1 / (OpenMPDot(s, v) + OpenMPDot(t, u));
+#pragma omp simd
+    for (auto i = 0U; i < 3; i++) {
+      s[i] *= inv_det;
+      t[i] *= inv_det;
+      u[i] *= inv_det;
+      v[i] *= inv_det;
+    }
+
+    const auto bv = OpenMPCross(b, v);
+    const auto va = OpenMPCross(v, a);
+    const auto du = OpenMPCross(d, u);
+    const auto uc = OpenMPCross(u, c);
+#pragma omp simd
+    for (auto i = 0U; i < 3; i++) {
+      result[0, i] = bv[i] + t[i] * y;
+      result[1, i] = va[i] - t[i] * x;
+      result[2, i] = du[i] + s[i] * w;
+      result[3, i] = uc[i] - s[i] * z;
+    }
+    result[0, 3] = -OpenMPDot(b, t);
+    result[1, 3] = OpenMPDot(a, t);
+    result[2, 3] = -OpenMPDot(d, s);
+    result[3, 3] = OpenMPDot(c, s);
+  }
+}
+
 }  // namespace samples::vectorization
@@ -0,0 +1,276 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "benchmark.h"
+#include "matrix.h"
+
+// The inputs of the benchmarks, shared with the unit tests that check the
+// kernels produce the right results for them.
+
+namespace samples::vectorization {
+
+/**
+ * Fills the operands of a square matrix multiply benchmark.
+ *
+ * Every value here is a small integer, so the results are exact regardless of
+ * the order of operations used by the implementation.
+ */
+template <size_t Size>
+void InitSquareOperands(Matrix<Size, Size>& lhs, Matrix<Size, Size>& rhs) {
+  for (auto row = 0U; row < Size; row++) {
+    for (auto column = 0U; column < Size; column++) {
+      lhs[row, column] = static_cast<float>((row * 7 + column * 3) % 5);
+      rhs[row, column] = static_cast<float>((row * 5 + column * 11) % 7);
+    }
+  }
+}
+
+/**
+ * Computes the product that a matrix multiply benchmark should produce.
+ *
+ * @param result The destination for lhs * rhs. Must be zero.
+ */
+template <size_t M, size_t N, size_t P>
+void ReferenceMultiply(const Matrix<M, N>& lhs, const Matrix<N, P>& rhs,
+                       Matrix<M, P>& result) {
+  for (auto column = 0U; column < P; column++) {
+    for (auto k = 0U; k < N; k++) {
+      const float scalar = rhs[k, column];
+      for (auto row = 0U; row < M; row++) {
+        result[row, column] += lhs[row, k] * scalar;
+      }
+    }
+  }
+}
+
+/**
+ * Fills the operands of a reduced precision multiply benchmark with values in
+ * [-1, 1].
+ *
+ * Unlike InitSquareOperands, most of these values can't be represented exactly
+ * in every Precision, so the result of the multiply depends on how well the
+ * precision approximates them.
+ */
+template <size_t Size>
+void InitPrecisionOperands(Matrix<Size, Size>& lhs, Matrix<Size, Size>& rhs) {
+  for (auto row = 0U; row < Size; row++) {
+    for (auto column = 0U; column < Size; column++) {
+      lhs[row, column] =
+          static_cast<float>((row * 37 + column * 11) % 201) / 100.0f - 1.0f;
+      rhs[row, column] =
+          static_cast<float>((row * 13 + column * 29) % 199) / 99.0f - 1.0f;
+    }
+  }
+}
+
+/**
+ * Computes lhs * rhs in double precision, which for these sizes and values is
+ * close enough to exact to measure the error of every Precision against.
+ *
+ * @return The product, in column-major order.
+ */
+template <size_t Size>
+std::vector<double> ExactMultiply(const Matrix<Size, Size>& lhs,
+                                  const Matrix<Size, Size>& rhs) {
+  std::vector<double> result(Size * Size);
+  for (auto column = 0U; column < Size; column++) {
+    for (auto k = 0U; k < Size; k++) {
+      const double scalar = rhs[k, column];
+      for (auto row = 0U; row < Size; row++) {
+        result[column * Size + row] += lhs[row, k] * scalar;
+      }
+    }
+  }
+  return result;
+}
+
+/**
+ * Converts a float matrix to another number format.
+ *
+ * Integer formats are quantized symmetrically with a single scale chosen so
+ * that the largest magnitude in m maps to the largest value of T.
+ *
+ * @param m The matrix to convert.
+ * @param result The destination for the converted matrix.
+ * @return The scale that each cell of result must be multiplied by to
+ * approximate the same cell of m. Always 1 for floating point formats.
+ */
+template <typename T, size_t Size>
+float Quantize(const Matrix<Size, Size>& m, Matrix<Size, Size, T>& result) {
+  const std::span<const float> cells(m.data(), Size * Size);
+  float scale = 1.0f;
+  if constexpr (std::is_integral_v<T>) {
+    float max_magnitude = 0;
+    for (float cell : cells) {
+      max_magnitude = std::max(max_magnitude, std::abs(cell));
+    }
+    if (max_magnitude > 0) {
+      scale = max_magnitude / std::numeric_limits<T>::max();
+    }
+  }
+  for (size_t i = 0; i < cells.size(); i++) {
+    if constexpr (std::is_integral_v<T>) {
+      result.data()[i] = static_cast<T>(std::lround(cells[i] / scale));
+    } else {
+      result.data()[i] = static_cast<T>(cells[i]);
+    }
+  }
+  return scale;
+}
+
+/**
+ * Computes PrecisionBenchmarkStats::max_error.
+ *
+ * @param result The product to check.
+ * @param scale The scale that each cell of result must be multiplied by to
+ * convert it back to float.
+ * @param expected The exact product, as returned by ExactMultiply.
+ */
+template <typename T, size_t Size>
+double MaxError(const Matrix<Size, Size, T>& result, float scale,
+                std::span<const double> expected) {
+  double max_error = 0;
+  double max_magnitude = 0;
+  for (size_t i = 0; i < expected.size(); i++) {
+    const double actual =
+        static_cast<double>(static_cast<float>(result.data()[i]) * scale);
+    max_error = std::max(max_error, std::abs(actual - expected[i]));
+    max_magnitude = std::max(max_magnitude, std::abs(expected[i]));
+  }
+  return max_magnitude > 0 ? max_error / max_magnitude : max_error;
+}
+
+/**
+ * Returns the inputs of a matrix operation benchmark.
+ *
+ * Every matrix is different, and each is strictly diagonally dominant, so it
+ * is invertible and well conditioned.
+ */
+template <size_t Size>
+std::vector<Matrix<Size, Size>> MakeOperationInputs() {
+  std::vector<Matrix<Size, Size>> matrices(kMatrixOperationBatchSize);
+  for (size_t i = 0; i < matrices.size(); i++) {
+    for (auto row = 0U; row < Size; row++) {
+      for (auto column = 0U; column < Size; column++) {
+        matrices[i][row, column] =
+            row == column
+                ? 8.0f + static_cast<float>(i % 5)
+                : static_cast<float>((i + row * 3 + column * 7) % 5) - 2.0f;
+      }
+    }
+  }
+  return matrices;
+}
+
+/**
+ * The inputs of BenchmarkMvpTransform.
+ *
+ * Every value is a small integer, so every order of evaluation gives exactly
+ * the same result.
+ */
+struct MvpInputs {
+  Mat4<> projection;
+  Mat4<> view;
+  std::vector<Mat4<>> models;
+  std::vector<Vec4<>> vertices;
+};
+
+inline MvpInputs MakeMvpInputs() {
+  MvpInputs inputs{
+      .projection = Mat4<>{{
+          {2.0f, 0.0f, 0.0f, 0.0f},
+          {0.0f, 3.0f, 0.0f, 0.0f},
+          {0.0f, 0.0f, -1.0f, -2.0f},
+          {0.0f, 0.0f, -1.0f, 0.0f},
+      }},
+      .view = Mat4<>{{
+          {1.0f, 0.0f, 0.0f, -4.0f},
+          {0.0f, 0.0f, 1.0f, -2.0f},
+          {0.0f, -1.0f, 0.0f, -8.0f},
+          {0.0f, 0.0f, 0.0f, 1.0f},
+      }},
+      .models = std::vector<Mat4<>>(kMvpBatchSize),
+      .vertices = std::vector<Vec4<>>(kMvpBatchSize),
+  };
+  for (size_t i = 0; i < kMvpBatchSize; i++) {
+    const auto offset = static_cast<float>(i % 16);
+    const auto scale = static_cast<float>(i % 3 + 1);
+    inputs.models[i] = Mat4<>{{
+        {scale, 0.0f, 0.0f, offset},
+        {0.0f, scale, 0.0f, -offset},
+        {0.0f, 0.0f, scale, 1.0f},
+        {0.0f, 0.0f, 0.0f, 1.0f},
+    }};
+    inputs.vertices[i] = Vec4<>{{static_cast<float>(i % 7), 1.0f,
+                                 static_cast<float>(i % 5) - 2.0f, 1.0f}};
+  }
+  return inputs;
+}
+
+/**
+ * Owns the storage for a batch of points stored as a structure of arrays.
+ */
+class PointBuffer {
+ public:
+  explicit PointBuffer(size_t size) : x_(size), y_(size), z_(size), w_(size) {}
+
+  PointSpan<const float> view() const { return {x_, y_, z_, w_}; }
+  PointSpan<float> view() { return {x_, y_, z_, w_}; }
+
+ private:
+  std::vector<float> x_;
+  std::vector<float> y_;
+  std::vector<float> z_;
+  std::vector<float> w_;
+};
+
+/// Returns the transform applied by the transform benchmarks.
+inline Mat4<> Translation() {
+  return Mat4<>{{
+      {1.0f, 0.0f, 0.0f, 10.0f},
+      {0.0f, 1.0f, 0.0f, 0.0f},
+      {0.0f, 0.0f, 1.0f, 0.0f},
+      {0.0f, 0.0f, 0.0f, 1.0f},
+  }};
+}
+
+/**
+ * Fills the input of a transform benchmark.
+ *
+ * Every value here is a small integer, so the results are exact regardless of
+ * the order of operations used by the implementation.
+ */
+inline void InitPoints(PointSpan<float> points) {
+  for (size_t i = 0; i < points.size(); i++) {
+    points.x[i] = static_cast<float>(i);
+    points.y[i] = static_cast<float>(i % 1024);
+    points.z[i] = static_cast<float>(i % 16);
+    points.w[i] = 1.0f;
+  }
+}
+
+}  // namespace samples::vectorization
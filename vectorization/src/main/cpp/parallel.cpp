@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "parallel.h"
+
+#include <base/logging.h>
+
+#include <algorithm>
+
+namespace samples::vectorization {
+
+std::string_view ThreadingName(Threading threading) {
+  switch (threading) {
+    case Threading::kOpenMp:
+      return "openmp";
+    case Threading::kThreadPool:
+      return "thread_pool";
+    default:
+      return "unknown";
+  }
+}
+
+ThreadPool::ThreadPool(size_t threads) {
+  CHECK_GT(threads, 0U);
+  workers_.reserve(threads - 1);
+  for (size_t i = 1; i < threads; i++) {
+    workers_.emplace_back(&ThreadPool::WorkerMain, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  start_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::Run(const std::function<void(size_t)>& task) {
+  {
+    std::lock_guard lock(mutex_);
+    task_ = &task;
+    pending_ = workers_.size();
+    generation_++;
+  }
+  start_.notify_all();
+
+  task(0);
+
+  std::unique_lock lock(mutex_);
+  done_.wait(lock, [this] { return pending_ == 0; });
+  task_ = nullptr;
+}
+
+void ThreadPool::WorkerMain(size_t index) {
+  uint64_t last_generation = 0;
+  while (true) {
+    const std::function<void(size_t)>* task;
+    {
+      std::unique_lock lock(mutex_);
+      start_.wait(lock, [&] {
+        return stopping_ || generation_ != last_generation;
+      });
+      if (stopping_) {
+        return;
+      }
+      last_generation = generation_;
+      task = task_;
+    }
+
+    (*task)(index);
+
+    std::lock_guard lock(mutex_);
+    if (--pending_ == 0) {
+      done_.notify_one();
+    }
+  }
+}
+
+void RunWithOpenMp(size_t threads, const std::function<void(size_t)>& task) {
+  const int count = static_cast<int>(threads);
+#pragma omp parallel for num_threads(count) schedule(static, 1)
+  for (int i = 0; i < count; i++) {
+    task(static_cast<size_t>(i));
+  }
+}
+
+ParallelRunner::ParallelRunner(Threading threading, size_t threads)
+    : threads_(threads) {
+  CHECK_GT(threads, 0U);
+  if (threading == Threading::kThreadPool) {
+    pool_.emplace(threads_);
+  }
+}
+
+void ParallelRunner::Run(const std::function<void(size_t)>& task) {
+  if (pool_.has_value()) {
+    pool_->Run(task);
+  } else {
+    RunWithOpenMp(threads_, task);
+  }
+}
+
+std::pair<size_t, size_t> Partition(size_t total, size_t threads,
+                                    size_t thread, size_t granularity) {
+  const size_t units = (total + granularity - 1) / granularity;
+  const size_t begin = units * thread / threads * granularity;
+  const size_t end = units * (thread + 1) / threads * granularity;
+  return {std::min(begin, total), std::min(end, total)};
+}
+
+}  // namespace samples::vectorization
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <base/macros.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace samples::vectorization {
+
+/**
+ * How a parallel benchmark runs its work on multiple threads.
+ */
+enum class Threading : uint8_t {
+  /// An OpenMP parallel for loop.
+  kOpenMp = 0,
+
+  /// A ThreadPool.
+  kThreadPool = 1,
+};
+
+/// Every Threading, in order.
+inline constexpr std::array<Threading, 2> kThreadings = {
+    Threading::kOpenMp,
+    Threading::kThreadPool,
+};
+
+/**
+ * Returns a short, stable name for the threading model, suitable for machine
+ * readable output.
+ */
+[[nodiscard]] std::string_view ThreadingName(Threading threading);
+
+/**
+ * A fixed set of threads that run one task each, all at the same time.
+ *
+ * This is deliberately the simplest pool that works: there's no queue, just a
+ * task that every thread runs with its own index. That's all the benchmarks
+ * need to split a workload evenly, and it keeps the pool's own overhead
+ * comparable to OpenMP's.
+ */
+class ThreadPool {
+ public:
+  /**
+   * Starts the pool.
+   *
+   * @param threads The number of threads that run each task, including the
+   * thread that calls Run. Must be at least 1.
+   */
+  explicit ThreadPool(size_t threads);
+
+  /// Stops and joins every thread.
+  ~ThreadPool();
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadPool);
+
+  /// The number of threads that run each task, including the caller.
+  [[nodiscard]] size_t size() const { return workers_.size() + 1; }
+
+  /**
+   * Calls task(i) for every i in [0, size()), each on a different thread, and
+   * returns once all of them have finished. The calling thread runs task(0).
+   */
+  void Run(const std::function<void(size_t)>& task);
+
+ private:
+  void WorkerMain(size_t index);
+
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  const std::function<void(size_t)>* task_ = nullptr;
+  uint64_t generation_ = 0;
+  size_t pending_ = 0;
+  bool stopping_ = false;
+  std::vector<std::thread> workers_;
+};
+
+/**
+ * Calls task(i) for every i in [0, threads) in an OpenMP parallel for loop,
+ * and returns once all of them have finished.
+ */
+void RunWithOpenMp(size_t threads, const std::function<void(size_t)>& task);
+
+/**
+ * Runs a task on every thread of a parallel benchmark, with either OpenMP or a
+ * ThreadPool.
+ */
+class ParallelRunner {
+ public:
+  /**
+   * @param threading How the threads are run.
+   * @param threads The number of threads, including the calling thread. Must
+   * be at least 1.
+   */
+  ParallelRunner(Threading threading, size_t threads);
+
+  [[nodiscard]] size_t threads() const { return threads_; }
+
+  /// Calls task(i) for every thread i, and waits for all of them to finish.
+  void Run(const std::function<void(size_t)>& task);
+
+ private:
+  size_t threads_;
+  std::optional<ThreadPool> pool_;
+};
+
+/**
+ * Returns the range [begin, end) of [0, total) that the given thread should
+ * handle when work is split evenly between threads.
+ *
+ * The boundaries are multiples of granularity, so each thread works on whole
+ * vectors or tiles. Some threads get nothing if there isn't enough work.
+ */
+[[nodiscard]] std::pair<size_t, size_t> Partition(size_t total, size_t threads,
+                                                  size_t thread,
+                                                  size_t granularity);
+
+}  // namespace samples::vectorization
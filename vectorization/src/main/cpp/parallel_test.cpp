@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "parallel.h"
+
+#include <stddef.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "blocked_multiply.h"
+#include "gtest/gtest.h"
+#include "kernels_test.h"
+#include "matrix.h"
+#include "operands.h"
+
+namespace samples::vectorization {
+namespace {
+
+// The partitions of every thread must cover the whole range, in order, with
+// boundaries on multiples of the granularity.
+TEST(PartitionTest, CoversRange) {
+  for (size_t total : {0, 1, 7, 64, 100, 512}) {
+    for (size_t threads : {1, 2, 3, 8, 200}) {
+      SCOPED_TRACE(testing::Message() << total << " over " << threads);
+      size_t next = 0;
+      for (size_t thread = 0; thread < threads; thread++) {
+        auto [begin, end] = Partition(total, threads, thread, 4);
+        ASSERT_EQ(begin, next);
+        ASSERT_LE(begin, end);
+        if (end != total) {
+          ASSERT_EQ(end % 4, 0U);
+        }
+        next = end;
+      }
+      ASSERT_EQ(next, total);
+    }
+  }
+}
+
+class ParallelRunnerTest : public testing::TestWithParam<Threading> {};
+
+TEST_P(ParallelRunnerTest, RunsEachThreadOnce) {
+  constexpr size_t kThreads = 4;
+  ParallelRunner runner(GetParam(), kThreads);
+  std::vector<std::atomic<int>> calls(kThreads);
+  for (int i = 0; i < 3; i++) {
+    runner.Run([&](size_t thread) { calls.at(thread)++; });
+  }
+  for (size_t thread = 0; thread < kThreads; thread++) {
+    EXPECT_EQ(calls[thread].load(), 3) << "thread " << thread;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(AllThreadings, ParallelRunnerTest,
+                         testing::ValuesIn(kThreadings),
+                         [](const testing::TestParamInfo<Threading>& info) {
+                           return std::string(ThreadingName(info.param));
+                         });
+
+using ParallelKernelsTest = KernelsTest;
+
+// As BenchmarkParallelSquareMatrixMultiplication does with strong scaling,
+// split the columns of one multiply between threads. 3 threads don't divide
+// the columns evenly.
+TEST_P(ParallelKernelsTest, SquareMultiplyColumns) {
+  constexpr size_t kSize = 128;
+  auto lhs = std::make_unique<Matrix<kSize, kSize>>();
+  auto rhs = std::make_unique<Matrix<kSize, kSize>>();
+  auto expected = std::make_unique<Matrix<kSize, kSize>>();
+  InitSquareOperands(*lhs, *rhs);
+  ReferenceMultiply(*lhs, *rhs, *expected);
+
+  const auto multiply = kernels().square_multiply_columns_kernel<kSize>();
+  for (Threading threading : kThreadings) {
+    SCOPED_TRACE(ThreadingName(threading));
+    auto result = std::make_unique<Matrix<kSize, kSize>>();
+    ParallelRunner runner(threading, 3);
+    runner.Run([&](size_t thread) {
+      auto [first, last] =
+          Partition(kSize, runner.threads(), thread, kMicroTileColumns);
+      if (first < last) {
+        multiply(*lhs, *rhs, *result, first, last);
+      }
+    });
+
+    EXPECT_TRUE(*result == *expected);
+  }
+}
+
+// As BenchmarkParallelTransformPoints does with strong scaling, split one
+// batch between threads. The batch isn't a multiple of the partitions'
+// granularity, so the last thread gets a partial one.
+TEST_P(ParallelKernelsTest, TransformPoints) {
+  constexpr size_t kBatchSize = 1000;
+  constexpr size_t kGranularity = 64 / sizeof(float);
+  const Mat4<> translation = Translation();
+  PointBuffer input(kBatchSize);
+  InitPoints(input.view());
+
+  for (Threading threading : kThreadings) {
+    SCOPED_TRACE(ThreadingName(threading));
+    PointBuffer output(kBatchSize);
+    ParallelRunner runner(threading, 3);
+    runner.Run([&](size_t thread) {
+      auto [begin, end] =
+          Partition(kBatchSize, runner.threads(), thread, kGranularity);
+      if (begin < end) {
+        kernels().transform_points(
+            translation, input.view().subspan(begin, end - begin),
+            output.view().subspan(begin, end - begin));
+      }
+    });
+
+    for (size_t i = 0; i < kBatchSize; i++) {
+      ASSERT_EQ(output.view().x[i], input.view().x[i] + 10.0f) << i;
+      ASSERT_EQ(output.view().y[i], input.view().y[i]) << i;
+      ASSERT_EQ(output.view().z[i], input.view().z[i]) << i;
+      ASSERT_EQ(output.view().w[i], input.view().w[i]) << i;
+    }
+  }
+}
+
+INSTANTIATE_KERNELS_TEST_SUITE(ParallelKernelsTest);
+
+}  // namespace
+}  // namespace samples::vectorization
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "perf_counters.h"
+
+#include <base/logging.h>
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace samples::vectorization {
+
+namespace {
+
+// The layout of the value read from a counter opened with the read_format used
+// by OpenCounter.
+struct CounterReading {
+  uint64_t value;
+  uint64_t time_enabled;
+  uint64_t time_running;
+};
+
+int OpenCounter(uint32_t type, uint64_t config) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  // There's no libc wrapper for perf_event_open. This counts events for the
+  // calling thread (pid 0) on whichever CPU it runs on (cpu -1).
+  int fd = static_cast<int>(
+      syscall(__NR_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+  if (fd == -1) {
+    PLOG(DEBUG) << "perf_event_open(" << type << ", " << config << ") failed";
+  }
+  return fd;
+}
+
+std::optional<double> ReadCounter(int fd) {
+  if (fd == -1) {
+    return std::nullopt;
+  }
+
+  CounterReading reading;
+  if (read(fd, &reading, sizeof(reading)) != sizeof(reading)) {
+    PLOG(WARNING) << "could not read perf counter";
+    return std::nullopt;
+  }
+  if (reading.time_running == 0) {
+    // The counter never got scheduled on the PMU, so we know nothing.
+    return std::nullopt;
+  }
+  return static_cast<double>(reading.value) *
+         static_cast<double>(reading.time_enabled) /
+         static_cast<double>(reading.time_running);
+}
+
+std::optional<double> Divide(std::optional<double> value, double divisor) {
+  if (!value.has_value()) {
+    return std::nullopt;
+  }
+  return *value / divisor;
+}
+
+}  // namespace
+
+CounterValues CounterValues::operator/(double divisor) const {
+  return {
+      .cycles = Divide(cycles, divisor),
+      .instructions = Divide(instructions, divisor),
+      .l1d_misses = Divide(l1d_misses, divisor),
+      .branch_misses = Divide(branch_misses, divisor),
+  };
+}
+
+PerfCounters::PerfCounters() {
+  fds_[kCycles] = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+  fds_[kInstructions] =
+      OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+  fds_[kL1dMisses] = OpenCounter(
+      PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                              (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+  fds_[kBranchMisses] =
+      OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+}
+
+PerfCounters::~PerfCounters() {
+  for (int fd : fds_) {
+    if (fd != -1) {
+      close(fd);
+    }
+  }
+}
+
+bool PerfCounters::available() const {
+  for (int fd : fds_) {
+    if (fd != -1) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void PerfCounters::Start() {
+  for (int fd : fds_) {
+    if (fd != -1) {
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+}
+
+void PerfCounters::Stop() {
+  for (int fd : fds_) {
+    if (fd != -1) {
+      ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+  }
+}
+
+CounterValues PerfCounters::Read() const {
+  return {
+      .cycles = ReadCounter(fds_[kCycles]),
+      .instructions = ReadCounter(fds_[kInstructions]),
+      .l1d_misses = ReadCounter(fds_[kL1dMisses]),
+      .branch_misses = ReadCounter(fds_[kBranchMisses]),
+  };
+}
+
+}  // namespace samples::vectorization
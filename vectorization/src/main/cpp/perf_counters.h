@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <base/macros.h>
+
+#include <array>
+#include <optional>
+
+namespace samples::vectorization {
+
+/**
+ * Hardware counter totals. Each counter is only present if it could be opened.
+ */
+struct CounterValues {
+  std::optional<double> cycles;
+  std::optional<double> instructions;
+  std::optional<double> l1d_misses;
+  std::optional<double> branch_misses;
+
+  /// Instructions per cycle, if both counters are available.
+  [[nodiscard]] std::optional<double> ipc() const {
+    if (!cycles.has_value() || !instructions.has_value() || *cycles == 0) {
+      return std::nullopt;
+    }
+    return *instructions / *cycles;
+  }
+
+  /// Returns the values divided by divisor.
+  [[nodiscard]] CounterValues operator/(double divisor) const;
+};
+
+/**
+ * Counts hardware events for the calling thread using perf_event_open(2).
+ *
+ * The counters count user space events only, and only while started. Any
+ * counter that can't be opened is silently omitted, since availability varies
+ * a lot: emulators and some CPUs don't expose every event, and Android denies
+ * perf_event_open to apps entirely unless it has been enabled with
+ * `adb shell setprop security.perf_harden 0`. If none of them can be opened,
+ * available() returns false and Read() returns an empty CounterValues.
+ *
+ * Counters are opened independently rather than as a group, so one missing
+ * event doesn't prevent measuring the others. If the kernel has to multiplex
+ * them onto fewer hardware counters, the values are scaled to estimate the
+ * full count.
+ */
+class PerfCounters {
+ public:
+  PerfCounters();
+  ~PerfCounters();
+
+  DISALLOW_COPY_AND_ASSIGN(PerfCounters);
+
+  /// Whether any counter is available.
+  [[nodiscard]] bool available() const;
+
+  /// Starts (or resumes) counting.
+  void Start();
+
+  /// Pauses counting.
+  void Stop();
+
+  /// Returns the totals counted while started.
+  [[nodiscard]] CounterValues Read() const;
+
+ private:
+  enum Counter {
+    kCycles,
+    kInstructions,
+    kL1dMisses,
+    kBranchMisses,
+    kNumCounters,
+  };
+
+  std::array<int, kNumCounters> fds_;
+};
+
+}  // namespace samples::vectorization
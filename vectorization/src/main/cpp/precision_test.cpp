@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "benchmark.h"
+#include "cpu_variant.h"
+#include "dot_product.h"
+#include "gtest/gtest.h"
+#include "kernels.h"
+#include "kernels_test.h"
+#include "matrix.h"
+#include "operands.h"
+
+namespace samples::vectorization {
+namespace {
+
+using PrecisionTest = KernelsTest;
+
+/**
+ * The largest max_error accepted for each precision at any of
+ * kSquareMatrixSizes. These are a few times the worst error observed, so
+ * they only catch kernels that are broken, not ones that round differently.
+ */
+double MaxErrorTolerance(Precision precision) {
+  switch (precision) {
+    case Precision::kFloat32:
+      return 1e-5;
+    case Precision::kFloat16:
+      return 2e-2;
+    case Precision::kInt8:
+      return 2e-2;
+    default:
+      std::unreachable();
+  }
+}
+
+template <size_t Size, Precision precision>
+void ExpectAccurate(const Kernels& kernels) {
+  SCOPED_TRACE(testing::Message()
+               << PrecisionName(precision) << " " << Size << "x" << Size);
+  using Cell = PrecisionTraits<precision>::Cell;
+  using Accumulator = PrecisionTraits<precision>::Accumulator;
+
+  auto lhs = std::make_unique<Matrix<Size, Size>>();
+  auto rhs = std::make_unique<Matrix<Size, Size>>();
+  InitPrecisionOperands(*lhs, *rhs);
+  const std::vector<double> expected = ExactMultiply(*lhs, *rhs);
+
+  auto converted_lhs = std::make_unique<Matrix<Size, Size, Cell>>();
+  auto converted_rhs = std::make_unique<Matrix<Size, Size, Cell>>();
+  auto result = std::make_unique<Matrix<Size, Size, Accumulator>>();
+  const float lhs_scale = Quantize(*lhs, *converted_lhs);
+  const float rhs_scale = Quantize(*rhs, *converted_rhs);
+
+  kernels.square_multiply_kernel<Size, precision>()(*converted_lhs,
+                                                    *converted_rhs, *result);
+
+  EXPECT_LE(MaxError(*result, lhs_scale * rhs_scale, expected),
+            MaxErrorTolerance(precision));
+}
+
+template <Precision precision>
+void ExpectAccurateForEverySize(const Kernels& kernels) {
+  // Keep in sync with kSquareMatrixSizes.
+  ExpectAccurate<16, precision>(kernels);
+  ExpectAccurate<32, precision>(kernels);
+  ExpectAccurate<64, precision>(kernels);
+  ExpectAccurate<128, precision>(kernels);
+  ExpectAccurate<256, precision>(kernels);
+  ExpectAccurate<512, precision>(kernels);
+}
+
+// The multiplies that the precision benchmarks run.
+TEST_P(PrecisionTest, MaxError) {
+  ExpectAccurateForEverySize<Precision::kFloat32>(kernels());
+  ExpectAccurateForEverySize<Precision::kFloat16>(kernels());
+  ExpectAccurateForEverySize<Precision::kInt8>(kernels());
+}
+
+/// Fills an int8 matrix with values spanning the whole range of int8_t.
+template <size_t Rows, size_t Columns>
+void InitInt8Operand(Matrix<Rows, Columns, int8_t>& m, size_t seed) {
+  for (auto row = 0U; row < Rows; row++) {
+    for (auto column = 0U; column < Columns; column++) {
+      m[row, column] =
+          static_cast<int8_t>((row * 37 + column * 11 + seed) % 255) - 127;
+    }
+  }
+}
+
+/// Computes lhs * rhs exactly, in int32.
+template <size_t M, size_t N, size_t P>
+void ReferenceInt8Multiply(const Matrix<M, N, int8_t>& lhs,
+                           const Matrix<N, P, int8_t>& rhs,
+                           Matrix<M, P, int32_t>& result) {
+  for (auto column = 0U; column < P; column++) {
+    for (auto row = 0U; row < M; row++) {
+      int32_t sum = 0;
+      for (auto k = 0U; k < N; k++) {
+        sum += int32_t{lhs[row, k]} * int32_t{rhs[k, column]};
+      }
+      result[row, column] = sum;
+    }
+  }
+}
+
+template <size_t Size>
+void ExpectInt8Exact(const Kernels& kernels) {
+  SCOPED_TRACE(Size);
+  auto lhs = std::make_unique<Matrix<Size, Size, int8_t>>();
+  auto rhs = std::make_unique<Matrix<Size, Size, int8_t>>();
+  auto expected = std::make_unique<Matrix<Size, Size, int32_t>>();
+  auto result = std::make_unique<Matrix<Size, Size, int32_t>>();
+  InitInt8Operand(*lhs, 0);
+  InitInt8Operand(*rhs, 1);
+  ReferenceInt8Multiply(*lhs, *rhs, *expected);
+
+  kernels.square_multiply_kernel<Size, Precision::kInt8>()(*lhs, *rhs,
+                                                           *result);
+
+  EXPECT_TRUE(*result == *expected);
+}
+
+// Integer products are exact, so unlike MaxError this catches any mistake in
+// the int8 kernels, including in the dot product path.
+TEST_P(PrecisionTest, Int8IsExact) {
+  ExpectInt8Exact<16>(kernels());
+  ExpectInt8Exact<512>(kernels());
+}
+
+INSTANTIATE_KERNELS_TEST_SUITE(PrecisionTest);
+
+#if defined(__aarch64__)
+template <size_t M, size_t N, size_t P>
+[[gnu::target("dotprod")]] void DotProductMultiply(
+    const Matrix<M, N, int8_t>& lhs, const Matrix<N, P, int8_t>& rhs,
+    Matrix<M, P, int32_t>& result) {
+  MultiplyWithDotProduct(lhs, rhs, result);
+}
+
+template <size_t M, size_t N, size_t P>
+void ExpectDotProductExact() {
+  SCOPED_TRACE(testing::Message() << M << "x" << N << " * " << N << "x" << P);
+  Matrix<M, N, int8_t> lhs;
+  Matrix<N, P, int8_t> rhs;
+  Matrix<M, P, int32_t> expected;
+  Matrix<M, P, int32_t> result;
+  InitInt8Operand(lhs, 0);
+  InitInt8Operand(rhs, 1);
+  ReferenceInt8Multiply(lhs, rhs, expected);
+
+  DotProductMultiply(lhs, rhs, result);
+
+  EXPECT_TRUE(result == expected);
+}
+
+// Shapes that aren't a multiple of the tile or of SDOT's four values, which
+// the kernels never use but which MultiplyWithDotProduct supports.
+TEST(DotProductTest, PartialTiles) {
+  if (!IsSupported(CpuVariant::kArmv82)) {
+    GTEST_SKIP() << "The CPU has no dot product instructions";
+  }
+  ExpectDotProductExact<1, 1, 1>();
+  ExpectDotProductExact<9, 5, 3>();
+  ExpectDotProductExact<33, 70, 37>();
+}
+#endif
+
+}  // namespace
+}  // namespace samples::vectorization
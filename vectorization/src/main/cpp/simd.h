@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include <type_traits>
+#include <utility>
+
+#if __NDK_MAJOR__ >= 29
+#error check if std::simd works yet
+#endif
+
+/**
+ * A small stand-in for std::simd, built on Clang's generic vector types.
+ *
+ * The libc++ in NDK r27 has only a skeleton implementation of std::simd. Some
+ * things we can do without, but it doesn't actually have operator*, which is
+ * sort of essential :) This namespace implements the subset of the
+ * std::experimental::simd API (see
+ * https://en.cppreference.com/w/cpp/experimental/simd) that the kCxxSimd
+ * backend needs, with the same names and semantics, so that code written
+ * against it can be moved to the real thing by changing the namespace.
+ *
+ * Not provided: masks, where expressions, ABI tags other than fixed_size,
+ * vector_aligned loads and stores, and most of the math library. There are no
+ * shuffles in std::simd either; use the generator constructor, which Clang
+ * turns into a shuffle when the indices are constants.
+ */
+namespace samples::vectorization::simd {
+
+/// Tag for loads and stores that only require the alignment of T.
+struct element_aligned_tag {};
+inline constexpr element_aligned_tag element_aligned{};
+
+/**
+ * A fixed number of values of type T, operated on in parallel.
+ *
+ * @tparam T The type of each element.
+ * @tparam N The number of elements. Must be a power of two.
+ */
+template <typename T, size_t N>
+class fixed_size_simd {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "N must be a power of two");
+
+ public:
+  using value_type = T;
+
+  /// The number of elements.
+  [[nodiscard]] static constexpr size_t size() { return N; }
+
+  /// Initializes every element to zero.
+  constexpr fixed_size_simd() = default;
+
+  /// Initializes every element to value. Implicit, as in std::simd, so that
+  /// scalars can be used directly in arithmetic with vectors.
+  constexpr fixed_size_simd(T value) : v_(Vector{} + value) {}
+
+  /// Initializes element i to gen(std::integral_constant<size_t, i>()).
+  template <typename G>
+    requires std::is_invocable_r_v<T, G, std::integral_constant<size_t, 0>>
+  explicit fixed_size_simd(G&& gen) {
+    [&]<size_t... I>(std::index_sequence<I...>) {
+      ((v_[I] = static_cast<T>(gen(std::integral_constant<size_t, I>()))),
+       ...);
+    }(std::make_index_sequence<N>());
+  }
+
+  /// Converts each element of other to T, as if by static_cast. Unlike in
+  /// std::simd, this is explicit even when the conversion is value-preserving.
+  template <typename U>
+    requires(!std::is_same_v<U, T>)
+  explicit fixed_size_simd(const fixed_size_simd<U, N>& other)
+      : v_(__builtin_convertvector(other.v_, Vector)) {}
+
+  /// Loads size() elements from p.
+  fixed_size_simd(const T* _Nonnull p, element_aligned_tag) {
+    copy_from(p, element_aligned);
+  }
+
+  /// Loads size() elements from p.
+  void copy_from(const T* _Nonnull p, element_aligned_tag) {
+    // memcpy rather than a pointer cast, since p may not be aligned for the
+    // whole vector. Clang lowers this to an unaligned vector load.
+    __builtin_memcpy(&v_, p, sizeof(v_));
+  }
+
+  /// Stores size() elements to p.
+  void copy_to(T* _Nonnull p, element_aligned_tag) const {
+    __builtin_memcpy(p, &v_, sizeof(v_));
+  }
+
+  /// Returns the element at index i.
+  [[nodiscard]] T operator[](size_t i) const { return v_[i]; }
+
+  fixed_size_simd& operator+=(const fixed_size_simd& rhs) {
+    v_ += rhs.v_;
+    return *this;
+  }
+
+  fixed_size_simd& operator-=(const fixed_size_simd& rhs) {
+    v_ -= rhs.v_;
+    return *this;
+  }
+
+  fixed_size_simd& operator*=(const fixed_size_simd& rhs) {
+    v_ *= rhs.v_;
+    return *this;
+  }
+
+  fixed_size_simd& operator/=(const fixed_size_simd& rhs) {
+    v_ /= rhs.v_;
+    return *this;
+  }
+
+  [[nodiscard]] friend fixed_size_simd operator+(fixed_size_simd lhs,
+                                                 const fixed_size_simd& rhs) {
+    return lhs += rhs;
+  }
+
+  [[nodiscard]] friend fixed_size_simd operator-(fixed_size_simd lhs,
+                                                 const fixed_size_simd& rhs) {
+    return lhs -= rhs;
+  }
+
+  [[nodiscard]] friend fixed_size_simd operator*(fixed_size_simd lhs,
+                                                 const fixed_size_simd& rhs) {
+    return lhs *= rhs;
+  }
+
+  [[nodiscard]] friend fixed_size_simd operator/(fixed_size_simd lhs,
+                                                 const fixed_size_simd& rhs) {
+    return lhs /= rhs;
+  }
+
+  /**
+   * Computes a * b + c for each element with a single rounding.
+   *
+   * Like std::fma, this is exact even on hardware without fused multiply-add,
+   * where it is *much* slower than a * b + c. When the rounding doesn't
+   * matter, prefer a * b + c, which Clang fuses anyway where the hardware
+   * supports it.
+   */
+  [[nodiscard]] friend fixed_size_simd fma(const fixed_size_simd& a,
+                                           const fixed_size_simd& b,
+                                           const fixed_size_simd& c) {
+    fixed_size_simd result;
+    result.v_ = __builtin_elementwise_fma(a.v_, b.v_, c.v_);
+    return result;
+  }
+
+  /// Returns the sum of every element.
+  [[nodiscard]] friend T reduce(const fixed_size_simd& v) {
+    T sum = {};
+    for (size_t i = 0; i < N; i++) {
+      sum += v.v_[i];
+    }
+    return sum;
+  }
+
+ private:
+  template <typename U, size_t M>
+  friend class fixed_size_simd;
+
+  typedef T Vector __attribute__((__vector_size__(N * sizeof(T))));
+
+  Vector v_ = {};
+};
+
+/// The widest vector that every device of the ABI supports (128 bits for
+/// arm64 Neon and x86 SSE).
+template <typename T>
+using native_simd = fixed_size_simd<T, 16 / sizeof(T)>;
+
+}  // namespace samples::vectorization::simd
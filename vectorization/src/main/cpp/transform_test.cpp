@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+
+#include "gtest/gtest.h"
+#include "kernels_test.h"
+#include "matrix.h"
+#include "operands.h"
+
+namespace samples::vectorization {
+namespace {
+
+using TransformTest = KernelsTest;
+
+/// A transform that mixes every component, so that a kernel which swaps rows
+/// and columns or drops a term gets the wrong answer.
+Mat4<> Mixing() {
+  return Mat4<>{{
+      {1.0f, 2.0f, 0.0f, -1.0f},
+      {0.0f, -1.0f, 3.0f, 2.0f},
+      {2.0f, 0.0f, 1.0f, 1.0f},
+      {1.0f, 1.0f, -2.0f, 1.0f},
+  }};
+}
+
+/// Checks that each point of out is the matching point of in transformed by m.
+/// Every value is a small integer, so the results must be exact.
+void ExpectTransformed(const Mat4<>& m, PointSpan<const float> in,
+                       PointSpan<const float> out) {
+  ASSERT_EQ(in.size(), out.size());
+  for (size_t i = 0; i < in.size(); i++) {
+    const float point[] = {in.x[i], in.y[i], in.z[i], in.w[i]};
+    const float actual[] = {out.x[i], out.y[i], out.z[i], out.w[i]};
+    for (size_t row = 0; row < 4; row++) {
+      float expected = 0;
+      for (size_t column = 0; column < 4; column++) {
+        expected += m[row, column] * point[column];
+      }
+      ASSERT_EQ(actual[row], expected) << "row " << row << " at index " << i;
+    }
+  }
+}
+
+// The batch the benchmarks transform.
+TEST_P(TransformTest, Translation) {
+  constexpr size_t kBatchSize = 1024;
+  const Mat4<> translation = Translation();
+  PointBuffer input(kBatchSize);
+  InitPoints(input.view());
+  PointBuffer output(kBatchSize);
+
+  kernels().transform_points(translation, input.view(), output.view());
+
+  ExpectTransformed(translation, input.view(), output.view());
+}
+
+// Batches that aren't a multiple of any kernel's block or vector size, so
+// that every kernel's remainder handling is exercised.
+TEST_P(TransformTest, OddSizes) {
+  const Mat4<> m = Mixing();
+  for (size_t size : {0, 1, 3, 7, 9, 15, 17, 1001}) {
+    SCOPED_TRACE(size);
+    PointBuffer input(size);
+    InitPoints(input.view());
+    PointBuffer output(size);
+
+    kernels().transform_points(m, input.view(), output.view());
+
+    ExpectTransformed(m, input.view(), output.view());
+  }
+}
+
+// The parallel benchmarks give each thread a subspan of a batch, which needn't
+// be aligned. Points outside of the subspan must not be touched.
+TEST_P(TransformTest, Subspan) {
+  constexpr size_t kBatchSize = 100;
+  constexpr size_t kOffset = 3;
+  constexpr size_t kCount = 61;
+  const Mat4<> m = Mixing();
+  PointBuffer input(kBatchSize);
+  InitPoints(input.view());
+  PointBuffer output(kBatchSize);
+  InitPoints(output.view());
+
+  kernels().transform_points(m, input.view().subspan(kOffset, kCount),
+                             output.view().subspan(kOffset, kCount));
+
+  ExpectTransformed(m, input.view().subspan(kOffset, kCount),
+                    output.view().subspan(kOffset, kCount));
+  for (size_t i = 0; i < kBatchSize; i++) {
+    if (i < kOffset || i >= kOffset + kCount) {
+      ASSERT_EQ(output.view().x[i], input.view().x[i]) << "at index " << i;
+      ASSERT_EQ(output.view().y[i], input.view().y[i]) << "at index " << i;
+      ASSERT_EQ(output.view().z[i], input.view().z[i]) << "at index " << i;
+      ASSERT_EQ(output.view().w[i], input.view().w[i]) << "at index " << i;
+    }
+  }
+}
+
+// The output may be the same buffers as the input.
+TEST_P(TransformTest, InPlace) {
+  constexpr size_t kBatchSize = 37;
+  const Mat4<> m = Mixing();
+  PointBuffer expected(kBatchSize);
+  InitPoints(expected.view());
+  PointBuffer points(kBatchSize);
+  InitPoints(points.view());
+
+  kernels().transform_points(m, points.view(), points.view());
+
+  ExpectTransformed(m, expected.view(), points.view());
+}
+
+INSTANTIATE_KERNELS_TEST_SUITE(TransformTest);
+
+}  // namespace
+}  // namespace samples::vectorization
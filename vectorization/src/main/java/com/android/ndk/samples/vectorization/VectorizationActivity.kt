@@ -10,13 +10,15 @@ import androidx.compose.foundation.layout.Spacer
 import androidx.compose.foundation.layout.fillMaxSize
 import androidx.compose.foundation.layout.fillMaxWidth
 import androidx.compose.foundation.layout.padding
+import androidx.compose.foundation.lazy.LazyColumn
+import androidx.compose.foundation.lazy.itemsIndexed
 import androidx.compose.material3.Scaffold
 import androidx.compose.material3.Text
 import androidx.compose.runtime.Composable
 import androidx.compose.runtime.LaunchedEffect
-import androidx.compose.runtime.mutableStateMapOf
+import androidx.compose.runtime.mutableStateListOf
 import androidx.compose.runtime.remember
-import androidx.compose.runtime.snapshots.SnapshotStateMap
+import androidx.compose.runtime.snapshots.SnapshotStateList
 import androidx.compose.ui.Modifier
 import androidx.compose.ui.tooling.preview.Preview
 import com.android.ndk.samples.vectorization.ui.theme.NDKSamplesTheme
@@ -34,6 +36,167 @@ enum class Backend(val id: Int, val label: String) {
     OPEN_MP(4, "OpenMP"),
 }
 
+// Keep in sync with kSquareMatrixSizes in benchmark.h.
+val SQUARE_MATRIX_SIZES = listOf(16, 32, 64, 128, 256, 512)
+
+// Keep in sync with the definition in benchmark.h.
+enum class Precision(val id: Int, val label: String, val unit: String) {
+    FLOAT32(0, "f32", "GFLOP/s"),
+    FLOAT16(1, "f16", "GFLOP/s"),
+    INT8(2, "int8", "GOP/s"),
+}
+
+// The reduced precision benchmarks only use one size, since the error and the
+// relative throughput of each precision are similar for every size.
+const val PRECISION_MATRIX_SIZE = 256
+
+// Keep in sync with kTransformBatchSizes in benchmark.h.
+val TRANSFORM_BATCH_SIZES = listOf(1_024, 65_536, 1_048_576)
+
+// Keep in sync with the definition in benchmark.h.
+enum class MatrixOperation(val id: Int, val label: String) {
+    TRANSPOSE(0, "transpose"),
+    DETERMINANT(1, "determinant"),
+    INVERSE(2, "inverse"),
+}
+
+// Keep in sync with kMatrixOperationSizes in benchmark.h.
+val MATRIX_OPERATION_SIZES = listOf(3, 4)
+
+// Keep in sync with the definition in benchmark.h.
+enum class Evaluation(val id: Int, val label: String) {
+    EAGER(0, "Eager"),
+    FUSED(1, "Fused"),
+}
+
+// Keep in sync with the definition in parallel.h.
+enum class Threading(val id: Int, val label: String) {
+    OPEN_MP(0, "OpenMP"),
+    THREAD_POOL(1, "thread pool"),
+}
+
+// Keep in sync with the definition in benchmark.h.
+enum class Scaling(val id: Int, val label: String) {
+    STRONG(0, "Strong"),
+    WEAK(1, "Weak"),
+}
+
+// Keep in sync with kParallelSquareMatrixSize in benchmark.h.
+const val PARALLEL_SQUARE_MATRIX_SIZE = 512
+
+// Keep in sync with kParallelTransformBatchSize in benchmark.h.
+const val PARALLEL_TRANSFORM_BATCH_SIZE = 262_144
+
+// The parallel benchmarks only use one backend, since the backends scale the
+// same way and running all of them for every thread count would take minutes.
+val PARALLEL_BACKEND = Backend.CLANG_MATRICES
+
+/**
+ * A single row in the benchmark table.
+ *
+ * @property section The heading of the group this row is displayed in.
+ * @property label The name displayed for this row.
+ * @property run Runs the benchmark. Called on a background thread.
+ */
+class BenchmarkCase(
+    val section: String,
+    val label: String,
+    val run: () -> BenchmarkResult,
+)
+
+val BENCHMARK_CASES: List<BenchmarkCase> =
+    Backend.entries.map { backend ->
+        BenchmarkCase("Median time per multiply", backend.label) {
+            AppJni.benchmarkMatrixMultiply(backend)
+        }
+    } + SQUARE_MATRIX_SIZES.flatMap { size ->
+        Backend.entries.map { backend ->
+            BenchmarkCase("Multiply throughput, ${size}x$size", backend.label) {
+                AppJni.benchmarkSquareMatrixMultiply(backend, size)
+            }
+        }
+    } + Precision.entries.flatMap { precision ->
+        Backend.entries.map { backend ->
+            BenchmarkCase(
+                "Multiply throughput and max error, %dx%d, %s".format(
+                    PRECISION_MATRIX_SIZE,
+                    PRECISION_MATRIX_SIZE,
+                    precision.label
+                ),
+                backend.label
+            ) {
+                AppJni.benchmarkPrecisionSquareMatrixMultiply(
+                    backend,
+                    PRECISION_MATRIX_SIZE,
+                    precision
+                )
+            }
+        }
+    } + TRANSFORM_BATCH_SIZES.flatMap { batchSize ->
+        Backend.entries.map { backend ->
+            BenchmarkCase(
+                "Transform throughput, %,d vertices".format(batchSize),
+                backend.label
+            ) {
+                AppJni.benchmarkTransformPoints(backend, batchSize)
+            }
+        }
+    } + MatrixOperation.entries.flatMap { operation ->
+        MATRIX_OPERATION_SIZES.flatMap { size ->
+            Backend.entries.map { backend ->
+                BenchmarkCase(
+                    "Median time per ${size}x$size ${operation.label}",
+                    backend.label
+                ) {
+                    AppJni.benchmarkMatrixOperation(backend, operation, size)
+                }
+            }
+        }
+    } + Evaluation.entries.map { evaluation ->
+        BenchmarkCase("Median time per MVP vertex transform", evaluation.label) {
+            AppJni.benchmarkMvpTransform(evaluation)
+        }
+    } + Scaling.entries.flatMap { scaling ->
+        Threading.entries.flatMap { threading ->
+            val threadCounts = 1..Runtime.getRuntime().availableProcessors()
+            threadCounts.map { threads ->
+                BenchmarkCase(
+                    "%s scaling, %dx%d multiply, %s".format(
+                        scaling.label,
+                        PARALLEL_SQUARE_MATRIX_SIZE,
+                        PARALLEL_SQUARE_MATRIX_SIZE,
+                        threading.label
+                    ),
+                    "$threads threads"
+                ) {
+                    AppJni.benchmarkParallelSquareMatrixMultiply(
+                        PARALLEL_BACKEND,
+                        PARALLEL_SQUARE_MATRIX_SIZE,
+                        threading,
+                        scaling,
+                        threads
+                    )
+                }
+            } + threadCounts.map { threads ->
+                BenchmarkCase(
+                    "${scaling.label} scaling, %,d vertex transform, %s".format(
+                        PARALLEL_TRANSFORM_BATCH_SIZE,
+                        threading.label
+                    ),
+                    "$threads threads"
+                ) {
+                    AppJni.benchmarkParallelTransformPoints(
+                        PARALLEL_BACKEND,
+                        PARALLEL_TRANSFORM_BATCH_SIZE,
+                        threading,
+                        scaling,
+                        threads
+                    )
+                }
+            }
+        }
+    }
+
 class VectorizationActivity : ComponentActivity() {
     override fun onCreate(savedInstanceState: Bundle?) {
         super.onCreate(savedInstanceState)
@@ -46,8 +209,7 @@ class VectorizationActivity : ComponentActivity() {
                             .padding(innerPadding)
                             .fillMaxWidth()
                     ) {
-                        Text(text = "Average times for 10,000,000 runs")
-                        BenchmarkTable()
+                        BenchmarkTable(BENCHMARK_CASES)
                     }
                 }
             }
@@ -64,8 +226,46 @@ sealed interface BenchmarkResult {
         override fun toString(): String = duration.toString()
     }
 
+    class Nanoseconds(private val nanoseconds: Double) : BenchmarkResult {
+        override fun toString(): String = "%.2f ns".format(nanoseconds)
+    }
+
+    class Throughput(private val verticesPerSecond: Long) : BenchmarkResult {
+        override fun toString(): String =
+            "%.1f M vertices/s".format(verticesPerSecond / 1_000_000.0)
+    }
+
+    class Gflops(private val gflops: Double) : BenchmarkResult {
+        override fun toString(): String = "%.2f GFLOP/s".format(gflops)
+    }
+
+    class Accuracy(
+        private val throughput: Double,
+        private val unit: String,
+        private val maxError: Double,
+    ) : BenchmarkResult {
+        override fun toString(): String =
+            "%.2f %s, max error %.1e".format(throughput, unit, maxError)
+    }
+
     class Failure(private val message: String) : BenchmarkResult {
         override fun toString(): String = message
+
+        companion object {
+            fun fromErrorCode(code: Long): Failure = Failure(
+                when (code) {
+                    -1L -> "Not implemented"
+                    -2L -> "Not supported"
+                    -3L -> "Invalid backend"
+                    -4L -> "Invalid size"
+                    -5L -> "Invalid thread count"
+                    -6L -> "Invalid operation"
+                    -7L -> "Invalid precision"
+                    -8L -> "Invalid evaluation"
+                    else -> "Unknown error"
+                }
+            )
+        }
     }
 }
 
@@ -76,40 +276,186 @@ object AppJni {
             return BenchmarkResult.Success(result.nanoseconds)
         }
 
-        return BenchmarkResult.Failure(
-            when (result) {
-                -1L -> "Not implemented"
-                -2L -> "Not supported"
-                -3L -> "Invalid backend"
-                else -> "Unknown error"
-            }
+        return BenchmarkResult.Failure.fromErrorCode(result)
+    }
+
+    fun benchmarkSquareMatrixMultiply(
+        backend: Backend,
+        size: Int
+    ): BenchmarkResult {
+        val result = benchmarkSquareMatrixMultiply(backend.id, size)
+        if (result >= 0) {
+            return BenchmarkResult.Gflops(result)
+        }
+
+        return BenchmarkResult.Failure.fromErrorCode(result.toLong())
+    }
+
+    fun benchmarkPrecisionSquareMatrixMultiply(
+        backend: Backend,
+        size: Int,
+        precision: Precision
+    ): BenchmarkResult {
+        val result = benchmarkPrecisionSquareMatrixMultiply(
+            backend.id,
+            size,
+            precision.id
+        )
+        if (result.size == 2) {
+            return BenchmarkResult.Accuracy(result[0], precision.unit, result[1])
+        }
+
+        return BenchmarkResult.Failure.fromErrorCode(result[0].toLong())
+    }
+
+    fun benchmarkTransformPoints(
+        backend: Backend,
+        batchSize: Int
+    ): BenchmarkResult {
+        val result = benchmarkTransformPoints(backend.id, batchSize)
+        if (result >= 0) {
+            return BenchmarkResult.Throughput(result)
+        }
+
+        return BenchmarkResult.Failure.fromErrorCode(result)
+    }
+
+    fun benchmarkMatrixOperation(
+        backend: Backend,
+        operation: MatrixOperation,
+        size: Int
+    ): BenchmarkResult {
+        val result = benchmarkMatrixOperation(backend.id, operation.id, size)
+        if (result >= 0) {
+            return BenchmarkResult.Nanoseconds(result)
+        }
+
+        return BenchmarkResult.Failure.fromErrorCode(result.toLong())
+    }
+
+    fun benchmarkMvpTransform(evaluation: Evaluation): BenchmarkResult {
+        val result = benchmarkMvpTransform(evaluation.id)
+        if (result >= 0) {
+            return BenchmarkResult.Nanoseconds(result)
+        }
+
+        return BenchmarkResult.Failure.fromErrorCode(result.toLong())
+    }
+
+    fun benchmarkParallelSquareMatrixMultiply(
+        backend: Backend,
+        size: Int,
+        threading: Threading,
+        scaling: Scaling,
+        threads: Int
+    ): BenchmarkResult {
+        val result = benchmarkParallelSquareMatrixMultiply(
+            backend.id,
+            size,
+            threading.id,
+            scaling.id,
+            threads
+        )
+        if (result >= 0) {
+            return BenchmarkResult.Gflops(result)
+        }
+
+        return BenchmarkResult.Failure.fromErrorCode(result.toLong())
+    }
+
+    fun benchmarkParallelTransformPoints(
+        backend: Backend,
+        batchSize: Int,
+        threading: Threading,
+        scaling: Scaling,
+        threads: Int
+    ): BenchmarkResult {
+        val result = benchmarkParallelTransformPoints(
+            backend.id,
+            batchSize,
+            threading.id,
+            scaling.id,
+            threads
         )
+        if (result >= 0) {
+            return BenchmarkResult.Throughput(result)
+        }
+
+        return BenchmarkResult.Failure.fromErrorCode(result)
     }
 
     private external fun benchmarkMatrixMultiply(backend: Int): Long
+
+    private external fun benchmarkSquareMatrixMultiply(
+        backend: Int,
+        size: Int
+    ): Double
+
+    private external fun benchmarkPrecisionSquareMatrixMultiply(
+        backend: Int,
+        size: Int,
+        precision: Int
+    ): DoubleArray
+
+    private external fun benchmarkTransformPoints(
+        backend: Int,
+        batchSize: Int
+    ): Long
+
+    private external fun benchmarkMatrixOperation(
+        backend: Int,
+        operation: Int,
+        size: Int
+    ): Double
+
+    private external fun benchmarkMvpTransform(evaluation: Int): Double
+
+    private external fun benchmarkParallelSquareMatrixMultiply(
+        backend: Int,
+        size: Int,
+        threading: Int,
+        scaling: Int,
+        threads: Int
+    ): Double
+
+    private external fun benchmarkParallelTransformPoints(
+        backend: Int,
+        batchSize: Int,
+        threading: Int,
+        scaling: Int,
+        threads: Int
+    ): Long
 }
 
 @Composable
-fun BenchmarkTable(modifier: Modifier = Modifier) {
-    val status: SnapshotStateMap<Backend, String> = remember {
-        mutableStateMapOf(*Backend.entries.map { it to "Not started" }
-            .toTypedArray())
+fun BenchmarkTable(cases: List<BenchmarkCase>, modifier: Modifier = Modifier) {
+    val status: SnapshotStateList<String> = remember {
+        mutableStateListOf(*cases.map { "Not started" }.toTypedArray())
     }
 
+    // The benchmarks are run one at a time so they don't compete with each
+    // other for CPU time.
     LaunchedEffect(true) {
         withContext(Dispatchers.Default) {
-            Backend.entries.forEach {
-                status[it] = "Running..."
-                status[it] = AppJni.benchmarkMatrixMultiply(it).toString()
+            cases.forEachIndexed { index, case ->
+                status[index] = "Running..."
+                status[index] = case.run().toString()
             }
         }
     }
 
-    Column(
+    // There are far more results than fit on a screen, so only compose the
+    // rows that are visible.
+    LazyColumn(
         modifier = modifier
     ) {
-        status.toSortedMap().forEach { (backend, status) ->
-            BenchmarkResult(name = backend.label, duration = status)
+        itemsIndexed(cases) { index, case ->
+            Column {
+                if (index == 0 || cases[index - 1].section != case.section) {
+                    Text(text = case.section)
+                }
+                BenchmarkResult(name = case.label, duration = status[index])
+            }
         }
     }
 }